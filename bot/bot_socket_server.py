@@ -11,10 +11,21 @@ C server is the SINGLE SOURCE OF TRUTH for:
 - board state
 - move execution
 - FEN generation
+
+CONCURRENCY:
+- One thread per connection reads requests into a bounded queue
+- BOT_WORKERS threads take requests off the queue and answer them
+- "hard" moves borrow a warm Stockfish process from a pool
+  (STOCKFISH_ENGINES of them, started once)
+- When the queue is full (BOT_QUEUE_SIZE) the request is answered
+  "BUSY" at once instead of waiting behind the others
 """
 
+import os
+import queue
 import socket
 import sys
+import threading
 import chess
 import random
 
@@ -25,8 +36,77 @@ try:
 except ImportError:
     STOCKFISH_AVAILABLE = False
 
-HOST = "127.0.0.1"
-PORT = 5001
+HOST = os.environ.get("BOT_HOST", "127.0.0.1")
+PORT = int(os.environ.get("BOT_PORT", "5001"))
+
+WORKERS = int(os.environ.get("BOT_WORKERS", os.cpu_count() or 2))
+QUEUE_SIZE = int(os.environ.get("BOT_QUEUE_SIZE", "64"))
+STOCKFISH_PATH = os.environ.get("STOCKFISH_PATH", "stockfish")
+STOCKFISH_ENGINES = int(os.environ.get("STOCKFISH_ENGINES", WORKERS))
+STOCKFISH_MOVE_TIME = 0.2
+# How long a worker waits for a free engine before playing a random move
+STOCKFISH_WAIT = 5.0
+
+
+class EnginePool:
+    """
+    Long-lived Stockfish processes, started once and lent out one move at
+    a time. An engine that fails is replaced; if it cannot be restarted
+    the pool shrinks.
+    """
+
+    def __init__(self, size: int, path: str):
+        self.path = path
+        self.idle = queue.Queue()
+        self.lock = threading.Lock()
+        self.size = 0
+        for _ in range(size):
+            engine = self._start()
+            if engine is None:
+                break
+            self.idle.put(engine)
+            self.size += 1
+
+    def _start(self):
+        try:
+            return chess.engine.SimpleEngine.popen_uci(self.path)
+        except Exception as e:
+            print(f"[Bot] Cannot start Stockfish: {e}", file=sys.stderr)
+            return None
+
+    def play(self, board: chess.Board) -> chess.Move:
+        # Raises queue.Empty when no engine frees up in time
+        engine = self.idle.get(timeout=STOCKFISH_WAIT)
+        try:
+            result = engine.play(board, chess.engine.Limit(time=STOCKFISH_MOVE_TIME))
+            return result.move
+        except Exception:
+            try:
+                engine.close()
+            except Exception:
+                pass
+            engine = self._start()
+            if engine is None:
+                with self.lock:
+                    self.size -= 1
+            raise
+        finally:
+            if engine is not None:
+                self.idle.put(engine)
+
+    def close(self):
+        while True:
+            try:
+                engine = self.idle.get_nowait()
+            except queue.Empty:
+                return
+            try:
+                engine.quit()
+            except Exception:
+                pass
+
+
+engine_pool = None
 
 
 def calculate_bot_move(fen: str, difficulty: str = "easy") -> str:
@@ -50,13 +130,12 @@ def calculate_bot_move(fen: str, difficulty: str = "easy") -> str:
 
         # ===== HARD: Stockfish =====
         elif difficulty == "hard":
-            if STOCKFISH_AVAILABLE:
+            if engine_pool is not None and engine_pool.size > 0:
                 try:
-                    with chess.engine.SimpleEngine.popen_uci("stockfish") as engine:
-                        result = engine.play(
-                            board, chess.engine.Limit(time=0.2)
-                        )
-                        move = result.move
+                    move = engine_pool.play(board)
+                except queue.Empty:
+                    print("[Bot] No free Stockfish engine, using random", file=sys.stderr)
+                    move = random.choice(legal_moves)
                 except Exception as e:
                     print(f"[Bot] Stockfish error: {e}", file=sys.stderr)
                     move = random.choice(legal_moves)
@@ -78,40 +157,98 @@ def calculate_bot_move(fen: str, difficulty: str = "easy") -> str:
         return "ERROR"
 
 
-def handle_client(client_socket, addr):
+def parse_request(line: str):
     """
-    Protocol:
-        Request : "fen|difficulty\n"
-        Response: "bot_move\n"
+    "id|fen|difficulty" -> (id, fen, difficulty)
+    "fen|difficulty"    -> (None, fen, difficulty)   (one-shot clients)
+    "id" or "id|"       -> (id, None, ...)           (malformed, no FEN)
     """
-    print(f"[Bot] Connection from {addr}")
+    parts = line.split("|")
+    if parts[0].isdigit():
+        fen = parts[1] if len(parts) > 1 and parts[1] else None
+        return parts[0], fen, parts[2] if len(parts) > 2 else "easy"
+    return None, parts[0], parts[1] if len(parts) > 1 else "easy"
 
-    try:
-        data = client_socket.recv(4096).decode("utf-8").strip()
-        if not data:
-            print("[Bot] Empty request")
-            return
 
-        print(f"[Bot] Received: {data}")
+class Connection:
+    """
+    A client socket shared by its reader thread and the workers answering
+    its requests; replies go out whole, one at a time.
+    """
+
+    def __init__(self, sock: socket.socket):
+        self.sock = sock
+        self.send_lock = threading.Lock()
+
+    def reply(self, request_id, text: str):
+        response = f"{text}\n" if request_id is None else f"{request_id}|{text}\n"
+        with self.send_lock:
+            try:
+                self.sock.sendall(response.encode("utf-8"))
+            except OSError:
+                # Client went away while the move was computed
+                pass
+
+    def close(self):
+        with self.send_lock:
+            self.sock.close()
+
 
-        parts = data.split("|")
-        fen = parts[0]
-        difficulty = parts[1] if len(parts) > 1 else "easy"
+# (connection, request_id, fen, difficulty)
+requests = queue.Queue(maxsize=QUEUE_SIZE)
 
+
+def worker_loop():
+    while True:
+        conn, request_id, fen, difficulty = requests.get()
         bot_move = calculate_bot_move(fen, difficulty)
+        conn.reply(request_id, bot_move)
+        print(f"[Bot] Sent: {bot_move} (id {request_id})")
 
-        response = f"{bot_move}\n"
-        client_socket.sendall(response.encode("utf-8"))
-        print(f"[Bot] Sent: {bot_move}")
+
+def handle_client(client_socket, addr):
+    """
+    Protocol (one request per line, many per connection):
+        Request : "id|fen|difficulty\n"
+        Response: "id|bot_move\n"   bot_move may be "BUSY" (queue full)
+                                    or "ERROR" (malformed request)
+
+    Every reply carries the id of its request, errors included, so one bad
+    request fails alone and the connection stays up for the others.
+    Requests without an id ("fen|difficulty\n") get a bare "bot_move\n".
+    Replies come back in the order they are ready, not the order asked.
+    The connection stays open until the client closes it.
+    """
+    print(f"[Bot] Connection from {addr}")
+    conn = Connection(client_socket)
+
+    try:
+        reader = client_socket.makefile("r", encoding="utf-8", newline="\n")
+        for line in reader:
+            data = line.strip()
+            if not data:
+                continue
+
+            print(f"[Bot] Received: {data}")
+            request_id, fen, difficulty = parse_request(data)
+            if fen is None:
+                print(f"[Bot] Malformed request: {data}", file=sys.stderr)
+                conn.reply(request_id, "ERROR")
+                continue
+
+            try:
+                requests.put_nowait((conn, request_id, fen, difficulty))
+            except queue.Full:
+                print("[Bot] Queue full, shedding request", file=sys.stderr)
+                conn.reply(request_id, "BUSY")
 
     except Exception as e:
+        # The stream itself failed (reset, undecodable bytes): there is no
+        # request to answer; closing fails the client's pending calls
         print(f"[Bot] Client handling error: {e}", file=sys.stderr)
-        try:
-            client_socket.sendall(b"ERROR\n")
-        except:
-            pass
     finally:
-        client_socket.close()
+        conn.close()
+        print(f"[Bot] Connection from {addr} closed")
 
 
 def main():
@@ -119,19 +256,32 @@ def main():
     print("     Chess Bot Server (FINAL)")
     print("=" * 50)
     print(f"[Bot] Listening on {HOST}:{PORT}")
+    print(f"[Bot] {WORKERS} workers, queue of {QUEUE_SIZE}")
+
+    global engine_pool
+    if STOCKFISH_AVAILABLE and STOCKFISH_ENGINES > 0:
+        engine_pool = EnginePool(STOCKFISH_ENGINES, STOCKFISH_PATH)
+        print(f"[Bot] {engine_pool.size} Stockfish engines ready")
     print()
 
+    for _ in range(WORKERS):
+        threading.Thread(target=worker_loop, daemon=True).start()
+
     server_socket = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
     server_socket.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
 
     try:
         server_socket.bind((HOST, PORT))
-        server_socket.listen(5)
+        server_socket.listen(128)
         print("✅ Bot server ready\n")
 
         while True:
             client_socket, addr = server_socket.accept()
-            handle_client(client_socket, addr)
+            # Connections are long-lived; one thread each so a second
+            # client is not stuck behind the first
+            threading.Thread(
+                target=handle_client, args=(client_socket, addr), daemon=True
+            ).start()
 
     except KeyboardInterrupt:
         print("\n[Bot] Shutting down...")
@@ -139,6 +289,8 @@ def main():
         print(f"[Bot] Server error: {e}", file=sys.stderr)
     finally:
         server_socket.close()
+        if engine_pool is not None:
+            engine_pool.close()
         print("[Bot] Server stopped")
 
 
@@ -0,0 +1,110 @@
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+
+// One bit per square. Squares are numbered like ChessBoard.board[row][col]:
+// sq = row * 8 + col, so a8 = 0, h8 = 7, a1 = 56 and h1 = 63. "Up" for white
+// (towards rank 8) is therefore a shift right by 8.
+typedef uint64_t Bitboard;
+
+#define SQUARE(row, col)    ((row) * 8 + (col))
+#define SQUARE_ROW(sq)      ((sq) >> 3)
+#define SQUARE_COL(sq)      ((sq) & 7)
+#define SQUARE_BB(sq)       (1ULL << (sq))
+
+#define FILE_A_BB   0x0101010101010101ULL
+#define FILE_B_BB   (FILE_A_BB << 1)
+#define FILE_G_BB   (FILE_A_BB << 6)
+#define FILE_H_BB   (FILE_A_BB << 7)
+#define RANK_8_BB   0xFFULL                 // row 0
+#define RANK_1_BB   (RANK_8_BB << 56)       // row 7
+#define LIGHT_SQUARES_BB 0xAA55AA55AA55AA55ULL  // a8 and h1 are light
+
+// Piece kinds, in the order of ChessBoard.pieces (white block, then black)
+typedef enum {
+    PIECE_PAWN,
+    PIECE_KNIGHT,
+    PIECE_BISHOP,
+    PIECE_ROOK,
+    PIECE_QUEEN,
+    PIECE_KING,
+    PIECE_KINDS
+} PieceKind;
+
+#define BB_INDEX(color, kind)   ((color) * PIECE_KINDS + (kind))
+#define BB_PIECE_COUNT          (2 * PIECE_KINDS)
+
+static inline int bb_popcount(Bitboard bb) {
+    return __builtin_popcountll(bb);
+}
+
+// Index of the lowest set bit; bb must be non-zero
+static inline int bb_lsb(Bitboard bb) {
+    return __builtin_ctzll(bb);
+}
+
+// Index of the highest set bit; bb must be non-zero
+static inline int bb_msb(Bitboard bb) {
+    return 63 - __builtin_clzll(bb);
+}
+
+static inline int bb_pop_lsb(Bitboard *bb) {
+    int sq = __builtin_ctzll(*bb);
+    *bb &= *bb - 1;
+    return sq;
+}
+
+// Slider ray directions ("north" is towards rank 8, i.e. row 0)
+typedef enum {
+    RAY_NORTH,          // row - 1
+    RAY_SOUTH,          // row + 1
+    RAY_EAST,           // col + 1
+    RAY_WEST,           // col - 1
+    RAY_NORTH_EAST,
+    RAY_NORTH_WEST,
+    RAY_SOUTH_EAST,
+    RAY_SOUTH_WEST,
+    RAY_DIRECTIONS
+} RayDirection;
+
+// Along a "positive" ray square numbers increase, so the nearest blocker is
+// the lowest set bit; along the others it is the highest
+#define RAY_IS_POSITIVE(dir) \
+    ((dir) == RAY_SOUTH || (dir) == RAY_EAST || (dir) == RAY_SOUTH_EAST || (dir) == RAY_SOUTH_WEST)
+
+// Precomputed tables, generated into src/game/attack_tables.c by
+// scripts/gen_attack_tables.py. ray_table excludes the origin square.
+extern const Bitboard pawn_attack_table[2][64];
+extern const Bitboard knight_attack_table[64];
+extern const Bitboard king_attack_table[64];
+extern const Bitboard ray_table[RAY_DIRECTIONS][64];
+
+// Attack sets. color is 0 for white and 1 for black (PlayerColor order).
+static inline Bitboard pawn_attacks(int color, int sq) {
+    return pawn_attack_table[color][sq];
+}
+
+static inline Bitboard knight_attacks(int sq) {
+    return knight_attack_table[sq];
+}
+
+static inline Bitboard king_attacks(int sq) {
+    return king_attack_table[sq];
+}
+
+// Slider lookups need bitboard_init() to have run once (chess_board_init()
+// calls it; it is idempotent and thread-safe)
+Bitboard bishop_attacks(int sq, Bitboard occupied);
+Bitboard rook_attacks(int sq, Bitboard occupied);
+
+static inline Bitboard queen_attacks(int sq, Bitboard occupied) {
+    return bishop_attacks(sq, occupied) | rook_attacks(sq, occupied);
+}
+
+// Build the slider attack tables (magic or PEXT indexed)
+void bitboard_init(void);
+// "pext" or "magic"
+const char* bitboard_slider_backend(void);
+
+#endif // BITBOARD_H
@@ -2,6 +2,7 @@
 #define BOT_H
 
 #include "client_session.h"
+#include "game.h"
 #include <libpq-fe.h>
 #include <stddef.h>
 
@@ -9,6 +10,17 @@
  * Bot Module - Handles bot game initialization and moves
  */
 
+/**
+ * Start the engine pool that searches bot replies off the reactor threads.
+ * - threads: search threads (ENGINE_WORKERS, default one per core)
+ * - queue_size: searches that may wait (ENGINE_QUEUE_SIZE)
+ *
+ * Return:
+ *   0 = OK
+ *  -1 = no thread could be started
+ */
+int bot_init(int threads, int queue_size);
+
 void handle_mode_bot(
     ClientSession *session,
     char *user_id,
@@ -16,6 +28,13 @@ void handle_mode_bot(
     PGconn *db
 );
 
+/**
+ * Play the player's move and queue the bot's reply on the engine pool.
+ * The player gets BOT_MOVE_ACCEPTED|fen|move at once and
+ * BOT_MOVE_RESULT|fen|bot_move|status once the reply has been played.
+ * With the engine queue full the move is taken back and the player gets
+ * ERROR|Server busy; the search never runs on the calling thread.
+ */
 void handle_bot_move(
     ClientSession *session,
     int num_params,
@@ -26,14 +45,16 @@ void handle_bot_move(
 );
 
 /**
- * Call python chess bot.
+ * Call python chess bot (bot/bot_socket_server.py) over a small pool of
+ * keep-alive connections (src/bot/python_bot.c). BOT_HOST, BOT_PORT,
+ * BOT_CONNECTIONS and BOT_TIMEOUT_MS are read on the first call.
  * - fen: current board position (SOURCE OF TRUTH)
  * - difficulty: bot difficulty
  * - bot_move_out: output UCI move (e2e4, g8f6, ...)
  *
  * Return:
  *   0 = OK
- *  -1 = error
+ *  -1 = error (no connection, or no answer within BOT_TIMEOUT_MS)
  */
 int call_python_bot(
     const char *fen,
@@ -42,4 +63,24 @@ int call_python_bot(
     size_t bot_move_size
 );
 
+/**
+ * Search a move with the in-process engine (src/engine). This is the
+ * default; BOT_ENGINE=python sends bot moves to call_python_bot() instead,
+ * and comes back here when the bot server is busy or unreachable.
+ * - board: current position, not modified
+ * - history: the game's repetition table, so the bot avoids or seeks draws
+ * - bot_move_out: output UCI move, or "NOMOVE" if there is none
+ *
+ * Return:
+ *   0 = OK
+ *  -1 = error
+ */
+int call_native_bot(
+    const ChessBoard *board,
+    const RepetitionTable *history,
+    const char *difficulty,
+    char *bot_move_out,
+    size_t bot_move_size
+);
+
 #endif // BOT_H
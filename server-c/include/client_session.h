@@ -1,20 +1,81 @@
 #ifndef CLIENT_SESSION_H
 #define CLIENT_SESSION_H
 
+#include <stddef.h>
+#include <sys/types.h>
+#include <libpq-fe.h>
+
 // Forward declaration to avoid circular include
 struct GameMatch;
 
-// Client session structure
+#define SESSION_INPUT_BUFFER_SIZE 8192
+
+// Per-connection receive buffer. Bytes are appended at `end` and complete
+// lines are consumed from `start`; the unconsumed tail is moved back to the
+// front only when it runs out of room, so every line stays contiguous and
+// can be handed to the protocol layer in place.
+typedef struct {
+    char data[SESSION_INPUT_BUFFER_SIZE];
+    size_t start;
+    size_t end;
+    int discarding;     // Dropping an over-long line until its newline arrives
+} InputBuffer;
+
+// Per-connection send queue. Whatever the socket does not accept right away
+// is kept here and flushed by the owning reactor when the socket becomes
+// writable again. Guarded by the session's output lock (see client_session.c).
 typedef struct {
+    char *data;
+    size_t start;
+    size_t end;
+    size_t capacity;
+    int failed;         // Write error or backlog over the hard limit; drop further output
+} OutputBuffer;
+
+// Client session structure
+typedef struct ClientSession {
     int socket_fd;
     int user_id;
     char username[64];
-    struct GameMatch *current_match;
+    int current_match_id;                   // 0 when none; see client_session_acquire_match()
+    InputBuffer input;
+    OutputBuffer output;
+    int shard_id;                           // Reactor shard serving this connection
+    int job_pending;                        // A command is running on a DB worker
+    int closing;                            // Peer gone; close once the job finishes
+    unsigned watch_events;                  // Interest registered with the shard's event loop
+    struct ClientSession *handoff_next;     // Link while queued for another shard
 } ClientSession;
 
 // Session management functions
 ClientSession* client_session_create(int socket_fd);
 void client_session_destroy(ClientSession *session);
-void client_session_handle_disconnect(ClientSession *session);
+void client_session_handle_disconnect(ClientSession *session, PGconn *db);
+
+// The current match is assigned from whichever thread pairs the players
+// (matchmaking runs on the joining client's shard), so it is read and
+// written only under the session's lock. The session keeps the match id,
+// not the match: once the manager drops a finished match the session is
+// simply no longer in one. The acquired match is pinned; release it with
+// game_match_release().
+struct GameMatch* client_session_acquire_match(ClientSession *session);
+void client_session_set_match(ClientSession *session, struct GameMatch *match);
+
+// Input framing
+ssize_t client_session_fill(ClientSession *session);
+char* client_session_next_line(ClientSession *session);
+int client_session_input_full(const ClientSession *session);
+
+// Output queueing. send_to_client() never blocks: it writes what the socket
+// accepts and queues the rest; a client whose backlog passes the hard limit
+// is shut down. Returns 0 when sent or queued, -1 when the message was dropped.
+int send_to_client(int socket_fd, const char *message);
+int client_session_flush_output(ClientSession *session);
+int client_session_output_backlogged(ClientSession *session);
+size_t client_session_output_pending(ClientSession *session);
+void client_session_set_output_limits(size_t soft_limit, size_t hard_limit);
+// Called (with the session's output lock held) when a session's queue goes
+// from empty to non-empty, so its reactor can start watching for writability
+void client_session_set_output_notify(void (*notify)(int socket_fd));
 
 #endif // CLIENT_SESSION_H
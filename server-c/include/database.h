@@ -8,6 +8,13 @@ PGconn* db_connect();
 void db_disconnect(PGconn *conn);
 int db_check_connection(PGconn *conn);
 
+// Timed PQexec / PQexecParams; use these instead of calling libpq directly
+PGresult* db_exec(PGconn *conn, const char *query);
+PGresult* db_exec_params(PGconn *conn, const char *command, int n_params,
+                         const Oid *param_types, const char *const *param_values,
+                         const int *param_lengths, const int *param_formats,
+                         int result_format);
+
 // ==================== MATCHES ====================
 int db_create_match(PGconn *conn, int user1_id, int user2_id, const char *type);
 int db_create_bot_match(PGconn *conn, int user_id, const char *type);
@@ -0,0 +1,60 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include "game.h"
+
+// Native bot engine: iterative-deepening alpha-beta (principal variation
+// search) with a quiescence search over captures, a transposition table and
+// move ordering by TT move, MVV-LVA, killers and history. It plays on the
+// server's own ChessBoard with the server's move generator, so a bot reply
+// needs no FEN round trip and no other process.
+
+#define ENGINE_MAX_PLY 64
+#define ENGINE_MATE 30000           // Mate in n plies scores ENGINE_MATE - n
+
+// Search budget; the search stops at the first limit reached. Depth 1 is
+// always completed so there is always a move to play, unless *stop is set:
+// that ends the search at once and the move is not meant to be played.
+typedef struct {
+    int depth;
+    unsigned long nodes;
+    int time_ms;
+    int noise;                      // Random bonus of up to this many centipawns per root move
+    const int *stop;                // Polled during the search (may be NULL)
+} EngineLimits;
+
+typedef struct {
+    Move best_move;
+    int score;                      // Centipawns for the side to move
+    int depth;                      // Deepest completed iteration
+    unsigned long nodes;
+    int time_ms;
+} EngineResult;
+
+// One searcher: transposition table plus ordering state. Not thread-safe;
+// give every thread that searches its own engine.
+typedef struct Engine Engine;
+
+// tt_mb: transposition table size in MiB
+Engine* engine_create(int tt_mb);
+void engine_destroy(Engine *engine);
+
+// Budget for a bot difficulty: "easy", "medium" or "hard". Unknown names
+// play as easy, like the Python bot did.
+void engine_limits_for_difficulty(const char *difficulty, EngineLimits *limits);
+
+// Find a move for the side to move. history (may be NULL) holds the game's
+// positions since the last irreversible move; the search scores a return
+// to any of them as a draw. board is not modified.
+// Returns 0 with result filled in, -1 if there is no legal move.
+int engine_search(Engine *engine, const ChessBoard *board, const RepetitionTable *history,
+                  const EngineLimits *limits, EngineResult *result);
+
+// Static evaluation in centipawns from the side to move's point of view
+int engine_evaluate(const ChessBoard *board);
+extern const int engine_piece_value[PIECE_KINDS];
+
+// Long algebraic (UCI) text of a move: "e2e4", "e7e8q"
+void engine_move_to_uci(const Move *move, char *out);
+
+#endif // ENGINE_H
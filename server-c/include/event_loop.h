@@ -0,0 +1,78 @@
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stddef.h>
+
+// Readiness interest / result bits
+#define LOOP_READ   0x1
+#define LOOP_WRITE  0x2
+#define LOOP_HUP    0x4     // Peer hung up or the descriptor failed (always reported)
+#define LOOP_ACCEPT 0x8     // fd is a connection the backend accepted on a listener
+
+typedef struct {
+    int fd;
+    unsigned events;
+} LoopEvent;
+
+struct EventLoop;
+
+// One readiness backend. Interest is level-style: a descriptor is reported
+// while it is ready for something in its mask, so callers drain sockets until
+// EAGAIN and drop LOOP_READ / LOOP_WRITE from the mask while they cannot act.
+typedef struct {
+    const char *name;
+    int (*create)(struct EventLoop *loop, int max_fds);
+    void (*destroy)(struct EventLoop *loop);
+    int (*add)(struct EventLoop *loop, int fd, unsigned events);
+    int (*modify)(struct EventLoop *loop, int fd, unsigned events);
+    int (*remove)(struct EventLoop *loop, int fd);
+    // Returns the number of events stored, 0 on timeout, -1 with errno set
+    int (*wait)(struct EventLoop *loop, LoopEvent *events, int max_events, int timeout_ms);
+    // Optional: accept on a listening socket in the backend. Each new
+    // connection comes back as its own LOOP_ACCEPT event carrying the
+    // accepted descriptor, so no accept() call is left to the caller.
+    int (*add_listener)(struct EventLoop *loop, int listen_fd);
+} EventLoopOps;
+
+typedef struct EventLoop {
+    const EventLoopOps *ops;
+    void *impl;
+} EventLoop;
+
+extern const EventLoopOps epoll_loop_ops;
+extern const EventLoopOps poll_loop_ops;
+extern const EventLoopOps uring_loop_ops;
+
+// Backend named by REACTOR_BACKEND (epoll, poll, io_uring); epoll by default
+const EventLoopOps* event_loop_backend(void);
+
+// Create a loop on the given backend, falling back to epoll if it is unavailable
+int event_loop_init(EventLoop *loop, const EventLoopOps *ops, int max_fds);
+void event_loop_destroy(EventLoop *loop);
+
+static inline int event_loop_add(EventLoop *loop, int fd, unsigned events) {
+    return loop->ops->add(loop, fd, events);
+}
+
+// Watch a listening socket. Backends without add_listener report it
+// LOOP_READ and the caller accepts until EAGAIN.
+static inline int event_loop_add_listener(EventLoop *loop, int listen_fd) {
+    if (loop->ops->add_listener != NULL) {
+        return loop->ops->add_listener(loop, listen_fd);
+    }
+    return loop->ops->add(loop, listen_fd, LOOP_READ);
+}
+
+static inline int event_loop_modify(EventLoop *loop, int fd, unsigned events) {
+    return loop->ops->modify(loop, fd, events);
+}
+
+static inline int event_loop_remove(EventLoop *loop, int fd) {
+    return loop->ops->remove(loop, fd);
+}
+
+static inline int event_loop_wait(EventLoop *loop, LoopEvent *events, int max_events, int timeout_ms) {
+    return loop->ops->wait(loop, events, max_events, timeout_ms);
+}
+
+#endif // EVENT_LOOP_H
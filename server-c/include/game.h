@@ -8,6 +8,9 @@
 #include <pthread.h>
 #include <libpq-fe.h>
 #include "timer.h"
+#include "client_session.h"
+#include "bitboard.h"
+#include "zobrist.h"
 
 #define BOARD_SIZE 8
 #define FEN_MAX_LENGTH 256
@@ -52,6 +55,18 @@ typedef enum {
     RESULT_BLACK_TIMEOUT
 } GameResult;
 
+// What the position after a move means for the game, in order of precedence
+typedef enum {
+    POSITION_ONGOING,
+    POSITION_NO_WHITE_KING,         // Corrupt board: black wins
+    POSITION_NO_BLACK_KING,         // Corrupt board: white wins
+    POSITION_CHECKMATE,             // Side to move is mated
+    POSITION_STALEMATE,
+    POSITION_THREEFOLD_REPETITION,
+    POSITION_FIFTY_MOVE_RULE,
+    POSITION_INSUFFICIENT_MATERIAL
+} PositionState;
+
 // Player color
 typedef enum {
     COLOR_WHITE,
@@ -72,10 +87,29 @@ typedef struct {
     char promotion_piece;
 } Move;
 
+// State make_move() overwrites, enough for unmake_move() to restore the board
+typedef struct {
+    char captured_piece;        // Piece that stood on the target square
+    unsigned char castling;     // Castling rights: bit 0 K, 1 Q, 2 k, 3 q
+    signed char en_passant_file;
+    signed char en_passant_rank;
+    int halfmove_clock;
+    ZobristKey hash;
+} MoveUndo;
+
+// Upper bound on moves in any reachable position is 218
+#define MAX_MOVES 256
+
+typedef struct {
+    Move moves[MAX_MOVES];
+    int count;
+} MoveList;
+
 // Chess board structure
 typedef struct {
     char board[BOARD_SIZE][BOARD_SIZE];
-    char fen[FEN_MAX_LENGTH];
+    char fen[FEN_MAX_LENGTH];   // Cached; read through chess_board_get_fen()
+    int fen_dirty;              // fen is stale (set by make/unmake_move)
     PlayerColor current_turn;
     int move_count;
     int halfmove_clock;
@@ -95,6 +129,14 @@ typedef struct {
     int white_king_col;
     int black_king_row;
     int black_king_col;
+
+    // Bitboards, kept in step with board[][] by set_piece_at()
+    Bitboard pieces[BB_PIECE_COUNT];    // BB_INDEX(color, kind)
+    Bitboard occupied_by[2];            // Per PlayerColor
+    Bitboard occupied;
+
+    // Zobrist key of the position, updated by set_piece_at() and make_move()
+    ZobristKey hash;
 } ChessBoard;
 
 // Player info
@@ -122,7 +164,15 @@ typedef struct GameMatch {
     int rematch_requester_id;   // ID người xin rematch
 
     pthread_mutex_t lock;
+    int refs;               // Manager's while listed + one per acquire; atomic
     char bot_difficulty[16]; // Difficulty for bot games ("easy", "hard", etc.)
+
+    // Positions since the last pawn move or capture, for threefold repetition
+    RepetitionTable repetitions;
+    int position_repeats;       // Occurrences of the current position
+
+    // Stop flag of the bot search in flight for this match, NULL if none
+    int *bot_search_cancel;
 } GameMatch;
 
 // Game manager
@@ -136,12 +186,28 @@ typedef struct {
 // ============ CHESS BOARD FUNCTIONS ============
 void chess_board_init(ChessBoard *board);
 void chess_board_copy(ChessBoard *dest, ChessBoard *src);
-void chess_board_to_fen(ChessBoard *board, char *fen);
+void chess_board_to_fen(const ChessBoard *board, char *fen);
+// FEN of the current position, formatted only if the board changed since
+// the last call. Not thread-safe: hold the match lock.
+const char* chess_board_get_fen(ChessBoard *board);
+// Set up a board from a FEN. Rejects malformed or impossible positions and
+// reads the legacy en passant rank written by older servers. Returns 0, or
+// -1 with the board left untouched.
+int chess_board_from_fen(ChessBoard *board, const char *fen);
 void chess_board_print(ChessBoard *board);
+// Rebuild the bitboards and hash from board[][] (after filling it directly)
+void chess_board_sync_bitboards(ChessBoard *board);
+// Castling rights as bits: K=1 Q=2 k=4 q=8
+int chess_board_castling_rights(const ChessBoard *board);
+// Hash of everything but the pieces: castling, en passant and side to move
+ZobristKey chess_board_state_key(const ChessBoard *board);
 
 // ============ MOVE VALIDATION ============
 int validate_move(ChessBoard *board, Move *move, PlayerColor player_color);
 int is_square_attacked(ChessBoard *board, int row, int col, PlayerColor attacker_color);
+// Pieces of attacker_color that attack sq, with sliders seeing through
+// everything not in occupied
+Bitboard attackers_to(const ChessBoard *board, int sq, PlayerColor attacker_color, Bitboard occupied);
 int is_king_in_check(ChessBoard *board, PlayerColor king_color);
 int validate_pawn_move(ChessBoard *board, Move *move);
 int validate_knight_move(ChessBoard *board, Move *move);
@@ -150,8 +216,21 @@ int validate_rook_move(ChessBoard *board, Move *move);
 int validate_queen_move(ChessBoard *board, Move *move);
 int validate_king_move(ChessBoard *board, Move *move);
 
+// ============ MOVE GENERATION ============
+// Moves by the piece rules; may leave the mover's own king in check
+int generate_pseudo_legal_moves(ChessBoard *board, PlayerColor color, MoveList *list);
+// Pseudo-legal moves filtered down to those that keep the king safe.
+// Promotions are listed once per piece (Q, R, B, N).
+int generate_legal_moves(ChessBoard *board, PlayerColor color, MoveList *list);
+int is_move_legal(ChessBoard *board, const Move *move, PlayerColor color);
+
 // ============ MOVE EXECUTION ============
+// Play a move that is kept (always succeeds, returns 1)
 int execute_move(ChessBoard *board, Move *move);
+// Play / take back a move in place; for search and legality tests. The move
+// must come from validate_move() or the generator.
+void make_move(ChessBoard *board, const Move *move, MoveUndo *undo);
+void unmake_move(ChessBoard *board, const Move *move, const MoveUndo *undo);
 int is_path_clear(ChessBoard *board, int from_row, int from_col, int to_row, int to_col);
 
 // ============ GAME STATE DETECTION ============
@@ -159,6 +238,11 @@ int is_checkmate(ChessBoard *board, PlayerColor player_color);
 int is_stalemate(ChessBoard *board, PlayerColor player_color);
 int has_legal_moves(ChessBoard *board, PlayerColor player_color);
 int is_insufficient_material(const ChessBoard *board);
+// Everything the end-of-move check needs, with one check test and at most
+// one (early-exit) move scan. repetitions is how often the position occurred.
+PositionState classify_position(ChessBoard *board, int repetitions);
+// Reason string used in GAME_END messages ("checkmate", "stalemate", ...)
+const char* position_state_reason(PositionState state);
 
 // ============ UTILITY FUNCTIONS ============
 void notation_to_coords(const char *notation, int *row, int *col);
@@ -168,13 +252,19 @@ void set_piece_at(ChessBoard *board, int row, int col, char piece);
 int is_white_piece(char piece);
 int is_black_piece(char piece);
 PlayerColor get_piece_color(char piece);
+// Bitboard slot of a piece character (BB_INDEX), -1 for EMPTY
+int piece_bb_index(char piece);
 
 // ============ GAME MANAGER ============
 void game_manager_init(GameManager *manager);
 GameMatch* game_manager_create_match(GameManager *manager, Player white, Player black, PGconn *db);
 GameMatch* game_manager_create_bot_match(GameManager *manager, Player white, Player black, PGconn *db, const char *difficulty);
-GameMatch* game_manager_find_match(GameManager *manager, int match_id);
-GameMatch* game_manager_find_match_by_player(GameManager *manager, int socket_fd);
+// Look a match up and pin it: it stays allocated, even if the manager drops
+// it meanwhile, until the caller's game_match_release(), made after unlocking
+// match->lock. NULL if not found.
+GameMatch* game_manager_acquire_match(GameManager *manager, int match_id);
+GameMatch* game_manager_acquire_match_by_player(GameManager *manager, int socket_fd);
+void game_match_release(GameMatch *match);
 void game_manager_remove_match(GameManager *manager, int match_id);
 void game_manager_cleanup_finished_matches(GameManager *manager);
 void game_manager_force_cleanup_stale_matches(GameManager *manager);
@@ -182,6 +272,13 @@ int board_has_king(ChessBoard *board, PlayerColor color);
 
 
 // ============ GAME MATCH ============
+// Set up the starting position and reset the repetition history
+void game_match_init_board(GameMatch *match);
+// Call after every executed move
+void game_match_record_position(GameMatch *match);
+// Stop and disown the bot search in flight, if any; its reply is dropped.
+// Call with match->lock held.
+void game_match_cancel_bot_search(GameMatch *match);
 int game_match_make_move(GameMatch *match, int player_socket_fd, int player_id, const char *from, const char *to, PGconn *db);
 int game_match_check_end_condition(GameMatch *match, PGconn *db);
 void game_match_handle_surrender(GameMatch *match, int player_socket_fd, PGconn *db);
@@ -191,7 +288,6 @@ void force_black_win(GameMatch *match, PGconn *db);
 
 
 // ============ NETWORK ============
-void send_to_client(int socket_fd, const char *message);
 void broadcast_to_match(GameMatch *match, const char *message, int exclude_fd);
 
 #endif
@@ -0,0 +1,41 @@
+#ifndef LOG_H
+#define LOG_H
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_WARN  2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_OFF   4
+
+// Levels below this are compiled out entirely (-DLOG_COMPILE_LEVEL=...)
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+// Runtime threshold, set from LOG_LEVEL (debug, info, warn, error, off)
+extern int log_runtime_level;
+
+// Start the background writer; until then messages are written directly
+void log_init(void);
+// Block until everything logged so far has been written out
+void log_flush(void);
+
+void log_write(int level, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+// The level check happens before any argument is evaluated or formatted, so
+// a disabled message costs one load and a branch
+#define LOG_AT(level, ...) \
+    do { \
+        if ((level) >= LOG_COMPILE_LEVEL && (level) >= log_runtime_level) { \
+            log_write((level), __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define LOG_DEBUG(...) LOG_AT(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#define LOG_INFO(...)  LOG_AT(LOG_LEVEL_INFO, __VA_ARGS__)
+#define LOG_WARN(...)  LOG_AT(LOG_LEVEL_WARN, __VA_ARGS__)
+#define LOG_ERROR(...) LOG_AT(LOG_LEVEL_ERROR, __VA_ARGS__)
+
+#define LOG_ENABLED(level) ((level) >= LOG_COMPILE_LEVEL && (level) >= log_runtime_level)
+
+#endif // LOG_H
@@ -5,8 +5,44 @@
 #include "client_session.h"
 #include <libpq-fe.h>
 
-// Main protocol parser (only public interface)
-void protocol_handle_command(ClientSession *session, const char *buffer, PGconn *db);
+#define PROTOCOL_MAX_ARGS 16
+
+// Fields of one command line, pointing into the caller's buffer (the '|'
+// separators are overwritten with NULs). Missing fields read as "", and
+// the first empty field ends the list: argc counts only the fields before it.
+typedef struct {
+    int argc;
+    char *argv[PROTOCOL_MAX_ARGS];
+    size_t len[PROTOCOL_MAX_ARGS];
+} ProtocolArgs;
+
+typedef void (*protocol_command_fn)(ClientSession *session, ProtocolArgs *args, PGconn *db);
+
+// Handler is dominated by database queries; the reactor runs it on the DB
+// worker pool instead of its own thread
+#define PROTOCOL_DB 0x1
+
+typedef struct {
+    const char *name;
+    size_t name_len;
+    protocol_command_fn handler;
+    int min_args;           // Including the command itself
+    unsigned flags;
+} ProtocolCommand;
+
+// Build the command lookup table; call once before handling commands
+int protocol_init(void);
+
+// Command named by the first field of a line, or NULL when unknown
+const ProtocolCommand* protocol_find_command(const char *line);
+
+// Tokenize the line in place and run the command (cmd may be NULL)
+void protocol_execute(ClientSession *session, const ProtocolCommand *cmd, char *line, PGconn *db);
+
+// Lookup + execute in one call
+void protocol_handle_command(ClientSession *session, char *line, PGconn *db);
+
+int protocol_tokenize(char *line, ProtocolArgs *args);
 
 // Handler modules (imported by protocol_handler.c)
 // - match.h: handle_start_match, handle_join_match, handle_get_match_status, handle_move, handle_surrender
@@ -4,12 +4,17 @@
 #include <libpq-fe.h>
 
 #define PORT 8888
-#define MAX_CLIENTS 100
+#define MAX_CLIENTS 4096   // Size of the fd-indexed session table
+#define MAX_REACTOR_THREADS 64
 
 // Server initialization and lifecycle
 int server_init(PGconn **db_conn);
 void server_start();
 void server_shutdown();
+// Make server_start() return; safe to call from a signal handler. Shard 0
+// (the thread that called server_start()) notices within one wait timeout.
+void server_request_stop(void);
+int server_stop_requested(void);
 
 // Client handling
 void* client_handler(void *arg);
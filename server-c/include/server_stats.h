@@ -0,0 +1,54 @@
+#ifndef SERVER_STATS_H
+#define SERVER_STATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Log-linear latency histogram (HDR style): values below 32 ns get a bucket
+// each, every power of two above that is split into 16 equal buckets, so a
+// reported percentile is within ~6% of the true value. Values are in
+// nanoseconds and clamp at 2^40 (~18 minutes).
+#define HISTOGRAM_SUB_BUCKETS 32
+#define HISTOGRAM_MAX_BITS 40
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_MAX_BITS - 3) * (HISTOGRAM_SUB_BUCKETS / 2))
+
+typedef struct {
+    uint64_t counts[HISTOGRAM_BUCKETS];
+    uint64_t total_count;
+    uint64_t max;
+} LatencyHistogram;
+
+// Lock-free; safe to call from any thread
+void latency_histogram_record(LatencyHistogram *hist, uint64_t value_ns);
+// Upper bound of the bucket holding the given percentile (0 when empty)
+uint64_t latency_histogram_percentile(const LatencyHistogram *hist, double percentile);
+
+// Per-command timings, indexed by the command's position in the protocol table
+#define SERVER_STATS_MAX_COMMANDS 64
+
+typedef struct {
+    LatencyHistogram total;     // Whole handler
+    LatencyHistogram db;        // Time spent inside db_exec()/db_exec_params()
+    LatencyHistogram other;     // Total minus DB time
+} CommandStats;
+
+void server_stats_init(void);
+uint64_t server_stats_now_ns(void);
+long server_stats_uptime(void);
+
+void server_stats_record_command(int command_index, uint64_t total_ns, uint64_t db_ns);
+const CommandStats* server_stats_command(int command_index);
+
+// Database time accumulated by the calling thread; the take call resets it
+void server_stats_add_db_time(uint64_t ns);
+uint64_t server_stats_take_db_time(void);
+
+// Connected sessions across all reactor shards
+void server_stats_session_opened(void);
+void server_stats_session_closed(void);
+int server_stats_sessions(void);
+
+// SERVER_STATS is refused unless SERVER_STATS_TOKEN is set and matches
+int server_stats_authorized(const char *token);
+
+#endif // SERVER_STATS_H
@@ -0,0 +1,44 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <pthread.h>
+
+#define MAX_POOL_WORKERS 64
+
+// Job body: runs on a worker thread with that thread's private context
+typedef void (*worker_job_fn)(void *job_arg, void *thread_ctx);
+// Per-thread context setup/teardown (e.g. one database connection per worker)
+typedef void* (*worker_thread_init_fn)(int worker_index);
+typedef void (*worker_thread_exit_fn)(void *thread_ctx);
+
+typedef struct WorkerJob {
+    worker_job_fn fn;
+    void *arg;
+    struct WorkerJob *next;
+} WorkerJob;
+
+// Fixed set of threads draining a bounded FIFO job queue
+typedef struct {
+    const char *name;
+    pthread_t threads[MAX_POOL_WORKERS];
+    int thread_count;
+
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    WorkerJob *head;
+    WorkerJob *tail;
+    int queued;
+    int capacity;
+    int stopping;
+
+    worker_thread_init_fn thread_init;
+    worker_thread_exit_fn thread_exit;
+} WorkerPool;
+
+int worker_pool_init(WorkerPool *pool, const char *name, int threads, int capacity,
+                     worker_thread_init_fn thread_init, worker_thread_exit_fn thread_exit);
+// Returns 0 when queued, -1 when the queue is full or the pool is stopping
+int worker_pool_submit(WorkerPool *pool, worker_job_fn fn, void *arg);
+void worker_pool_shutdown(WorkerPool *pool);
+
+#endif // WORKER_POOL_H
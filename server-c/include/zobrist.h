@@ -0,0 +1,38 @@
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+#include <stdint.h>
+#include "bitboard.h"
+
+// Zobrist position keys: the XOR of one random key per (piece, square), one
+// for the castling rights, one for a capturable en passant file and one when
+// black is to move. ChessBoard.hash is kept up to date incrementally, so two
+// boards with the same key hold the same position (up to hash collisions).
+typedef uint64_t ZobristKey;
+
+extern ZobristKey zobrist_piece[BB_PIECE_COUNT][64];   // [BB_INDEX(color, kind)][sq]
+extern ZobristKey zobrist_castling[16];                // Castling bits: K=1 Q=2 k=4 q=8
+extern ZobristKey zobrist_en_passant[8];               // Per file
+extern ZobristKey zobrist_black_to_move;
+
+// Fill the key tables (fixed seed, so keys are the same on every start).
+// Idempotent and thread-safe; chess_board_init() calls it.
+void zobrist_init(void);
+
+// Counts of the positions seen since the last irreversible move (pawn move
+// or capture). At most 100 half-moves can pass before the 50-move rule ends
+// the game, so the table never holds more than 101 keys.
+#define REPETITION_SLOTS 256
+
+typedef struct {
+    ZobristKey keys[REPETITION_SLOTS];
+    unsigned char counts[REPETITION_SLOTS];    // 0 = empty slot
+} RepetitionTable;
+
+void repetition_table_clear(RepetitionTable *table);
+// Record one more occurrence of key and return how often it has been seen
+int repetition_table_add(RepetitionTable *table, ZobristKey key);
+// How often key has been recorded (0 if never)
+int repetition_table_count(const RepetitionTable *table, ZobristKey key);
+
+#endif // ZOBRIST_H
@@ -1,5 +1,6 @@
 #include "server_core.h"
 #include "game.h"
+#include "log.h"
 #include <stdio.h>
 #include <signal.h>
 #include <time.h>
@@ -17,7 +18,7 @@ pid_t bot_pid = -1;  // Bot process ID
 void load_env_file(const char *filename) {
     FILE *file = fopen(filename, "r");
     if (!file) {
-        printf("[Main] No .env file found, using system environment variables\n");
+        LOG_INFO("[Main] No .env file found, using system environment variables\n");
         return;
     }
     
@@ -42,35 +43,30 @@ void load_env_file(const char *filename) {
     }
     
     fclose(file);
-    printf("[Main] Environment variables loaded from %s\n", filename);
+    LOG_INFO("[Main] Environment variables loaded from %s\n", filename);
 }
 
-// Signal handler for graceful shutdown
+static volatile sig_atomic_t received_signal = 0;
+
+// Signal handler for graceful shutdown. Only async-signal-safe work here:
+// the logger and the shutdown take locks the interrupted thread may hold,
+// so main() does them once server_start() returns.
 void signal_handler(int sig) {
-    printf("\n[Main] Received signal %d\n", sig);
-    
-    // Shutdown bot server first
-    if (bot_pid > 0) {
-        printf("[Main] Stopping bot server (PID: %d)...\n", bot_pid);
-        kill(bot_pid, SIGTERM);
-        waitpid(bot_pid, NULL, 0);
-        printf("[Main] Bot server stopped\n");
-    }
-    
-    server_shutdown();
-    exit(0);
+    received_signal = sig;
+    server_request_stop();
 }
 
 int main() {
     // Load environment variables from .env file
     load_env_file(".env");
+    log_init();
     
     // Setup signal handlers
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
     
     // Start bot server
-    printf("[Main] Starting bot server...\n");
+    LOG_INFO("[Main] Starting bot server...\n");
     bot_pid = fork();
     
     if (bot_pid == 0) {
@@ -89,13 +85,13 @@ int main() {
     }
     
     // Parent process: give bot time to start
-    printf("[Main] Bot server started (PID: %d)\n", bot_pid);
-    printf("[Main] Waiting for bot server to initialize...\n");
+    LOG_INFO("[Main] Bot server started (PID: %d)\n", bot_pid);
+    LOG_INFO("[Main] Waiting for bot server to initialize...\n");
     sleep(2);
     
     // Initialize server
     if (server_init(&db_conn) != 0) {
-        fprintf(stderr, "[Main] Server initialization failed\n");
+        LOG_ERROR("[Main] Server initialization failed\n");
         if (bot_pid > 0) {
             kill(bot_pid, SIGTERM);
             waitpid(bot_pid, NULL, 0);
@@ -103,17 +99,17 @@ int main() {
         return 1;
     }
     
-    printf("[Server] Ready to accept connections!\n\n");
+    LOG_INFO("[Server] Ready to accept connections!\n\n");
     
     // Track last cleanup time
     time_t last_cleanup = time(NULL);
     
-    while (1) {
+    while (!server_stop_requested()) {
         // Check if bot process is still alive
         int status;
         pid_t result = waitpid(bot_pid, &status, WNOHANG);
         if (result != 0) {
-            fprintf(stderr, "[Warning] Bot server terminated unexpectedly\n");
+            LOG_WARN("[Warning] Bot server terminated unexpectedly\n");
             // Could restart bot here if needed
         }
         
@@ -128,12 +124,19 @@ int main() {
         server_start();
     }
     
-    // Cleanup (will only reach here on error)
+    if (received_signal) {
+        LOG_INFO("\n[Main] Received signal %d\n", (int)received_signal);
+    }
+    
+    // Shutdown bot server first
     if (bot_pid > 0) {
+        LOG_INFO("[Main] Stopping bot server (PID: %d)...\n", bot_pid);
         kill(bot_pid, SIGTERM);
         waitpid(bot_pid, NULL, 0);
+        LOG_INFO("[Main] Bot server stopped\n");
     }
     server_shutdown();
+    log_flush();
     
     return 0;
 }
@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+"""Generate src/game/attack_tables.c (make attack-tables).
+
+Squares follow bitboard.h: sq = row * 8 + col with a8 = 0 and h1 = 63, and
+white pawns move towards row 0.
+"""
+import sys
+
+# Ray directions in the order of the RayDirection enum in bitboard.h
+DIRECTIONS = [
+    ("RAY_NORTH", -1, 0),
+    ("RAY_SOUTH", 1, 0),
+    ("RAY_EAST", 0, 1),
+    ("RAY_WEST", 0, -1),
+    ("RAY_NORTH_EAST", -1, 1),
+    ("RAY_NORTH_WEST", -1, -1),
+    ("RAY_SOUTH_EAST", 1, 1),
+    ("RAY_SOUTH_WEST", 1, -1),
+]
+
+KNIGHT_STEPS = [(-2, -1), (-2, 1), (-1, -2), (-1, 2), (1, -2), (1, 2), (2, -1), (2, 1)]
+KING_STEPS = [(dr, dc) for dr in (-1, 0, 1) for dc in (-1, 0, 1) if dr or dc]
+
+
+def on_board(row, col):
+    return 0 <= row < 8 and 0 <= col < 8
+
+
+def leaper(sq, steps):
+    row, col = divmod(sq, 8)
+    bb = 0
+    for dr, dc in steps:
+        if on_board(row + dr, col + dc):
+            bb |= 1 << ((row + dr) * 8 + col + dc)
+    return bb
+
+
+def ray(sq, dr, dc):
+    row, col = divmod(sq, 8)
+    bb = 0
+    row, col = row + dr, col + dc
+    while on_board(row, col):
+        bb |= 1 << (row * 8 + col)
+        row, col = row + dr, col + dc
+    return bb
+
+
+def emit_table(out, values, indent="    "):
+    for i in range(0, 64, 4):
+        out.write(indent + " ".join("0x%016xULL," % v for v in values[i:i + 4]) + "\n")
+
+
+def main():
+    out = sys.stdout
+    out.write("// Generated by scripts/gen_attack_tables.py - do not edit.\n")
+    out.write("// Regenerate with: make attack-tables\n\n")
+    out.write('#include "bitboard.h"\n\n')
+
+    out.write("const Bitboard pawn_attack_table[2][64] = {\n")
+    for name, dr in (("white", -1), ("black", 1)):
+        out.write("    { // %s\n" % name)
+        emit_table(out, [leaper(sq, [(dr, -1), (dr, 1)]) for sq in range(64)], "        ")
+        out.write("    },\n")
+    out.write("};\n\n")
+
+    out.write("const Bitboard knight_attack_table[64] = {\n")
+    emit_table(out, [leaper(sq, KNIGHT_STEPS) for sq in range(64)])
+    out.write("};\n\n")
+
+    out.write("const Bitboard king_attack_table[64] = {\n")
+    emit_table(out, [leaper(sq, KING_STEPS) for sq in range(64)])
+    out.write("};\n\n")
+
+    out.write("const Bitboard ray_table[RAY_DIRECTIONS][64] = {\n")
+    for name, dr, dc in DIRECTIONS:
+        out.write("    [%s] = {\n" % name)
+        emit_table(out, [ray(sq, dr, dc) for sq in range(64)], "        ")
+        out.write("    },\n")
+    out.write("};\n")
+
+
+if __name__ == "__main__":
+    main()
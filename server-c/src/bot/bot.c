@@ -2,12 +2,14 @@
 
 #include "bot.h"
 #include "game.h"
+#include "engine.h"
 #include "history.h"
+#include "database.h"
+#include "worker_pool.h"
+#include "log.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/socket.h>
-#include <arpa/inet.h>
 #include <unistd.h>
 #include <time.h>
 #include <ctype.h>
@@ -30,102 +32,286 @@ void handle_mode_bot(ClientSession *session, char *user_id, char *difficulty, PG
     );
 
     if (!match) {
-        send(session->socket_fd,
-             "ERROR|Failed to create bot match\n", 33, 0);
+        send_to_client(session->socket_fd, "ERROR|Failed to create bot match\n");
         return;
     }
 
     /* ✅ SET user_id để handle_bot_move có thể dùng */
     session->user_id = user_id_int;
-    session->current_match = match;
+    client_session_set_match(session, match);
 
     char resp[512];
     snprintf(resp, sizeof(resp),
              "BOT_MATCH_CREATED|%d|%s\n",
-             match->match_id, match->board.fen);
+             match->match_id, chess_board_get_fen(&match->board));
 
-    send(session->socket_fd, resp, strlen(resp), 0);
+    send_to_client(session->socket_fd, resp);
 }
 
-/* ================= CALL PYTHON BOT ================= */
-/*
-Protocol:
-    C -> Python : "fen|difficulty\n"
-    Python -> C : "e2e4\n" | "NOMOVE\n" | "ERROR\n"
-*/
+/* ================= NATIVE BOT ================= */
 
-int call_python_bot(
-    const char *fen,
+#define BOT_ENGINE_TT_MB 8
+
+typedef enum {
+    BOT_ENGINE_NATIVE,
+    BOT_ENGINE_PYTHON
+} BotEngineKind;
+
+static BotEngineKind bot_engine = BOT_ENGINE_NATIVE;
+static pthread_once_t bot_engine_once = PTHREAD_ONCE_INIT;
+
+// For searches without a worker's own searcher (call_native_bot(), or the
+// python engine falling back): one searcher per calling thread
+static __thread Engine *thread_engine = NULL;
+
+// BOT_ENGINE=native|python, read once
+static void bot_engine_select(void) {
+    const char *env = getenv("BOT_ENGINE");
+    if (env && strcmp(env, "python") == 0) {
+        bot_engine = BOT_ENGINE_PYTHON;
+    } else if (env && strcmp(env, "native") != 0) {
+        LOG_WARN("[Bot] Unknown BOT_ENGINE '%s', using native\n", env);
+    }
+    LOG_INFO("[Bot] Bot moves by the %s engine\n",
+             bot_engine == BOT_ENGINE_PYTHON ? "python" : "native");
+}
+
+static Engine* bot_thread_engine(void) {
+    if (!thread_engine) {
+        thread_engine = engine_create(BOT_ENGINE_TT_MB);
+        if (!thread_engine) LOG_ERROR("[Bot] Failed to allocate the search engine\n");
+    }
+    return thread_engine;
+}
+
+static int native_bot_move(Engine *engine, const ChessBoard *board,
+                           const RepetitionTable *history, const char *difficulty,
+                           const int *stop, char *bot_move_out, size_t bot_move_size) {
+    if (!engine || bot_move_size < 6) return -1;
+
+    EngineLimits limits;
+    EngineResult result;
+    engine_limits_for_difficulty(difficulty, &limits);
+    limits.stop = stop;
+    if (engine_search(engine, board, history, &limits, &result) != 0) {
+        snprintf(bot_move_out, bot_move_size, "NOMOVE");
+        return 0;
+    }
+
+    engine_move_to_uci(&result.best_move, bot_move_out);
+    LOG_DEBUG("[Bot] %s: %s score %d depth %d nodes %lu in %d ms\n",
+              difficulty, bot_move_out, result.score, result.depth,
+              result.nodes, result.time_ms);
+    return 0;
+}
+
+int call_native_bot(
+    const ChessBoard *board,
+    const RepetitionTable *history,
     const char *difficulty,
     char *bot_move_out,
     size_t bot_move_size
 ) {
-    const char *host = getenv("BOT_HOST") ? getenv("BOT_HOST") : "127.0.0.1";
-    int port = getenv("BOT_PORT") ? atoi(getenv("BOT_PORT")) : 5001;
+    return native_bot_move(bot_thread_engine(), board, history, difficulty, NULL,
+                           bot_move_out, bot_move_size);
+}
 
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        perror("[Bot] socket()");
-        return -1;
+/* ================= ENGINE POOL ================= */
+
+// A bot reply searched off the reactor. The job carries its own copy of the
+// position, so the search runs without holding the match lock.
+typedef struct {
+    int match_id;
+    int socket_fd;
+    char difficulty[16];
+    char fen[FEN_MAX_LENGTH];       // Position for the python engine
+    ChessBoard board;
+    RepetitionTable history;
+    int cancelled;                  // Set through match->bot_search_cancel
+} BotJob;
+
+// Per engine thread: a searcher and a database connection for the reply
+typedef struct {
+    Engine *engine;
+    PGconn *db;
+} EngineWorker;
+
+static WorkerPool engine_pool;
+static int engine_pool_started = 0;
+
+static void* engine_worker_init(int worker_index) {
+    (void)worker_index;
+    EngineWorker *worker = (EngineWorker*)calloc(1, sizeof(EngineWorker));
+    if (worker == NULL) return NULL;
+    if (bot_engine == BOT_ENGINE_NATIVE) {
+        worker->engine = engine_create(BOT_ENGINE_TT_MB);
     }
+    worker->db = db_connect();
+    return worker;
+}
 
-    struct sockaddr_in addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_port = htons(port);
+static void engine_worker_exit(void *thread_ctx) {
+    EngineWorker *worker = (EngineWorker*)thread_ctx;
+    if (worker == NULL) return;
+    engine_destroy(worker->engine);
+    if (worker->db) db_disconnect(worker->db);
+    free(worker);
+}
 
-    if (inet_pton(AF_INET, host, &addr.sin_addr) <= 0) {
-        close(sock);
+int bot_init(int threads, int queue_size) {
+    pthread_once(&bot_engine_once, bot_engine_select);
+    if (worker_pool_init(&engine_pool, "engine", threads, queue_size,
+                         engine_worker_init, engine_worker_exit) != 0) {
         return -1;
     }
+    engine_pool_started = 1;
+    return 0;
+}
 
-    if (connect(sock, (struct sockaddr *)&addr, sizeof(addr)) < 0) {
-        close(sock);
-        return -1;
+/* ================= BOT REPLY ================= */
+
+// BOT_MOVE_RESULT with the position after the bot's reply and the game state
+static void bot_send_result(GameMatch *match, int socket_fd, const char *bot_move) {
+    char status[16] = "IN_GAME";
+    if (match->status == GAME_FINISHED) {
+        if (match->result == RESULT_WHITE_WIN) strcpy(status, "WHITE_WIN");
+        else if (match->result == RESULT_BLACK_WIN) strcpy(status, "BLACK_WIN");
+        else strcpy(status, "DRAW");
     }
 
-    char request[2048];
-    snprintf(request, sizeof(request), "%s|%s\n", fen, difficulty);
-    send(sock, request, strlen(request), 0);
+    char resp[2048];
+    snprintf(resp, sizeof(resp),
+        "BOT_MOVE_RESULT|%s|%s|%s\n",
+        chess_board_get_fen(&match->board), bot_move, status);
 
-    char response[128];
-    ssize_t n = recv(sock, response, sizeof(response) - 1, 0);
-    close(sock);
+    send_to_client(socket_fd, resp);
+}
 
-    if (n <= 0) return -1;
+// Play the engine's reply, or end the game when there is none, and report
+// the new state to the player. Called with match->lock held.
+static void bot_apply_reply(GameMatch *match, int socket_fd, char *bot_move, int found,
+                            PGconn *db) {
+    if (found &&
+        strlen(bot_move) >= 4 &&
+        strcmp(bot_move, "NOMOVE") != 0 &&
+        strcmp(bot_move, "ERROR") != 0) {
 
-    response[n] = '\0';
+        char bfrom[3] = { bot_move[0], bot_move[1], '\0' };
+        char bto[3]   = { bot_move[2], bot_move[3], '\0' };
 
-    char *nl = strchr(response, '\n');
-    if (nl) *nl = '\0';
+        Move bm = {0};
+        notation_to_coords(bfrom, &bm.from_row, &bm.from_col);
+        notation_to_coords(bto, &bm.to_row, &bm.to_col);
 
-    strncpy(bot_move_out, response, bot_move_size - 1);
-    bot_move_out[bot_move_size - 1] = '\0';
+        bm.piece = match->board.board[bm.from_row][bm.from_col];
+        bm.captured_piece = match->board.board[bm.to_row][bm.to_col];
 
-    return 0;
+        // ← FIX: Bot cũng có thể promote (nếu UCI 5 char, suffix lowercase cho đen)
+        bm.is_promotion = 0;
+        bm.promotion_piece = '\0';
+        if (strlen(bot_move) == 5) {
+            char suffix = bot_move[4];
+            if (suffix == 'q' || suffix == 'r' || suffix == 'b' || suffix == 'n') {
+                // Lowercase cho đen (bot đen)
+                bm.promotion_piece = (suffix == 'q') ? 'q' : (suffix == 'r') ? 'r' : 
+                                     (suffix == 'b') ? 'b' : 'n';
+                // Validate: Pawn đen đến rank 1 (row 7)
+                char piece_type = toupper(bm.piece);
+                int last_rank_black = 7;
+                if (piece_type == 'P' && bm.to_row == last_rank_black) {  // 'p' uppercase 'P'
+                    bm.is_promotion = 1;
+                    LOG_DEBUG("[DEBUG] Bot promotion detected: %s -> promote to %c\n", bot_move, bm.promotion_piece);
+                } else {
+                    LOG_WARN("[WARN] Invalid bot promotion UCI: %s\n", bot_move);
+                }
+            }
+        }
+        if (!validate_move(&match->board, &bm, COLOR_BLACK)) {
+            LOG_WARN("[ERROR] Invalid bot move rejected: %s\n", bot_move);
+
+            // Bot đi sai → coi như bot thua
+            match->status = GAME_FINISHED;
+            match->result = RESULT_WHITE_WIN;
+            return;
+        }
+
+        execute_move(&match->board, &bm);
+        game_match_record_position(match);
+
+        // Save bot move with FEN after bot's move
+        history_save_bot_move(db, match->match_id, bot_move, chess_board_get_fen(&match->board));
+    } else if (strcmp(bot_move, "NOMOVE") == 0) {
+        // Handle stalemate/draw nếu bot no move
+        match->result = RESULT_DRAW;
+        match->status = GAME_FINISHED;
+    }
+
+    /* ===== FINAL STATE ===== */
+    game_match_check_end_condition(match, db);
+    bot_send_result(match, socket_fd, bot_move);
+}
+
+// Search the reply, then apply it if the game still wants it. Runs on an
+// engine worker, with the engine and db from its context.
+static void bot_job_execute(BotJob *job, Engine *engine, PGconn *db) {
+    char bot_move[16] = {0};
+    int rc = -1;
+    if (bot_engine == BOT_ENGINE_PYTHON) {
+        rc = call_python_bot(job->fen, job->difficulty, bot_move, sizeof(bot_move));
+        // The bot server sheds load with BUSY; a reply from our own engine
+        // beats a game that stalls
+        if (rc != 0 || strcmp(bot_move, "BUSY") == 0 || strcmp(bot_move, "ERROR") == 0) {
+            LOG_WARN("[Bot] Python bot %s for match %d, searching natively\n",
+                     rc != 0 ? "unavailable" : bot_move, job->match_id);
+            rc = -1;
+            if (!engine) engine = bot_thread_engine();
+        }
+    }
+    if (rc != 0) {
+        rc = native_bot_move(engine, &job->board, &job->history, job->difficulty,
+                             &job->cancelled, bot_move, sizeof(bot_move));
+    }
+
+    // Pinned, so cleanup on shard 0 cannot free it before we hold its lock
+    GameMatch *match = game_manager_acquire_match(&game_manager, job->match_id);
+    if (match) {
+        pthread_mutex_lock(&match->lock);
+        // Surrender, disconnect or removal cleared the pointer meanwhile
+        if (match->bot_search_cancel == &job->cancelled) {
+            match->bot_search_cancel = NULL;
+            if (match->status == GAME_PLAYING) {
+                bot_apply_reply(match, job->socket_fd, bot_move, rc == 0, db);
+            }
+        } else {
+            LOG_DEBUG("[Bot] Dropped the reply for match %d\n", job->match_id);
+        }
+        pthread_mutex_unlock(&match->lock);
+        game_match_release(match);
+    }
+    free(job);
+}
+
+static void bot_job_run(void *arg, void *thread_ctx) {
+    EngineWorker *worker = (EngineWorker*)thread_ctx;
+    bot_job_execute((BotJob*)arg, worker ? worker->engine : NULL, worker ? worker->db : NULL);
 }
 
 /* ================= BOT MOVE ================= */
 
-void handle_bot_move(
+// Play the player's move and queue the bot's reply; match is pinned by the
+// caller
+static void bot_play_player_move(
     ClientSession *session,
-    int num_params,
-    char *param1,
-    char *param2,
-    char *param3,
+    GameMatch *match,
+    char *player_move,  // e.g., "e7e8q" (full UCI)
+    char *difficulty,
     PGconn *db
 ) {
-    if (num_params < 4 || !session) return;
-
-    int match_id = atoi(param1);
-    char *player_move = param2;  // e.g., "e7e8q" (full UCI)
-    char *difficulty = param3;
-
-    GameMatch *match = game_manager_find_match(&game_manager, match_id);
-    if (!match) return;
+    int match_id = match->match_id;
 
     pthread_mutex_lock(&match->lock);
 
+    // Black to move also covers a bot reply still being searched
     if (match->status != GAME_PLAYING ||
         match->board.current_turn != COLOR_WHITE) {
         pthread_mutex_unlock(&match->lock);
@@ -162,110 +348,99 @@ void handle_bot_move(
             int last_rank = 0;  // Trắng đến rank 8 (row 0)
             if (piece_type == 'P' && pm.to_row == last_rank) {
                 pm.is_promotion = 1;
-                printf("[DEBUG] Promotion detected: %s -> promote to %c\n", player_move, pm.promotion_piece);
+                LOG_DEBUG("[DEBUG] Promotion detected: %s -> promote to %c\n", player_move, pm.promotion_piece);
             } else {
-                printf("[WARN] Invalid promotion UCI for player: %s (not pawn or wrong rank)\n", player_move);
+                LOG_WARN("[WARN] Invalid promotion UCI for player: %s (not pawn or wrong rank)\n", player_move);
             }
         }
     }
 
     if (!validate_move(&match->board, &pm, COLOR_WHITE)) {
-    printf("[ERROR] Invalid player move rejected: %s\n", player_move);
+    LOG_WARN("[ERROR] Invalid player move rejected: %s\n", player_move);
     pthread_mutex_unlock(&match->lock);
     return;
 }
 
+    // Allocated before the move is played so running out of memory leaves
+    // the game as it was
+    BotJob *job = (BotJob*)malloc(sizeof(BotJob));
+    if (!job) {
+        pthread_mutex_unlock(&match->lock);
+        send_to_client(session->socket_fd, "ERROR|Server busy\n");
+        return;
+    }
+
+    // Kept until the search is queued: with the engine queue full the
+    // player's move is taken back rather than searched on this thread
+    ChessBoard board_before = match->board;
+    RepetitionTable repetitions_before = match->repetitions;
+    int repeats_before = match->position_repeats;
 
     execute_move(&match->board, &pm);
+    game_match_record_position(match);
     
-    // Save player move with FEN after move (lưu full UCI)
-    char fen_after_player[FEN_MAX_LENGTH];
-    chess_board_to_fen(&match->board, fen_after_player);
-    history_save_move(db, match_id, session->user_id, player_move, fen_after_player);
-
-    /* ===== BOT MOVE ===== */
-    char fen_before_bot[FEN_MAX_LENGTH];
-    chess_board_to_fen(&match->board, fen_before_bot);
-
-    char bot_move[16] = {0};
-    if (call_python_bot(fen_before_bot, difficulty,
-                        bot_move, sizeof(bot_move)) == 0 &&
-        strlen(bot_move) >= 4 &&
-        strcmp(bot_move, "NOMOVE") != 0 &&
-        strcmp(bot_move, "ERROR") != 0) {
-
-        char bfrom[3] = { bot_move[0], bot_move[1], '\0' };
-        char bto[3]   = { bot_move[2], bot_move[3], '\0' };
+    // The same FEN is the position the bot moves from
+    const char *fen_before_bot = chess_board_get_fen(&match->board);
 
-        Move bm = {0};
-        notation_to_coords(bfrom, &bm.from_row, &bm.from_col);
-        notation_to_coords(bto, &bm.to_row, &bm.to_col);
+    // The player's move may already have ended the game
+    if (game_match_check_end_condition(match, db)) {
+        history_save_move(db, match_id, session->user_id, player_move, fen_before_bot);
+        bot_send_result(match, session->socket_fd, "NOMOVE");
+        pthread_mutex_unlock(&match->lock);
+        free(job);
+        return;
+    }
 
-        bm.piece = match->board.board[bm.from_row][bm.from_col];
-        bm.captured_piece = match->board.board[bm.to_row][bm.to_col];
+    /* ===== BOT MOVE ===== */
+    // Searched on the engine pool; the reactor only acknowledges the move
+    // and the reply follows as BOT_MOVE_RESULT when the search is done
+    job->match_id = match_id;
+    job->socket_fd = session->socket_fd;
+    snprintf(job->difficulty, sizeof(job->difficulty), "%s", difficulty);
+    snprintf(job->fen, sizeof(job->fen), "%s", fen_before_bot);
+    job->board = match->board;
+    job->history = match->repetitions;
+    job->cancelled = 0;
+    match->bot_search_cancel = &job->cancelled;
+
+    // Queued under the match lock: the worker may finish the search first,
+    // but it needs this lock to play the reply
+    if (!engine_pool_started || worker_pool_submit(&engine_pool, bot_job_run, job) != 0) {
+        // Never search on the reactor; the player can send the move again
+        match->bot_search_cancel = NULL;
+        match->board = board_before;
+        match->repetitions = repetitions_before;
+        match->position_repeats = repeats_before;
+        pthread_mutex_unlock(&match->lock);
+        free(job);
+        LOG_WARN("[Bot] Engine queue full, refused a move in match %d\n", match_id);
+        send_to_client(session->socket_fd, "ERROR|Server busy\n");
+        return;
+    }
 
-        // ← FIX: Bot cũng có thể promote (nếu UCI 5 char, suffix lowercase cho đen)
-        bm.is_promotion = 0;
-        bm.promotion_piece = '\0';
-        if (strlen(bot_move) == 5) {
-            char suffix = bot_move[4];
-            if (suffix == 'q' || suffix == 'r' || suffix == 'b' || suffix == 'n') {
-                // Lowercase cho đen (bot đen)
-                bm.promotion_piece = (suffix == 'q') ? 'q' : (suffix == 'r') ? 'r' : 
-                                     (suffix == 'b') ? 'b' : 'n';
-                // Validate: Pawn đen đến rank 1 (row 7)
-                char piece_type = toupper(bm.piece);
-                int last_rank_black = 7;
-                if (piece_type == 'P' && bm.to_row == last_rank_black) {  // 'p' uppercase 'P'
-                    bm.is_promotion = 1;
-                    printf("[DEBUG] Bot promotion detected: %s -> promote to %c\n", bot_move, bm.promotion_piece);
-                } else {
-                    printf("[WARN] Invalid bot promotion UCI: %s\n", bot_move);
-                }
-            }
-        }
-        if (!validate_move(&match->board, &bm, COLOR_BLACK)) {
-    printf("[ERROR] Invalid bot move rejected: %s\n", bot_move);
+    // Save player move with FEN after move (lưu full UCI)
+    history_save_move(db, match_id, session->user_id, player_move, fen_before_bot);
 
-    // Bot đi sai → coi như bot thua
-    match->status = GAME_FINISHED;
-    match->result = RESULT_WHITE_WIN;
+    char ack[512];
+    snprintf(ack, sizeof(ack), "BOT_MOVE_ACCEPTED|%s|%s\n", fen_before_bot, player_move);
+    send_to_client(session->socket_fd, ack);
 
     pthread_mutex_unlock(&match->lock);
-    return;
 }
 
-execute_move(&match->board, &bm);
-
-
-        
-        // Save bot move with FEN after bot's move
-        char fen_after_bot[FEN_MAX_LENGTH];
-        chess_board_to_fen(&match->board, fen_after_bot);
-        history_save_bot_move(db, match_id, bot_move, fen_after_bot);
-    } else if (strcmp(bot_move, "NOMOVE") == 0) {
-        // Handle stalemate/draw nếu bot no move
-        match->result = RESULT_DRAW;
-        match->status = GAME_FINISHED;
-    }
-
-    /* ===== FINAL STATE ===== */
-    chess_board_to_fen(&match->board, match->board.fen);
-    game_match_check_end_condition(match, db);
-
-    char status[16] = "IN_GAME";
-    if (match->status == GAME_FINISHED) {
-        if (match->result == RESULT_WHITE_WIN) strcpy(status, "WHITE_WIN");
-        else if (match->result == RESULT_BLACK_WIN) strcpy(status, "BLACK_WIN");
-        else strcpy(status, "DRAW");
-    }
-
-    char resp[2048];
-    snprintf(resp, sizeof(resp),
-        "BOT_MOVE_RESULT|%s|%s|%s\n",
-        match->board.fen, bot_move, status);
+void handle_bot_move(
+    ClientSession *session,
+    int num_params,
+    char *param1,
+    char *param2,
+    char *param3,
+    PGconn *db
+) {
+    if (num_params < 4 || !session) return;
 
-    send(session->socket_fd, resp, strlen(resp), 0);
+    GameMatch *match = game_manager_acquire_match(&game_manager, atoi(param1));
+    if (!match) return;
 
-    pthread_mutex_unlock(&match->lock);
+    bot_play_player_move(session, match, param2, param3, db);
+    game_match_release(match);
 }
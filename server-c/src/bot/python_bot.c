@@ -0,0 +1,266 @@
+// python_bot.c - Keep-alive connections to bot/bot_socket_server.py
+//
+// Requests go out as "id|fen|difficulty\n" over a few long-lived
+// connections. A reader thread per connection hands every "id|move\n"
+// reply to the caller waiting on that id, so several searches share one
+// connection and the server may answer them in any order. A caller that
+// times out just stops waiting; the late reply is dropped by its id.
+
+#include "bot.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+
+#define PYTHON_BOT_MAX_CONNECTIONS 16
+#define PYTHON_BOT_LINE_MAX 256
+
+typedef struct PythonBotCall {
+    unsigned int id;
+    int state;                      // 0 waiting, 1 answered, -1 connection lost
+    char move[16];
+    struct PythonBotCall *next;
+} PythonBotCall;
+
+typedef struct {
+    pthread_mutex_t lock;
+    pthread_cond_t answered;        // Broadcast on every reply and on disconnect
+    int fd;                         // -1 while disconnected
+    int reader_running;             // The old reader owns the socket until it exits
+    PythonBotCall *pending;
+} PythonBotConnection;
+
+static struct {
+    struct sockaddr_in addr;
+    int valid;
+    int connections;
+    int timeout_ms;
+} config;
+
+static PythonBotConnection connections[PYTHON_BOT_MAX_CONNECTIONS];
+static pthread_once_t config_once = PTHREAD_ONCE_INIT;
+static unsigned int next_id = 0;
+static unsigned int next_connection = 0;
+
+static int env_int(const char *name, int fallback) {
+    const char *env = getenv(name);
+    int value = env ? atoi(env) : 0;
+    return value > 0 ? value : fallback;
+}
+
+// BOT_HOST, BOT_PORT, BOT_CONNECTIONS and BOT_TIMEOUT_MS, read once
+static void python_bot_configure(void) {
+    const char *host = getenv("BOT_HOST") ? getenv("BOT_HOST") : "127.0.0.1";
+
+    memset(&config.addr, 0, sizeof(config.addr));
+    config.addr.sin_family = AF_INET;
+    config.addr.sin_port = htons((unsigned short)env_int("BOT_PORT", 5001));
+    config.valid = inet_pton(AF_INET, host, &config.addr.sin_addr) == 1;
+    if (!config.valid) LOG_ERROR("[Bot] Invalid BOT_HOST '%s'\n", host);
+
+    config.connections = env_int("BOT_CONNECTIONS", 2);
+    if (config.connections > PYTHON_BOT_MAX_CONNECTIONS) {
+        config.connections = PYTHON_BOT_MAX_CONNECTIONS;
+    }
+    config.timeout_ms = env_int("BOT_TIMEOUT_MS", 5000);
+
+    pthread_condattr_t attr;
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    for (int i = 0; i < config.connections; i++) {
+        pthread_mutex_init(&connections[i].lock, NULL);
+        pthread_cond_init(&connections[i].answered, &attr);
+        connections[i].fd = -1;
+    }
+    pthread_condattr_destroy(&attr);
+}
+
+// Hand one "id|move" line to its caller; replies nobody waits for any more
+// (timed out) are dropped
+static void connection_dispatch(PythonBotConnection *conn, char *line) {
+    char *sep = strchr(line, '|');
+    if (!sep) {
+        LOG_WARN("[Bot] Malformed bot server reply: %s\n", line);
+        return;
+    }
+    *sep = '\0';
+    unsigned int id = (unsigned int)strtoul(line, NULL, 10);
+
+    pthread_mutex_lock(&conn->lock);
+    PythonBotCall *call = conn->pending;
+    while (call && call->id != id) call = call->next;
+    if (call) {
+        snprintf(call->move, sizeof(call->move), "%s", sep + 1);
+        call->state = 1;
+        pthread_cond_broadcast(&conn->answered);
+    } else {
+        LOG_DEBUG("[Bot] Dropped a late bot server reply (id %u)\n", id);
+    }
+    pthread_mutex_unlock(&conn->lock);
+}
+
+static void* connection_reader(void *arg) {
+    PythonBotConnection *conn = (PythonBotConnection*)arg;
+    int fd = conn->fd;
+    char buf[PYTHON_BOT_LINE_MAX * 4];
+    size_t used = 0;
+
+    for (;;) {
+        ssize_t n = recv(fd, buf + used, sizeof(buf) - 1 - used, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) break;
+        used += (size_t)n;
+        buf[used] = '\0';
+
+        char *line = buf;
+        char *nl;
+        while ((nl = strchr(line, '\n')) != NULL) {
+            *nl = '\0';
+            if (nl > line && nl[-1] == '\r') nl[-1] = '\0';
+            if (*line) connection_dispatch(conn, line);
+            line = nl + 1;
+        }
+        used -= (size_t)(line - buf);
+        memmove(buf, line, used);
+        // A line longer than the buffer is garbage; drop it
+        if (used == sizeof(buf) - 1) used = 0;
+    }
+
+    LOG_WARN("[Bot] Lost the connection to the bot server\n");
+    pthread_mutex_lock(&conn->lock);
+    close(fd);
+    conn->fd = -1;
+    conn->reader_running = 0;
+    for (PythonBotCall *call = conn->pending; call; call = call->next) {
+        if (call->state == 0) call->state = -1;
+    }
+    pthread_cond_broadcast(&conn->answered);
+    pthread_mutex_unlock(&conn->lock);
+    return NULL;
+}
+
+// Call with conn->lock held
+static int connection_open(PythonBotConnection *conn) {
+    if (conn->fd >= 0) return 0;
+    if (conn->reader_running || !config.valid) return -1;
+
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) {
+        LOG_ERROR("[Bot] socket(): %s\n", strerror(errno));
+        return -1;
+    }
+
+    // Bounds connect() and send() as well
+    struct timeval tv = { config.timeout_ms / 1000, (config.timeout_ms % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    if (connect(fd, (struct sockaddr *)&config.addr, sizeof(config.addr)) < 0) {
+        LOG_WARN("[Bot] Cannot reach the bot server: %s\n", strerror(errno));
+        close(fd);
+        return -1;
+    }
+
+    conn->fd = fd;
+    pthread_t thread;
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+    int rc = pthread_create(&thread, &attr, connection_reader, conn);
+    pthread_attr_destroy(&attr);
+    if (rc != 0) {
+        LOG_ERROR("[Bot] Failed to start the bot server reader\n");
+        close(fd);
+        conn->fd = -1;
+        return -1;
+    }
+    conn->reader_running = 1;
+    LOG_INFO("[Bot] Connected to the bot server\n");
+    return 0;
+}
+
+static void connection_unlink(PythonBotConnection *conn, PythonBotCall *call) {
+    for (PythonBotCall **p = &conn->pending; *p; p = &(*p)->next) {
+        if (*p == call) {
+            *p = call->next;
+            return;
+        }
+    }
+}
+
+int call_python_bot(
+    const char *fen,
+    const char *difficulty,
+    char *bot_move_out,
+    size_t bot_move_size
+) {
+    pthread_once(&config_once, python_bot_configure);
+
+    unsigned int slot = __atomic_fetch_add(&next_connection, 1, __ATOMIC_RELAXED);
+    PythonBotConnection *conn = &connections[slot % (unsigned int)config.connections];
+
+    PythonBotCall call;
+    memset(&call, 0, sizeof(call));
+    call.id = __atomic_add_fetch(&next_id, 1, __ATOMIC_RELAXED);
+
+    char request[PYTHON_BOT_LINE_MAX];
+    int len = snprintf(request, sizeof(request), "%u|%s|%s\n", call.id, fen, difficulty);
+    if (len < 0 || len >= (int)sizeof(request)) return -1;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_sec += config.timeout_ms / 1000;
+    deadline.tv_nsec += (long)(config.timeout_ms % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&conn->lock);
+    if (connection_open(conn) != 0) {
+        pthread_mutex_unlock(&conn->lock);
+        return -1;
+    }
+
+    // Register before sending: the reply may beat us back from send()
+    call.next = conn->pending;
+    conn->pending = &call;
+
+    // Requests are a few dozen bytes; send them whole under the lock so
+    // lines from different callers never interleave
+    ssize_t sent = send(conn->fd, request, (size_t)len, MSG_NOSIGNAL);
+    if (sent != len) {
+        // The reader sees the broken socket and fails the other callers
+        LOG_WARN("[Bot] Failed to send to the bot server\n");
+        shutdown(conn->fd, SHUT_RDWR);
+        connection_unlink(conn, &call);
+        pthread_mutex_unlock(&conn->lock);
+        return -1;
+    }
+
+    while (call.state == 0) {
+        if (pthread_cond_timedwait(&conn->answered, &conn->lock, &deadline) == ETIMEDOUT) break;
+    }
+    connection_unlink(conn, &call);
+    pthread_mutex_unlock(&conn->lock);
+
+    if (call.state != 1) {
+        if (call.state == 0) {
+            LOG_WARN("[Bot] Bot server did not answer within %d ms\n", config.timeout_ms);
+        }
+        return -1;
+    }
+
+    strncpy(bot_move_out, call.move, bot_move_size - 1);
+    bot_move_out[bot_move_size - 1] = '\0';
+    return 0;
+}
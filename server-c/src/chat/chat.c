@@ -23,5 +23,5 @@ void handle_chat(ClientSession *session, int num_params, const char *to_user, co
     // Đóng gói và gửi CHAT_FROM|from_id|message\n
     char buf[1024];
     snprintf(buf, sizeof(buf), "CHAT_FROM|%s|%s\n", from_id, message);
-    send(to_fd, buf, strlen(buf), 0);
+    send_to_client(to_fd, buf);
 }
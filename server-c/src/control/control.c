@@ -2,6 +2,8 @@
 #include "control.h"
 #include "game.h"
 #include "history.h"
+#include "log.h"
+#include "database.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,7 +18,7 @@ void handle_pause(ClientSession *session, int num_params, char *param1,
         int match_id = atoi(param1);
         int player_id = atoi(param2);
         
-        GameMatch *match = game_manager_find_match(&game_manager, match_id);
+        GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
         if (match != NULL) {
             pthread_mutex_lock(&match->lock);
             
@@ -27,13 +29,13 @@ void handle_pause(ClientSession *session, int num_params, char *param1,
                         "UPDATE match_game SET status='paused' WHERE match_id=%d AND status='playing'",
                         match_id);
                 
-                PGresult *res = PQexec(db, query);
+                PGresult *res = db_exec(db, query);
                 if (PQresultStatus(res) == PGRES_COMMAND_OK) {
                     // ✅ Update in-memory state  
                     match->status = GAME_PAUSED;  // Need to add GAME_PAUSED to enum
                     
                     char response[] = "GAME_PAUSED\n";
-                    send(session->socket_fd, response, strlen(response), 0);
+                    send_to_client(session->socket_fd, response);
                     
                     // Notify opponent
                     int opponent_fd = (match->white_player.user_id == player_id) 
@@ -41,25 +43,26 @@ void handle_pause(ClientSession *session, int num_params, char *param1,
                                       : match->white_player.socket_fd;
                     if (opponent_fd != session->socket_fd && opponent_fd > 0) {
                         char notify[] = "GAME_PAUSED_BY_OPPONENT\n";
-                        send(opponent_fd, notify, strlen(notify), 0);
+                        send_to_client(opponent_fd, notify);
                     }
                     
-                    printf("[Control] Match %d paused by player %d (DB updated)\n", match_id, player_id);
+                    LOG_INFO("[Control] Match %d paused by player %d (DB updated)\n", match_id, player_id);
                 } else {
                     char error[] = "ERROR|Failed to pause game\n";
-                    send(session->socket_fd, error, strlen(error), 0);
-                    printf("[Control] Database error pausing match %d: %s\n", match_id, PQerrorMessage(db));
+                    send_to_client(session->socket_fd, error);
+                    LOG_WARN("[Control] Database error pausing match %d: %s\n", match_id, PQerrorMessage(db));
                 }
                 PQclear(res);
             } else {
                 char error[] = "ERROR|Game is not in playing state\n";
-                send(session->socket_fd, error, strlen(error), 0);
+                send_to_client(session->socket_fd, error);
             }
             
             pthread_mutex_unlock(&match->lock);
+            game_match_release(match);
         } else {
             char error[] = "ERROR|Match not found\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
         }
     }
 }
@@ -70,7 +73,7 @@ void handle_resume(ClientSession *session, int num_params, char *param1,
         int match_id = atoi(param1);
         int player_id = atoi(param2);
         
-        GameMatch *match = game_manager_find_match(&game_manager, match_id);
+        GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
         if (match != NULL) {
             pthread_mutex_lock(&match->lock);
             
@@ -79,7 +82,7 @@ void handle_resume(ClientSession *session, int num_params, char *param1,
             snprintf(check_query, sizeof(check_query),
                     "SELECT status FROM match_game WHERE match_id=%d", match_id);
             
-            PGresult *check_res = PQexec(db, check_query);
+            PGresult *check_res = db_exec(db, check_query);
             if (PQresultStatus(check_res) == PGRES_TUPLES_OK && PQntuples(check_res) > 0) {
                 char *current_status = PQgetvalue(check_res, 0, 0);
                 
@@ -90,13 +93,13 @@ void handle_resume(ClientSession *session, int num_params, char *param1,
                             "UPDATE match_game SET status='playing' WHERE match_id=%d",
                             match_id);
                     
-                    PGresult *res = PQexec(db, update_query);
+                    PGresult *res = db_exec(db, update_query);
                     if (PQresultStatus(res) == PGRES_COMMAND_OK) {
                         // ✅ Update in-memory state
                         match->status = GAME_PLAYING;
                         
                         char response[] = "GAME_RESUMED\n";
-                        send(session->socket_fd, response, strlen(response), 0);
+                        send_to_client(session->socket_fd, response);
                         
                         // Notify opponent
                         int opponent_fd = (match->white_player.user_id == player_id) 
@@ -104,31 +107,32 @@ void handle_resume(ClientSession *session, int num_params, char *param1,
                                           : match->white_player.socket_fd;
                         if (opponent_fd != session->socket_fd && opponent_fd > 0) {
                             char notify[] = "GAME_RESUMED\n";
-                            send(opponent_fd, notify, strlen(notify), 0);
+                            send_to_client(opponent_fd, notify);
                         }
                         
-                        printf("[Control] Match %d resumed by player %d (DB updated)\n", match_id, player_id);
+                        LOG_INFO("[Control] Match %d resumed by player %d (DB updated)\n", match_id, player_id);
                     } else {
                         char error[] = "ERROR|Failed to resume game\n";
-                        send(session->socket_fd, error, strlen(error), 0);
-                        printf("[Control] Database error resuming match %d: %s\n", match_id, PQerrorMessage(db));
+                        send_to_client(session->socket_fd, error);
+                        LOG_WARN("[Control] Database error resuming match %d: %s\n", match_id, PQerrorMessage(db));
                     }
                     PQclear(res);
                 } else {
                     char error[100];
                     snprintf(error, sizeof(error), "ERROR|Game is not paused (status: %s)\n", current_status);
-                    send(session->socket_fd, error, strlen(error), 0);
+                    send_to_client(session->socket_fd, error);
                 }
             } else {
                 char error[] = "ERROR|Failed to check game status\n";
-                send(session->socket_fd, error, strlen(error), 0);
+                send_to_client(session->socket_fd, error);
             }
             PQclear(check_res);
             
             pthread_mutex_unlock(&match->lock);
+            game_match_release(match);
         } else {
             char error[] = "ERROR|Match not found\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
         }
     }
 }
@@ -141,7 +145,7 @@ void handle_draw_request(ClientSession *session, int num_params, char *param1,
         int match_id = atoi(param1);
         int player_id = atoi(param2);
         
-        GameMatch *match = game_manager_find_match(&game_manager, match_id);
+        GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
         if (match != NULL) {
             pthread_mutex_lock(&match->lock);
             
@@ -155,7 +159,7 @@ void handle_draw_request(ClientSession *session, int num_params, char *param1,
                         "WHERE match_id=%d AND user_id=%d AND action_state='normal'",
                         match_id, player_id);
                 
-                PGresult *res = PQexec(db, query);
+                PGresult *res = db_exec(db, query);
                 
                 if (PQresultStatus(res) == PGRES_COMMAND_OK) {
                     int rows_affected = atoi(PQcmdTuples(res));
@@ -165,7 +169,7 @@ void handle_draw_request(ClientSession *session, int num_params, char *param1,
                         match->draw_requester_id = player_id;
                         
                         char response[] = "DRAW_REQUESTED\n";
-                        send(session->socket_fd, response, strlen(response), 0);
+                        send_to_client(session->socket_fd, response);
                         
                         // Notify opponent
                         int opponent_fd = (match->white_player.user_id == player_id) 
@@ -175,39 +179,40 @@ void handle_draw_request(ClientSession *session, int num_params, char *param1,
                             char notify[256];
                             snprintf(notify, sizeof(notify), 
                                     "DRAW_REQUEST_FROM_OPPONENT|%d\n", player_id);
-                            send(opponent_fd, notify, strlen(notify), 0);
+                            send_to_client(opponent_fd, notify);
                         }
                         
-                        printf("[Control] Player %d requested draw in match %d (DB updated)\n", 
+                        LOG_INFO("[Control] Player %d requested draw in match %d (DB updated)\n", 
                                player_id, match_id);
                     } else {
                         char error[] = "ERROR|Player not found in match or already has pending action\n";
-                        send(session->socket_fd, error, strlen(error), 0);
+                        send_to_client(session->socket_fd, error);
                     }
                 } else {
                     char error[] = "ERROR|Failed to record draw request\n";
-                    send(session->socket_fd, error, strlen(error), 0);
-                    printf("[Control] Database error recording draw request: %s\n", 
+                    send_to_client(session->socket_fd, error);
+                    LOG_WARN("[Control] Database error recording draw request: %s\n", 
                            PQerrorMessage(db));
                 }
                 PQclear(res);
                 
             } else if (match->status != GAME_PLAYING) {
                 char error[] = "ERROR|Game is not in playing state\n";
-                send(session->socket_fd, error, strlen(error), 0);
+                send_to_client(session->socket_fd, error);
             } else {
                 char error[] = "ERROR|Draw request already pending\n";
-                send(session->socket_fd, error, strlen(error), 0);
+                send_to_client(session->socket_fd, error);
             }
             
             pthread_mutex_unlock(&match->lock);
+            game_match_release(match);
         } else {
             char error[] = "ERROR|Match not found\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
         }
     } else {
         char error[] = "ERROR|Invalid DRAW command format\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
     }
 }
 
@@ -219,7 +224,7 @@ void handle_draw_accept(ClientSession *session, int num_params, char *param1,
         int match_id = atoi(param1);
         int player_id = atoi(param2);
         
-        GameMatch *match = game_manager_find_match(&game_manager, match_id);
+        GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
         if (match != NULL) {
             pthread_mutex_lock(&match->lock);
             
@@ -233,7 +238,7 @@ void handle_draw_accept(ClientSession *session, int num_params, char *param1,
                         "WHERE match_id=%d AND action_state='draw_offer'",
                         match_id);
                 
-                PGresult *clear_res = PQexec(db, clear_query);
+                PGresult *clear_res = db_exec(db, clear_query);
                 
                 if (PQresultStatus(clear_res) == PGRES_COMMAND_OK) {
                     // ✅ End game with draw result
@@ -248,11 +253,11 @@ void handle_draw_accept(ClientSession *session, int num_params, char *param1,
                             "WHERE match_id=%d",
                             match_id);
                     
-                    PGresult *res = PQexec(db, query);
+                    PGresult *res = db_exec(db, query);
                     
                     if (PQresultStatus(res) == PGRES_COMMAND_OK) {
                         char response[] = "DRAW_ACCEPTED\n";
-                        send(session->socket_fd, response, strlen(response), 0);
+                        send_to_client(session->socket_fd, response);
                         
                         // Notify opponent
                         int opponent_fd = (match->white_player.user_id == player_id) 
@@ -260,35 +265,36 @@ void handle_draw_accept(ClientSession *session, int num_params, char *param1,
                                           : match->white_player.socket_fd;
                         if (opponent_fd != session->socket_fd && opponent_fd > 0) {
                             char notify[] = "DRAW_ACCEPTED\n";
-                            send(opponent_fd, notify, strlen(notify), 0);
+                            send_to_client(opponent_fd, notify);
                         }
                         
-                        printf("[Control] Draw accepted in match %d - Game ended (DB updated)\n", 
+                        LOG_INFO("[Control] Draw accepted in match %d - Game ended (DB updated)\n", 
                                match_id);
                     } else {
                         char error[] = "ERROR|Failed to end game\n";
-                        send(session->socket_fd, error, strlen(error), 0);
+                        send_to_client(session->socket_fd, error);
                     }
                     PQclear(res);
                 } else {
                     char error[] = "ERROR|Failed to clear draw requests\n";
-                    send(session->socket_fd, error, strlen(error), 0);
+                    send_to_client(session->socket_fd, error);
                 }
                 PQclear(clear_res);
                 
             } else {
                 char error[] = "ERROR|No draw request pending or you are the requester\n";
-                send(session->socket_fd, error, strlen(error), 0);
+                send_to_client(session->socket_fd, error);
             }
             
             pthread_mutex_unlock(&match->lock);
+            game_match_release(match);
         } else {
             char error[] = "ERROR|Match not found\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
         }
     } else {
         char error[] = "ERROR|Invalid DRAW_ACCEPT command format\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
     }
 }
 
@@ -299,7 +305,7 @@ void handle_draw_decline(ClientSession *session, int num_params, char *param1,
     if (num_params >= 3) {
         int match_id = atoi(param1);
         int decliner_id = atoi(param2);  // người từ chối
-        GameMatch *match = game_manager_find_match(&game_manager, match_id);
+        GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
 
         if (match != NULL) {
             pthread_mutex_lock(&match->lock);
@@ -319,7 +325,7 @@ void handle_draw_decline(ClientSession *session, int num_params, char *param1,
                          "WHERE match_id=%d AND user_id=%d AND action_state='draw_offer'",
                          match_id, requester_id);
                 
-                PGresult *res = PQexec(db, query);
+                PGresult *res = db_exec(db, query);
                 
                 if (PQresultStatus(res) == PGRES_COMMAND_OK) {
                     int rows_affected = atoi(PQcmdTuples(res));
@@ -332,39 +338,40 @@ void handle_draw_decline(ClientSession *session, int num_params, char *param1,
                             char notify[256];
                             snprintf(notify, sizeof(notify), 
                                      "DRAW_DECLINED_BY_OPPONENT|%d\n", decliner_id);
-                            send(requester_fd, notify, strlen(notify), 0);
+                            send_to_client(requester_fd, notify);
                         }
 
                         // Gửi ACK cho người từ chối
                         char response[] = "DRAW_DECLINED\n";
-                        send(session->socket_fd, response, strlen(response), 0);
+                        send_to_client(session->socket_fd, response);
 
-                        printf("[Control] Draw declined in match %d (DB updated)\n", match_id);
+                        LOG_INFO("[Control] Draw declined in match %d (DB updated)\n", match_id);
                     } else {
                         char error[] = "ERROR|No draw offer found to decline\n";
-                        send(session->socket_fd, error, strlen(error), 0);
+                        send_to_client(session->socket_fd, error);
                     }
                 } else {
                     char error[] = "ERROR|Failed to update draw status\n";
-                    send(session->socket_fd, error, strlen(error), 0);
-                    printf("[Control] Database error declining draw: %s\n", 
+                    send_to_client(session->socket_fd, error);
+                    LOG_WARN("[Control] Database error declining draw: %s\n", 
                            PQerrorMessage(db));
                 }
                 PQclear(res);
 
             } else {
                 char error[] = "ERROR|No draw request pending or you are the requester\n";
-                send(session->socket_fd, error, strlen(error), 0);
+                send_to_client(session->socket_fd, error);
             }
 
             pthread_mutex_unlock(&match->lock);
+            game_match_release(match);
         } else {
             char error[] = "ERROR|Match not found\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
         }
     } else {
         char error[] = "ERROR|Invalid DRAW_DECLINE command format\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
     }
 }
 
@@ -377,10 +384,10 @@ void handle_rematch_request(ClientSession *session, int num_params, char *param1
     if (num_params >= 3) {
         int match_id = atoi(param1);
         int player_id = atoi(param2);
-        GameMatch *match = game_manager_find_match(&game_manager, match_id);
+        GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
         if (!match) {
             char error[] = "ERROR|Match not found\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
             PQclear(check_res);
             return;
         }
@@ -391,7 +398,7 @@ void handle_rematch_request(ClientSession *session, int num_params, char *param1
         snprintf(check_query, sizeof(check_query),
                 "SELECT status FROM match_game WHERE match_id=%d", match_id);
         
-        PGresult *check_res = PQexec(db, check_query);
+        PGresult *check_res = db_exec(db, check_query);
         
         if (PQresultStatus(check_res) == PGRES_TUPLES_OK && PQntuples(check_res) > 0) {
             char *game_status = PQgetvalue(check_res, 0, 0);
@@ -404,7 +411,7 @@ void handle_rematch_request(ClientSession *session, int num_params, char *param1
                         "WHERE match_id=%d AND user_id=%d AND action_state='normal'",
                         match_id, player_id);
                 
-                PGresult *res = PQexec(db, query);
+                PGresult *res = db_exec(db, query);
                 
                 if (PQresultStatus(res) == PGRES_COMMAND_OK) {
                     int rows_affected = atoi(PQcmdTuples(res));
@@ -413,44 +420,42 @@ void handle_rematch_request(ClientSession *session, int num_params, char *param1
                         match->rematch_requester_id = player_id;   // <--- Thêm dòng này
 
                         char response[] = "REMATCH_REQUESTED\n";
-                        send(session->socket_fd, response, strlen(response), 0);
+                        send_to_client(session->socket_fd, response);
                         
                         // ✅ Notify opponent about rematch request
-                        GameMatch *match = game_manager_find_match(&game_manager, match_id);
-                        if (match != NULL) {
-                            int opponent_fd = -1;
-                            if (match->white_player.user_id == player_id) {
-                                opponent_fd = match->black_player.socket_fd;
-                            } else if (match->black_player.user_id == player_id) {
-                                opponent_fd = match->white_player.socket_fd;
-                            }
-                            
-                            if (opponent_fd > 0 && opponent_fd != session->socket_fd) {
-                                char notify[] = "OPPONENT_REMATCH_REQUEST\n";
-                                send(opponent_fd, notify, strlen(notify), 0);
-                            }
+                        int opponent_fd = -1;
+                        if (match->white_player.user_id == player_id) {
+                            opponent_fd = match->black_player.socket_fd;
+                        } else if (match->black_player.user_id == player_id) {
+                            opponent_fd = match->white_player.socket_fd;
                         }
                         
-                        printf("[Control] Player %d requested rematch in match %d\n", 
+                        if (opponent_fd > 0 && opponent_fd != session->socket_fd) {
+                            char notify[] = "OPPONENT_REMATCH_REQUEST\n";
+                            send_to_client(opponent_fd, notify);
+                        }
+                        
+                        LOG_INFO("[Control] Player %d requested rematch in match %d\n", 
                                player_id, match_id);
                     } else {
                         char error[] = "ERROR|Player not found or already has pending action\n";
-                        send(session->socket_fd, error, strlen(error), 0);
+                        send_to_client(session->socket_fd, error);
                     }
                 } else {
                     char error[] = "ERROR|Failed to record rematch request\n";
-                    send(session->socket_fd, error, strlen(error), 0);
+                    send_to_client(session->socket_fd, error);
                 }
                 PQclear(res);
             } else {
                 char error[] = "ERROR|Game is not finished\n";
-                send(session->socket_fd, error, strlen(error), 0);
+                send_to_client(session->socket_fd, error);
             }
         } else {
             char error[] = "ERROR|Match not found\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
         }
         PQclear(check_res);
+        game_match_release(match);
     }
 }
 
@@ -461,7 +466,7 @@ void handle_rematch_accept(ClientSession *session, int num_params, char *param1,
     int old_match_id = atoi(param1);
     int player_id = atoi(param2);
 
-    printf("[Rematch] Processing REMATCH_ACCEPT for match %d by player %d\n",
+    LOG_INFO("[Rematch] Processing REMATCH_ACCEPT for match %d by player %d\n",
            old_match_id, player_id);
 
     // Kiểm tra rematch request từ đối thủ
@@ -471,17 +476,17 @@ void handle_rematch_accept(ClientSession *session, int num_params, char *param1,
              "WHERE match_id=%d AND action_state='rematch_request' AND user_id != %d",
              old_match_id, player_id);
 
-    PGresult *check_res = PQexec(db, check_query);
+    PGresult *check_res = db_exec(db, check_query);
     if (PQresultStatus(check_res) != PGRES_TUPLES_OK || PQntuples(check_res) == 0) {
-        send(session->socket_fd, "ERROR|No rematch request pending\n", 32, 0);
+        send_to_client(session->socket_fd, "ERROR|No rematch request pending\n");
         PQclear(check_res);
         return;
     }
 
     // Lấy thông tin match cũ
-    GameMatch *old_match = game_manager_find_match(&game_manager, old_match_id);
+    GameMatch *old_match = game_manager_acquire_match(&game_manager, old_match_id);
     if (!old_match) {
-        send(session->socket_fd, "ERROR|Old match not found\n", 26, 0);
+        send_to_client(session->socket_fd, "ERROR|Old match not found\n");
         PQclear(check_res);
         return;
     }
@@ -494,15 +499,16 @@ void handle_rematch_accept(ClientSession *session, int num_params, char *param1,
 
     int old_white_fd = old_match->white_player.socket_fd;
     int old_black_fd = old_match->black_player.socket_fd;
+    game_match_release(old_match);
 
     // Tạo match mới trong DB
     char create_query[512];
     snprintf(create_query, sizeof(create_query),
              "INSERT INTO match_game (type, status, starttime) "
              "VALUES ('pvp', 'playing', NOW()) RETURNING match_id");
-    PGresult *new_match_res = PQexec(db, create_query);
+    PGresult *new_match_res = db_exec(db, create_query);
     if (PQresultStatus(new_match_res) != PGRES_TUPLES_OK || PQntuples(new_match_res) == 0) {
-        send(session->socket_fd, "ERROR|Failed to create new match\n", 33, 0);
+        send_to_client(session->socket_fd, "ERROR|Failed to create new match\n");
         PQclear(check_res);
         return;
     }
@@ -515,7 +521,7 @@ void handle_rematch_accept(ClientSession *session, int num_params, char *param1,
              "INSERT INTO match_player (match_id, user_id, color, action_state) VALUES "
              "(%d, %d, 'white', 'normal'), (%d, %d, 'black', 'normal')",
              new_match_id, white_user_id, new_match_id, black_user_id);
-    PQexec(db, insert_query);
+    db_exec(db, insert_query);
 
     // Clear action_state cũ
     char clear_query[512];
@@ -523,7 +529,7 @@ void handle_rematch_accept(ClientSession *session, int num_params, char *param1,
              "UPDATE match_player SET action_state='normal' "
              "WHERE match_id=%d AND action_state='rematch_request'",
              old_match_id);
-    PQexec(db, clear_query);
+    db_exec(db, clear_query);
 
     // Tạo match mới trong memory và giữ socket cũ
     pthread_mutex_lock(&game_manager.lock);
@@ -551,8 +557,9 @@ void handle_rematch_accept(ClientSession *session, int num_params, char *param1,
         new_match->black_player.is_online = (old_black_fd > 0) ? 1 : 0;
         strcpy(new_match->black_player.username, black_username);
 
-        chess_board_init(&new_match->board);
+        game_match_init_board(new_match);
         pthread_mutex_init(&new_match->lock, NULL);
+        new_match->refs = 1;    // The manager's
 
         game_manager.matches[game_manager.match_count++] = new_match;
     }
@@ -563,17 +570,17 @@ void handle_rematch_accept(ClientSession *session, int num_params, char *param1,
     snprintf(response, sizeof(response), "REMATCH_START|%d|%s\n",
             new_match_id,
             (session->socket_fd == old_white_fd) ? "white" : "black");
-    send(session->socket_fd, response, strlen(response), 0);
+    send_to_client(session->socket_fd, response);
 
     int opponent_fd = (old_white_fd == session->socket_fd) ? old_black_fd : old_white_fd;
     if (opponent_fd > 0 && opponent_fd != session->socket_fd) {
         snprintf(response, sizeof(response), "REMATCH_START|%d|%s\n",
                 new_match_id,
                 (opponent_fd == old_white_fd) ? "white" : "black");
-        send(opponent_fd, response, strlen(response), 0);
+        send_to_client(opponent_fd, response);
     }
 
-    printf("[Rematch] New match %d started, white=%d, black=%d\n",
+    LOG_INFO("[Rematch] New match %d started, white=%d, black=%d\n",
            new_match_id, white_user_id, black_user_id);
 
     PQclear(check_res);
@@ -586,17 +593,17 @@ void handle_rematch_decline(ClientSession *session, int num_params, char *param1
     // REMATCH_DECLINE|match_id|player_id
     if (num_params < 3) {
         char error[] = "ERROR|Invalid REMATCH_DECLINE command format\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
         return;
     }
 
     int match_id = atoi(param1);
     int decliner_id = atoi(param2);
-    GameMatch *match = game_manager_find_match(&game_manager, match_id);
+    GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
 
     if (!match) {
         char error[] = "ERROR|Match not found\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
         return;
     }
 
@@ -615,7 +622,7 @@ void handle_rematch_decline(ClientSession *session, int num_params, char *param1
                  "WHERE match_id=%d AND user_id=%d AND action_state='rematch_request'",
                  match_id, requester_id);
         
-        PGresult *res = PQexec(db, query);
+        PGresult *res = db_exec(db, query);
         if (PQresultStatus(res) == PGRES_COMMAND_OK) {
             int rows_affected = atoi(PQcmdTuples(res));
             if (rows_affected > 0) {
@@ -627,28 +634,28 @@ void handle_rematch_decline(ClientSession *session, int num_params, char *param1
                     char notify[256];
                     snprintf(notify, sizeof(notify),
                              "REMATCH_DECLINED_BY_OPPONENT|%d\n", decliner_id);
-                    send(requester_fd, notify, strlen(notify), 0);
+                    send_to_client(requester_fd, notify);
                 }
 
                 // Gửi ACK cho người từ chối
                 char response[] = "REMATCH_DECLINED\n";
-                send(session->socket_fd, response, strlen(response), 0);
+                send_to_client(session->socket_fd, response);
 
-                printf("[Control] Rematch declined in match %d (DB updated)\n", match_id);
+                LOG_INFO("[Control] Rematch declined in match %d (DB updated)\n", match_id);
             } else {
                 char error[] = "ERROR|No rematch request found to decline\n";
-                send(session->socket_fd, error, strlen(error), 0);
+                send_to_client(session->socket_fd, error);
             }
         } else {
             char error[] = "ERROR|Failed to update rematch status\n";
-            send(session->socket_fd, error, strlen(error), 0);
-            printf("[Control] Database error declining rematch: %s\n", PQerrorMessage(db));
+            send_to_client(session->socket_fd, error);
+            LOG_WARN("[Control] Database error declining rematch: %s\n", PQerrorMessage(db));
         }
         PQclear(res);
     } else {
         char error[] = "ERROR|No rematch request pending or you are the requester\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
     }
 
-    pthread_mutex_unlock(&match->lock);
+    pthread_mutex_unlock(&match->lock);    game_match_release(match);
 }
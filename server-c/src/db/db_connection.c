@@ -1,5 +1,7 @@
 
 #include "database.h"
+#include "log.h"
+#include "server_stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -16,7 +18,7 @@ PGconn* db_connect() {
     PGconn *conn = PQconnectdb(conninfo);
 
     if (PQstatus(conn) != CONNECTION_OK) {
-        fprintf(stderr, "[DB] Connection failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Connection failed: %s\n", PQerrorMessage(conn));
         PQfinish(conn);
         return NULL;
     }
@@ -26,14 +28,14 @@ PGconn* db_connect() {
         PQsetClientEncoding(conn, "UTF8");
     }
 
-    printf("[DB] Connected successfully\n");
+    LOG_INFO("[DB] Connected successfully\n");
     return conn;
 }
 
 void db_disconnect(PGconn *conn) {
     if (conn != NULL) {
         PQfinish(conn);
-        printf("[DB] Disconnected\n");
+        LOG_INFO("[DB] Disconnected\n");
     }
 }
 
@@ -41,9 +43,29 @@ int db_check_connection(PGconn *conn) {
     if (conn == NULL) return 0;
 
     if (PQstatus(conn) != CONNECTION_OK) {
-        fprintf(stderr, "[DB] Lost connection: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Lost connection: %s\n", PQerrorMessage(conn));
         return 0;
     }
 
     return 1;
 }
+
+// Query wrappers: every statement goes through these so the time spent
+// waiting on PostgreSQL is charged to the command running on this thread
+PGresult* db_exec(PGconn *conn, const char *query) {
+    uint64_t start = server_stats_now_ns();
+    PGresult *res = PQexec(conn, query);
+    server_stats_add_db_time(server_stats_now_ns() - start);
+    return res;
+}
+
+PGresult* db_exec_params(PGconn *conn, const char *command, int n_params,
+                         const Oid *param_types, const char *const *param_values,
+                         const int *param_lengths, const int *param_formats,
+                         int result_format) {
+    uint64_t start = server_stats_now_ns();
+    PGresult *res = PQexecParams(conn, command, n_params, param_types, param_values,
+                                 param_lengths, param_formats, result_format);
+    server_stats_add_db_time(server_stats_now_ns() - start);
+    return res;
+}
@@ -1,4 +1,5 @@
 #include "database.h"
+#include "log.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,10 +12,10 @@ int db_create_match(PGconn *conn, int user1_id, int user2_id, const char *type)
                        "VALUES ($1, 'playing', NOW()) RETURNING match_id";
     
     const char *values[1] = {type};
-    PGresult *res = PQexecParams(conn, query, 1, NULL, values, NULL, NULL, 0);
+    PGresult *res = db_exec_params(conn, query, 1, NULL, values, NULL, NULL, 0);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        fprintf(stderr, "[DB] Create match failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Create match failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return -1;
     }
@@ -29,17 +30,17 @@ int db_create_match(PGconn *conn, int user1_id, int user2_id, const char *type)
         "(%d, %d, 'white', false), (%d, %d, 'black', false)",
         match_id, user1_id, match_id, user2_id);
     
-    res = PQexec(conn, insert_players);
+    res = db_exec(conn, insert_players);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        fprintf(stderr, "[DB] Insert players failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Insert players failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return -1;
     }
     
     PQclear(res);
     
-    printf("[DB] Created match %d: user %d vs user %d\n", match_id, user1_id, user2_id);
+    LOG_INFO("[DB] Created match %d: user %d vs user %d\n", match_id, user1_id, user2_id);
     
     return match_id;
 }
@@ -53,10 +54,10 @@ int db_create_bot_match(PGconn *conn, int user_id, const char *type) {
                        "VALUES ($1, 'playing', NOW()) RETURNING match_id";
     
     const char *values[1] = {type};
-    PGresult *res = PQexecParams(conn, query, 1, NULL, values, NULL, NULL, 0);
+    PGresult *res = db_exec_params(conn, query, 1, NULL, values, NULL, NULL, 0);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        fprintf(stderr, "[DB] Create bot match failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Create bot match failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return -1;
     }
@@ -71,17 +72,17 @@ int db_create_bot_match(PGconn *conn, int user_id, const char *type) {
         "(%d, %d, 'white', false), (%d, NULL, 'black', true)",
         match_id, user_id, match_id);
     
-    res = PQexec(conn, insert_players);
+    res = db_exec(conn, insert_players);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        fprintf(stderr, "[DB] Insert bot match players failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Insert bot match players failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return -1;
     }
     
     PQclear(res);
     
-    printf("[DB] Created bot match %d: user %d vs AI Bot\n", match_id, user_id);
+    LOG_INFO("[DB] Created bot match %d: user %d vs AI Bot\n", match_id, user_id);
     
     return match_id;
 }
@@ -111,17 +112,17 @@ int db_update_match_status(PGconn *conn, int match_id, const char *status,
             "UPDATE match_game SET status='%s', endtime=NOW(), result='%s' WHERE match_id=%d",
             status, safe_result, match_id);
     }
-    res = PQexec(conn, query);
+    res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        fprintf(stderr, "[DB] Update match status failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Update match status failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return 0;
     }
     
     PQclear(res);
     
-    printf("[DB] Updated match %d status to %s\n", match_id, status);
+    LOG_INFO("[DB] Updated match %d status to %s\n", match_id, status);
     
     return 1;
 }
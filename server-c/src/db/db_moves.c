@@ -1,4 +1,5 @@
 #include "database.h"
+#include "log.h"
 #include <stdio.h>
 #include <string.h>
 
@@ -17,10 +18,10 @@ int db_save_move(PGconn *conn, int match_id, int user_id,
         "VALUES (%d, %d, '%s', '%s', NOW())",
         match_id, user_id, notation, escaped_fen);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        fprintf(stderr, "[DB] Save move failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Save move failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return 0;
     }
@@ -43,16 +44,16 @@ int db_save_bot_move(PGconn *conn, int match_id, const char *notation, const cha
         "VALUES (%d, NULL, '%s', '%s', NOW())",
         match_id, notation, escaped_fen);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        fprintf(stderr, "[DB] Save bot move failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Save bot move failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return 0;
     }
     
     PQclear(res);
-    printf("[DB] Saved bot move: %s for match %d\n", notation, match_id);
+    LOG_DEBUG("[DB] Saved bot move: %s for match %d\n", notation, match_id);
     return 1;
 }
 
@@ -68,10 +69,10 @@ int db_get_match_moves(PGconn *conn, int match_id, char *output, int output_size
         "FROM move WHERE match_id = %d ORDER BY move_id ASC",
         match_id);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        fprintf(stderr, "[DB] Get match moves failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Get match moves failed: %s\n", PQerrorMessage(conn));
         snprintf(output, output_size, "ERROR|Failed to get match moves\n");
         PQclear(res);
         return 0;
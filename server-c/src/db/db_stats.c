@@ -1,5 +1,6 @@
 #include "database.h"
 #include "history.h"
+#include "log.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -22,10 +23,10 @@ int db_get_user_matches(PGconn *conn, int user_id, char *output, int output_size
         "ORDER BY mg.starttime DESC LIMIT 50",
         user_id);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        fprintf(stderr, "[DB] Get user matches failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Get user matches failed: %s\n", PQerrorMessage(conn));
         snprintf(output, output_size, "ERROR|Failed to get match history\n");
         PQclear(res);
         return 0;
@@ -84,7 +85,7 @@ int db_get_user_stats(PGconn *conn, int user_id, char *output, int output_size)
         "GROUP BY u.elo_point",
         user_id);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
         // No matches yet, return default stats
@@ -125,10 +126,10 @@ int db_update_user_stats(PGconn *conn, int user_id, const char *result) {
         return 1;
     }
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        fprintf(stderr, "[DB] Update user stats failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Update user stats failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return 0;
     }
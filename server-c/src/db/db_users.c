@@ -1,4 +1,5 @@
 #include "database.h"
+#include "log.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -32,10 +33,10 @@ int db_create_user(PGconn *conn, const char *username, const char *password) {
         "VALUES ('%s', '%s', 1200) RETURNING user_id",
         escaped_username, hashstr);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        fprintf(stderr, "[DB] Create user failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Create user failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return 0;
     }
@@ -43,7 +44,7 @@ int db_create_user(PGconn *conn, const char *username, const char *password) {
     int user_id = atoi(PQgetvalue(res, 0, 0));
     PQclear(res);
     
-    printf("[DB] Created user '%s' with ID %d\n", username, user_id);
+    LOG_INFO("[DB] Created user '%s' with ID %d\n", username, user_id);
     return user_id;
 }
 
@@ -64,7 +65,7 @@ int db_verify_user(PGconn *conn, const char *username, const char *password) {
         "SELECT user_id FROM users WHERE name = '%s' AND password_hash = '%s'",
         escaped_username, hashstr);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
         PQclear(res);
@@ -88,7 +89,7 @@ int db_get_user_info(PGconn *conn, int user_id, char *output, int output_size) {
         "SELECT name, elo_point FROM users WHERE user_id = %d",
         user_id);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
         snprintf(output, output_size, "ERROR|User not found\n");
@@ -118,7 +119,7 @@ int db_get_user_email(PGconn *conn, const char *email_input, char *email, int em
         "SELECT email, user_id FROM users WHERE email = '%s'",
         escaped_email);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
         PQclear(res);
@@ -148,7 +149,7 @@ int db_save_otp(PGconn *conn, int user_id, const char *otp) {
     // Delete old OTP first
     snprintf(query, sizeof(query),
         "DELETE FROM password_reset WHERE user_id = %d", user_id);
-    PQexec(conn, query);
+    db_exec(conn, query);
     
     // Insert new OTP (expires in 10 minutes)
     snprintf(query, sizeof(query),
@@ -156,10 +157,10 @@ int db_save_otp(PGconn *conn, int user_id, const char *otp) {
         "VALUES (%d, '%s', NOW() + INTERVAL '10 minutes')",
         user_id, escaped_otp);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        fprintf(stderr, "[DB] Save OTP failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Save OTP failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return 0;
     }
@@ -181,7 +182,7 @@ int db_verify_otp(PGconn *conn, int user_id, const char *otp) {
         "WHERE user_id = %d AND otp = '%s' AND expires_at > NOW()",
         user_id, escaped_otp);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
         PQclear(res);
@@ -212,10 +213,10 @@ int db_reset_password(PGconn *conn, int user_id, const char *new_password, const
         "UPDATE users SET password_hash = '%s' WHERE user_id = %d",
         hashstr, user_id);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        fprintf(stderr, "[DB] Reset password failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Reset password failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return 0;
     }
@@ -225,8 +226,8 @@ int db_reset_password(PGconn *conn, int user_id, const char *new_password, const
     // Delete used OTP
     snprintf(query, sizeof(query),
         "DELETE FROM password_reset WHERE user_id = %d", user_id);
-    PQexec(conn, query);
+    db_exec(conn, query);
     
-    printf("[DB] Password reset successful for user_id %d\n", user_id);
+    LOG_INFO("[DB] Password reset successful for user_id %d\n", user_id);
     return 1;
 }
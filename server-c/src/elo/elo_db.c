@@ -9,7 +9,7 @@ int elo_get_player_rating(PGconn *db, int user_id) {
     if (!db_check_connection(db)) return ELO_DEFAULT;
     char query[256];
     snprintf(query, sizeof(query), "SELECT elo_point FROM users WHERE user_id = %d", user_id);
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
     if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
         PQclear(res);
         return ELO_DEFAULT;
@@ -27,7 +27,7 @@ int elo_get_player_games_count(PGconn *db, int user_id) {
         "JOIN match_game mg ON mp.match_id = mg.match_id "
         "WHERE mp.user_id = %d AND mg.status = 'finished' AND mg.type = 'pvp'",
         user_id);
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
     if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
         PQclear(res);
         return 0;
@@ -63,14 +63,14 @@ int elo_update_ratings(PGconn *db, int winner_id, int loser_id, EloChange *winne
     }
     char query[512];
     snprintf(query, sizeof(query), "UPDATE users SET elo_point = %d WHERE user_id = %d", winner_new_elo, winner_id);
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
         PQclear(res);
         return 0;
     }
     PQclear(res);
     snprintf(query, sizeof(query), "UPDATE users SET elo_point = %d WHERE user_id = %d", loser_new_elo, loser_id);
-    res = PQexec(db, query);
+    res = db_exec(db, query);
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
         PQclear(res);
         return 0;
@@ -80,12 +80,12 @@ int elo_update_ratings(PGconn *db, int winner_id, int loser_id, EloChange *winne
         "UPDATE match_player SET score = 1 WHERE user_id = %d AND match_id = "
         "(SELECT match_id FROM match_game WHERE winner_id = %d ORDER BY endtime DESC LIMIT 1)",
         winner_id, winner_id);
-    PQexec(db, query);
+    db_exec(db, query);
     snprintf(query, sizeof(query),
         "UPDATE match_player SET score = 0 WHERE user_id = %d AND match_id = "
         "(SELECT match_id FROM match_game WHERE winner_id = %d ORDER BY endtime DESC LIMIT 1)",
         loser_id, winner_id);
-    PQexec(db, query);
+    db_exec(db, query);
     return 1;
 }
 
@@ -115,15 +115,15 @@ int elo_update_draw(PGconn *db, int player1_id, int player2_id, EloChange *p1_ch
     }
     char query[512];
     snprintf(query, sizeof(query), "UPDATE users SET elo_point = %d WHERE user_id = %d", p1_new_elo, player1_id);
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
     PQclear(res);
     snprintf(query, sizeof(query), "UPDATE users SET elo_point = %d WHERE user_id = %d", p2_new_elo, player2_id);
-    res = PQexec(db, query);
+    res = db_exec(db, query);
     PQclear(res);
     snprintf(query, sizeof(query),
         "UPDATE match_player SET score = 0.5 WHERE user_id IN (%d, %d) AND match_id = "
         "(SELECT match_id FROM match_game WHERE result = 'draw' ORDER BY endtime DESC LIMIT 1)",
         player1_id, player2_id);
-    PQexec(db, query);
+    db_exec(db, query);
     return 1;
 }
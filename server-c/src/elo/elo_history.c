@@ -11,7 +11,7 @@ int elo_save_history(PGconn *db, int user_id, int match_id, int old_elo, int new
              "INSERT INTO elo_history (user_id, match_id, old_elo, new_elo, elo_change) "
              "VALUES (%d, %d, %d, %d, %d)",
              user_id, match_id, old_elo, new_elo, change);
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
         PQclear(res);
         return 0;
@@ -32,7 +32,7 @@ int elo_get_history(PGconn *db, int user_id, char *output, int output_size) {
              "FROM elo_history WHERE user_id = %d "
              "ORDER BY created_at DESC LIMIT 50",
              user_id);
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         snprintf(output, output_size, "ELO_HISTORY|0\n");
         PQclear(res);
@@ -1,5 +1,6 @@
 #include "elo_leaderboard.h"
 #include "database.h"
+#include "log.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -23,9 +24,9 @@ int elo_get_leaderboard(PGconn *db, char *output, int output_size, int limit) {
              "ORDER BY u.elo_point DESC "
              "LIMIT %d",
              limit);
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        fprintf(stderr, "[ELO] Leaderboard query failed: %s\n", PQerrorMessage(db));
+        LOG_ERROR("[ELO] Leaderboard query failed: %s\n", PQerrorMessage(db));
         snprintf(output, output_size, "ERROR|Failed to get leaderboard\n");
         PQclear(res);
         return 0;
@@ -0,0 +1,538 @@
+#include "engine.h"
+#include <stdint.h>
+#include <time.h>
+
+#define SCORE_INFINITE 32000
+#define MATE_BOUND (ENGINE_MATE - ENGINE_MAX_PLY)   // Scores beyond this are mates
+#define CHECK_EVERY_NODES 2048                      // How often the limits are polled
+#define DELTA_MARGIN 200                            // Positional slack for quiescence pruning
+
+// ============ TRANSPOSITION TABLE ============
+
+enum { BOUND_EXACT, BOUND_LOWER, BOUND_UPPER };
+
+// 16 bytes; the full key is kept, so a hit is (up to collisions) the same position
+typedef struct {
+    ZobristKey key;
+    uint16_t move;          // move_code() of the best move, 0 if none
+    int16_t score;
+    int8_t depth;
+    uint8_t bound;
+    uint8_t generation;     // Search that stored it; older entries are replaced first
+} TTEntry;
+
+struct Engine {
+    TTEntry *table;
+    size_t table_mask;
+    uint8_t generation;
+
+    // Per search
+    ChessBoard board;
+    const RepetitionTable *history;
+    ZobristKey path[ENGINE_MAX_PLY + 1];            // Position keys from the root
+    uint16_t killers[ENGINE_MAX_PLY][2];
+    int history_score[2][64][64];                   // [color][from][to] of quiet cutoff moves
+    unsigned long nodes;
+    unsigned long node_limit;
+    double deadline;
+    const int *stop;
+    int can_stop;                                   // Off during depth 1
+    int stopped;
+    unsigned int seed;
+};
+
+static double now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000.0 + ts.tv_nsec / 1e6;
+}
+
+static inline int square_from(const Move *move) {
+    return SQUARE(move->from_row, move->from_col);
+}
+
+static inline int square_to(const Move *move) {
+    return SQUARE(move->to_row, move->to_col);
+}
+
+static inline int piece_kind(char piece) {
+    return piece_bb_index(piece) % PIECE_KINDS;
+}
+
+// Compact move identity for the TT and killers: from, to and promotion kind.
+// Never 0 for a real move since from != to.
+static inline uint16_t move_code(const Move *move) {
+    int promotion = move->is_promotion ? piece_kind(move->promotion_piece) : 0;
+    return (uint16_t)(square_from(move) | (square_to(move) << 6) | (promotion << 12));
+}
+
+static inline int is_capture(const Move *move) {
+    return move->captured_piece != EMPTY || move->is_en_passant;
+}
+
+// Mate scores are stored relative to the node, not the root
+static inline int score_to_tt(int score, int ply) {
+    if (score > MATE_BOUND) return score + ply;
+    if (score < -MATE_BOUND) return score - ply;
+    return score;
+}
+
+static inline int score_from_tt(int score, int ply) {
+    if (score > MATE_BOUND) return score - ply;
+    if (score < -MATE_BOUND) return score + ply;
+    return score;
+}
+
+static TTEntry* tt_probe(Engine *engine, ZobristKey key) {
+    TTEntry *entry = &engine->table[key & engine->table_mask];
+    return entry->key == key ? entry : NULL;
+}
+
+static void tt_store(Engine *engine, ZobristKey key, int depth, int score, int bound,
+                     uint16_t move, int ply) {
+    TTEntry *entry = &engine->table[key & engine->table_mask];
+
+    // Keep a deeper entry of this search for another position
+    if (entry->key != key && entry->generation == engine->generation && entry->depth > depth) {
+        return;
+    }
+    // A fail-low has no best move; keep the one found earlier
+    if (move == 0 && entry->key == key) move = entry->move;
+
+    entry->key = key;
+    entry->move = move;
+    entry->score = (int16_t)score_to_tt(score, ply);
+    entry->depth = (int8_t)depth;
+    entry->bound = (uint8_t)bound;
+    entry->generation = engine->generation;
+}
+
+// ============ MOVE ORDERING ============
+
+#define ORDER_TT_MOVE   (1 << 30)
+#define ORDER_CAPTURE   (1 << 20)
+#define ORDER_KILLER    (1 << 19)
+#define HISTORY_MAX     (1 << 18)
+
+static void score_moves(Engine *engine, const MoveList *list, int *scores, uint16_t tt_move,
+                        int ply) {
+    PlayerColor us = engine->board.current_turn;
+
+    for (int i = 0; i < list->count; i++) {
+        const Move *move = &list->moves[i];
+        uint16_t code = move_code(move);
+
+        if (code == tt_move) {
+            scores[i] = ORDER_TT_MOVE;
+        } else if (is_capture(move) || move->is_promotion) {
+            // MVV-LVA: most valuable victim first, cheapest attacker breaks ties
+            int victim = move->is_en_passant ? PIECE_PAWN
+                       : (move->captured_piece != EMPTY ? piece_kind(move->captured_piece) : -1);
+            int gain = (victim >= 0 ? engine_piece_value[victim] : 0);
+            if (move->is_promotion) gain += engine_piece_value[piece_kind(move->promotion_piece)];
+            scores[i] = ORDER_CAPTURE + gain * 8 - piece_kind(move->piece);
+        } else if (ply < ENGINE_MAX_PLY && code == engine->killers[ply][0]) {
+            scores[i] = ORDER_KILLER;
+        } else if (ply < ENGINE_MAX_PLY && code == engine->killers[ply][1]) {
+            scores[i] = ORDER_KILLER - 1;
+        } else {
+            scores[i] = engine->history_score[us][square_from(move)][square_to(move)];
+        }
+    }
+}
+
+// Selection sort step: swap the best remaining move into slot i
+static void pick_move(MoveList *list, int *scores, int i) {
+    int best = i;
+    for (int j = i + 1; j < list->count; j++) {
+        if (scores[j] > scores[best]) best = j;
+    }
+    if (best != i) {
+        Move move = list->moves[i];
+        list->moves[i] = list->moves[best];
+        list->moves[best] = move;
+        int score = scores[i];
+        scores[i] = scores[best];
+        scores[best] = score;
+    }
+}
+
+static void record_cutoff(Engine *engine, const Move *move, int depth, int ply) {
+    uint16_t code = move_code(move);
+    if (ply < ENGINE_MAX_PLY && engine->killers[ply][0] != code) {
+        engine->killers[ply][1] = engine->killers[ply][0];
+        engine->killers[ply][0] = code;
+    }
+
+    int *history = &engine->history_score[engine->board.current_turn][square_from(move)][square_to(move)];
+    *history += depth * depth;
+    if (*history >= HISTORY_MAX) {
+        // Age everything so the scores stay below the killer range
+        for (int c = 0; c < 2; c++)
+            for (int f = 0; f < 64; f++)
+                for (int t = 0; t < 64; t++) engine->history_score[c][f][t] /= 2;
+    }
+}
+
+// ============ SEARCH ============
+
+static void check_limits(Engine *engine) {
+    if (engine->stop && __atomic_load_n(engine->stop, __ATOMIC_RELAXED)) {
+        engine->stopped = 1;
+        return;
+    }
+    if (!engine->can_stop) return;
+    if (engine->nodes >= engine->node_limit || now_ms() >= engine->deadline) {
+        engine->stopped = 1;
+    }
+}
+
+// Drawn by rule at this node: 50 moves, a repeated position or bare kings.
+// A repetition inside the search counts once; so does a return to any
+// position of the game since its last irreversible move.
+static int is_draw(Engine *engine, int ply) {
+    const ChessBoard *board = &engine->board;
+    if (board->halfmove_clock >= 100) return 1;
+
+    ZobristKey key = board->hash;
+    int reversible = board->halfmove_clock;
+    for (int back = 4; back <= reversible && back <= ply; back += 2) {
+        if (engine->path[ply - back] == key) return 1;
+    }
+    if (engine->history && reversible >= ply && repetition_table_count(engine->history, key) > 0) {
+        return 1;
+    }
+    return is_insufficient_material(board);
+}
+
+// Pass: only the side to move and the en passant square change
+typedef struct {
+    ZobristKey hash;
+    int en_passant_file;
+    int en_passant_rank;
+} NullUndo;
+
+static void make_null_move(ChessBoard *board, NullUndo *undo) {
+    undo->hash = board->hash;
+    undo->en_passant_file = board->en_passant_file;
+    undo->en_passant_rank = board->en_passant_rank;
+
+    board->hash ^= chess_board_state_key(board);
+    board->current_turn = (board->current_turn == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    board->en_passant_file = -1;
+    board->en_passant_rank = -1;
+    board->hash ^= chess_board_state_key(board);
+    board->fen_dirty = 1;
+}
+
+static void unmake_null_move(ChessBoard *board, const NullUndo *undo) {
+    board->current_turn = (board->current_turn == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    board->en_passant_file = undo->en_passant_file;
+    board->en_passant_rank = undo->en_passant_rank;
+    board->hash = undo->hash;
+    board->fen_dirty = 1;
+}
+
+static int has_non_pawn_material(const ChessBoard *board, PlayerColor color) {
+    const Bitboard *own = &board->pieces[BB_INDEX(color, 0)];
+    return (own[PIECE_KNIGHT] | own[PIECE_BISHOP] | own[PIECE_ROOK] | own[PIECE_QUEEN]) != 0;
+}
+
+// Captures and promotions only, until the position is quiet
+static int quiescence(Engine *engine, int alpha, int beta, int ply) {
+    ChessBoard *board = &engine->board;
+
+    if ((++engine->nodes & (CHECK_EVERY_NODES - 1)) == 0) check_limits(engine);
+    if (engine->stopped) return 0;
+
+    int stand_pat = engine_evaluate(board);
+    if (stand_pat >= beta || ply >= ENGINE_MAX_PLY) return stand_pat;
+    if (stand_pat > alpha) alpha = stand_pat;
+
+    MoveList list;
+    int scores[MAX_MOVES];
+    PlayerColor us = board->current_turn;
+    generate_pseudo_legal_moves(board, us, &list);
+
+    // Keep the tactical moves that could still lift the score to alpha;
+    // under-promotions are not worth the nodes
+    int kept = 0;
+    for (int i = 0; i < list.count; i++) {
+        const Move *move = &list.moves[i];
+        if (move->is_promotion) {
+            if (piece_kind(move->promotion_piece) == PIECE_QUEEN) list.moves[kept++] = *move;
+        } else if (is_capture(move)) {
+            int victim = move->is_en_passant ? PIECE_PAWN : piece_kind(move->captured_piece);
+            if (stand_pat + engine_piece_value[victim] + DELTA_MARGIN > alpha) {
+                list.moves[kept++] = *move;
+            }
+        }
+    }
+    list.count = kept;
+    score_moves(engine, &list, scores, 0, ENGINE_MAX_PLY);
+
+    for (int i = 0; i < list.count; i++) {
+        pick_move(&list, scores, i);
+        const Move *move = &list.moves[i];
+
+        MoveUndo undo;
+        make_move(board, move, &undo);
+        if (is_king_in_check(board, us)) {
+            unmake_move(board, move, &undo);
+            continue;
+        }
+        int score = -quiescence(engine, -beta, -alpha, ply + 1);
+        unmake_move(board, move, &undo);
+
+        if (engine->stopped) return 0;
+        if (score >= beta) return score;
+        if (score > alpha) alpha = score;
+    }
+    return alpha;
+}
+
+static int search(Engine *engine, int depth, int alpha, int beta, int ply, int allow_null) {
+    ChessBoard *board = &engine->board;
+    PlayerColor us = board->current_turn;
+
+    engine->path[ply] = board->hash;
+    if (ply > 0 && is_draw(engine, ply)) return 0;
+    if (ply >= ENGINE_MAX_PLY) return engine_evaluate(board);
+
+    int in_check = is_king_in_check(board, us);
+    if (in_check) depth++;          // Check extension
+    if (depth <= 0) return quiescence(engine, alpha, beta, ply);
+
+    if ((++engine->nodes & (CHECK_EVERY_NODES - 1)) == 0) check_limits(engine);
+    if (engine->stopped) return 0;
+
+    int pv_node = (beta - alpha > 1);
+    uint16_t tt_move = 0;
+    TTEntry *entry = tt_probe(engine, board->hash);
+    if (entry) {
+        tt_move = entry->move;
+        if (!pv_node && entry->depth >= depth) {
+            int score = score_from_tt(entry->score, ply);
+            if (entry->bound == BOUND_EXACT ||
+                (entry->bound == BOUND_LOWER && score >= beta) ||
+                (entry->bound == BOUND_UPPER && score <= alpha)) {
+                return score;
+            }
+        }
+    }
+
+    // Null move: if passing still fails high, a real move will too. Not in
+    // pawn endings, where passing may be the only thing that would not lose.
+    if (allow_null && !pv_node && !in_check && depth >= 3 && has_non_pawn_material(board, us) &&
+        engine_evaluate(board) >= beta) {
+        NullUndo undo;
+        make_null_move(board, &undo);
+        int score = -search(engine, depth - 3, -beta, -beta + 1, ply + 1, 0);
+        unmake_null_move(board, &undo);
+        if (engine->stopped) return 0;
+        if (score >= beta) return score > MATE_BOUND ? beta : score;
+    }
+
+    MoveList list;
+    int scores[MAX_MOVES];
+    generate_pseudo_legal_moves(board, us, &list);
+    score_moves(engine, &list, scores, tt_move, ply);
+
+    int original_alpha = alpha;
+    int best_score = -SCORE_INFINITE;
+    uint16_t best_move = 0;
+    int legal = 0;
+
+    for (int i = 0; i < list.count; i++) {
+        pick_move(&list, scores, i);
+        const Move *move = &list.moves[i];
+
+        MoveUndo undo;
+        make_move(board, move, &undo);
+        if (is_king_in_check(board, us)) {
+            unmake_move(board, move, &undo);
+            continue;
+        }
+        legal++;
+
+        int quiet = !is_capture(move) && !move->is_promotion;
+        int score;
+        if (legal == 1) {
+            score = -search(engine, depth - 1, -beta, -alpha, ply + 1, 1);
+        } else {
+            // Late quiet moves are searched one ply shallower first
+            int reduction = (quiet && !in_check && depth >= 3 && legal > 4 &&
+                             scores[i] < ORDER_KILLER - 1) ? 1 : 0;
+            score = -search(engine, depth - 1 - reduction, -alpha - 1, -alpha, ply + 1, 1);
+            if (score > alpha && (reduction || score < beta)) {
+                score = -search(engine, depth - 1, -beta, -alpha, ply + 1, 1);
+            }
+        }
+        unmake_move(board, move, &undo);
+        if (engine->stopped) return 0;
+
+        if (score > best_score) {
+            best_score = score;
+            if (score > alpha) {
+                alpha = score;
+                best_move = move_code(move);
+                if (alpha >= beta) {
+                    if (quiet) record_cutoff(engine, move, depth, ply);
+                    break;
+                }
+            }
+        }
+    }
+
+    if (legal == 0) return in_check ? -ENGINE_MATE + ply : 0;
+
+    int bound = (best_score >= beta) ? BOUND_LOWER
+              : (best_score > original_alpha) ? BOUND_EXACT : BOUND_UPPER;
+    tt_store(engine, board->hash, depth, best_score, bound, best_move, ply);
+    return best_score;
+}
+
+// ============ ROOT ============
+
+Engine* engine_create(int tt_mb) {
+    Engine *engine = calloc(1, sizeof(Engine));
+    if (!engine) return NULL;
+
+    // Largest power-of-two entry count that fits
+    size_t entries = 1;
+    size_t budget = (size_t)(tt_mb > 0 ? tt_mb : 1) * 1024 * 1024 / sizeof(TTEntry);
+    while (entries * 2 <= budget) entries *= 2;
+
+    engine->table = calloc(entries, sizeof(TTEntry));
+    if (!engine->table) {
+        free(engine);
+        return NULL;
+    }
+    engine->table_mask = entries - 1;
+    engine->seed = (unsigned int)time(NULL);
+    return engine;
+}
+
+void engine_destroy(Engine *engine) {
+    if (!engine) return;
+    free(engine->table);
+    free(engine);
+}
+
+void engine_limits_for_difficulty(const char *difficulty, EngineLimits *limits) {
+    if (difficulty && strcmp(difficulty, "hard") == 0) {
+        *limits = (EngineLimits){ ENGINE_MAX_PLY, 3000000, 300, 0, NULL };
+    } else if (difficulty && strcmp(difficulty, "medium") == 0) {
+        *limits = (EngineLimits){ 5, 200000, 150, 20, NULL };
+    } else {
+        // Shallow and noisy: sees hanging pieces but not much more
+        *limits = (EngineLimits){ 2, 5000, 50, 150, NULL };
+    }
+}
+
+void engine_move_to_uci(const Move *move, char *out) {
+    coords_to_notation(move->from_row, move->from_col, out);
+    coords_to_notation(move->to_row, move->to_col, out + 2);
+    if (move->is_promotion) {
+        out[4] = (char)(move->promotion_piece | 0x20);
+        out[5] = '\0';
+    }
+}
+
+int engine_search(Engine *engine, const ChessBoard *root, const RepetitionTable *history,
+                  const EngineLimits *limits, EngineResult *result) {
+    double start = now_ms();
+    ChessBoard *board = &engine->board;
+    *board = *root;
+
+    MoveList moves;
+    generate_legal_moves(board, board->current_turn, &moves);
+    if (moves.count == 0) return -1;
+
+    engine->history = history;
+    engine->nodes = 0;
+    engine->node_limit = limits->nodes;
+    engine->deadline = start + limits->time_ms;
+    engine->stop = limits->stop;
+    engine->stopped = 0;
+    engine->generation++;
+    memset(engine->killers, 0, sizeof(engine->killers));
+    memset(engine->history_score, 0, sizeof(engine->history_score));
+    engine->seed ^= (unsigned int)root->hash;
+
+    // The noise is drawn once per search so iterations agree on it
+    int noise[MAX_MOVES];
+    for (int i = 0; i < moves.count; i++) {
+        noise[i] = limits->noise > 0 ? rand_r(&engine->seed) % (limits->noise + 1) : 0;
+    }
+
+    int max_depth = limits->depth;
+    if (max_depth > ENGINE_MAX_PLY - 1) max_depth = ENGINE_MAX_PLY - 1;
+    if (max_depth < 1 || moves.count == 1) max_depth = 1;
+
+    result->best_move = moves.moves[0];
+    result->score = 0;
+    result->depth = 0;
+
+    for (int depth = 1; depth <= max_depth; depth++) {
+        engine->can_stop = (depth > 1);
+        engine->path[0] = board->hash;
+
+        int alpha = -SCORE_INFINITE;
+        int best_index = 0;
+        int best_score = -SCORE_INFINITE;
+
+        for (int i = 0; i < moves.count; i++) {
+            const Move *move = &moves.moves[i];
+            MoveUndo undo;
+            make_move(board, move, &undo);
+
+            int score;
+            if (limits->noise > 0) {
+                // Every move needs an exact score for the noise to compare
+                score = -search(engine, depth - 1, -SCORE_INFINITE, SCORE_INFINITE, 1, 1) + noise[i];
+            } else if (i == 0) {
+                score = -search(engine, depth - 1, -SCORE_INFINITE, SCORE_INFINITE, 1, 1);
+            } else {
+                score = -search(engine, depth - 1, -alpha - 1, -alpha, 1, 1);
+                if (score > alpha && !engine->stopped) {
+                    score = -search(engine, depth - 1, -SCORE_INFINITE, -alpha, 1, 1);
+                }
+            }
+            unmake_move(board, move, &undo);
+            if (engine->stopped) break;
+
+            if (score > best_score) {
+                best_score = score;
+                best_index = i;
+                if (score > alpha) alpha = score;
+            }
+        }
+        // An unfinished iteration is thrown away
+        if (engine->stopped) break;
+
+        // Search the best move first next time
+        Move best = moves.moves[best_index];
+        int best_noise = noise[best_index];
+        for (int i = best_index; i > 0; i--) {
+            moves.moves[i] = moves.moves[i - 1];
+            noise[i] = noise[i - 1];
+        }
+        moves.moves[0] = best;
+        noise[0] = best_noise;
+
+        result->best_move = best;
+        result->score = best_score - best_noise;
+        result->depth = depth;
+
+        if (best_score > MATE_BOUND || best_score < -MATE_BOUND) break;
+        // The next iteration costs several times this one; don't start
+        // what cannot finish
+        double elapsed = now_ms() - start;
+        if (engine->nodes >= engine->node_limit || elapsed * 2 >= limits->time_ms) break;
+    }
+
+    result->nodes = engine->nodes;
+    result->time_ms = (int)(now_ms() - start);
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "engine.h"
+
+// Material plus piece-square tables, tapered between middlegame and endgame
+// by the remaining non-pawn material. Tables are written from white's side
+// with a8 first, which is also the square order of the bitboards; black
+// looks them up with the rank flipped (sq ^ 56).
+
+const int engine_piece_value[PIECE_KINDS] = { 100, 320, 330, 500, 900, 0 };
+
+static const int pawn_table[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+
+static const int knight_table[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50,
+};
+
+static const int bishop_table[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20,
+};
+
+static const int rook_table[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0,
+};
+
+static const int queen_table[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+};
+
+// The king hides behind its pawns while queens and rooks are around and
+// walks to the centre once they are gone
+static const int king_middlegame_table[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20,
+};
+
+static const int king_endgame_table[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50,
+};
+
+static const int *const piece_tables[PIECE_KINDS] = {
+    pawn_table, knight_table, bishop_table, rook_table, queen_table, king_middlegame_table
+};
+
+// Game phase: 24 with all minor and major pieces on the board, 0 without
+static const int phase_weight[PIECE_KINDS] = { 0, 1, 1, 2, 4, 0 };
+#define PHASE_TOTAL 24
+
+#define BISHOP_PAIR_BONUS 30
+
+int engine_evaluate(const ChessBoard *board) {
+    int score[2] = { 0, 0 };
+    int king_middlegame[2] = { 0, 0 };
+    int king_endgame[2] = { 0, 0 };
+    int phase = 0;
+
+    for (int color = COLOR_WHITE; color <= COLOR_BLACK; color++) {
+        int flip = (color == COLOR_WHITE) ? 0 : 56;
+
+        for (int kind = PIECE_PAWN; kind < PIECE_KING; kind++) {
+            Bitboard bb = board->pieces[BB_INDEX(color, kind)];
+            phase += phase_weight[kind] * bb_popcount(bb);
+            while (bb) {
+                int sq = bb_pop_lsb(&bb) ^ flip;
+                score[color] += engine_piece_value[kind] + piece_tables[kind][sq];
+            }
+        }
+        if (bb_popcount(board->pieces[BB_INDEX(color, PIECE_BISHOP)]) >= 2) {
+            score[color] += BISHOP_PAIR_BONUS;
+        }
+
+        Bitboard king = board->pieces[BB_INDEX(color, PIECE_KING)];
+        if (king) {
+            int sq = bb_lsb(king) ^ flip;
+            king_middlegame[color] = king_middlegame_table[sq];
+            king_endgame[color] = king_endgame_table[sq];
+        }
+    }
+
+    // Promotions can push the phase past the opening value
+    if (phase > PHASE_TOTAL) phase = PHASE_TOTAL;
+    for (int color = COLOR_WHITE; color <= COLOR_BLACK; color++) {
+        score[color] += (king_middlegame[color] * phase +
+                         king_endgame[color] * (PHASE_TOTAL - phase)) / PHASE_TOTAL;
+    }
+
+    int white_view = score[COLOR_WHITE] - score[COLOR_BLACK];
+    return (board->current_turn == COLOR_WHITE) ? white_view : -white_view;
+}
@@ -1,5 +1,7 @@
 // friend.c - Friend system handlers
 #include "friend.h"
+#include "log.h"
+#include "database.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -15,7 +17,7 @@ void handle_friend_request(ClientSession *session, int num_params, char *param1,
         int friend_id = atoi(param2);
         if (user_id == friend_id) {
             char error[] = "ERROR|Cannot add yourself as friend\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
             return;
         }
         // Check if already exists
@@ -23,10 +25,10 @@ void handle_friend_request(ClientSession *session, int num_params, char *param1,
         snprintf(check_query, sizeof(check_query),
             "SELECT status FROM friendship WHERE user_id=%d AND friend_id=%d;",
             user_id, friend_id);
-        PGresult *check_res = PQexec(db, check_query);
+        PGresult *check_res = db_exec(db, check_query);
         if (PQresultStatus(check_res) == PGRES_TUPLES_OK && PQntuples(check_res) > 0) {
             char error[] = "ERROR|Friend request already exists\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
             PQclear(check_res);
             return;
         }
@@ -36,14 +38,14 @@ void handle_friend_request(ClientSession *session, int num_params, char *param1,
         snprintf(insert_query, sizeof(insert_query),
             "INSERT INTO friendship (user_id, friend_id, status) VALUES (%d, %d, 'pending');",
             user_id, friend_id);
-        PGresult *insert_res = PQexec(db, insert_query);
+        PGresult *insert_res = db_exec(db, insert_query);
         if (PQresultStatus(insert_res) == PGRES_COMMAND_OK) {
             char response[] = "FRIEND_REQUESTED\n";
-            send(session->socket_fd, response, strlen(response), 0);
-            printf("[Server] Send to client %d: %s", session->socket_fd, response);
+            send_to_client(session->socket_fd, response);
+            LOG_DEBUG("[Server] Send to client %d: %s", session->socket_fd, response);
         } else {
             char error[] = "ERROR|Failed to send friend request\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
         }
         PQclear(insert_res);
     }
@@ -59,20 +61,20 @@ void handle_friend_accept(ClientSession *session, int num_params, char *param1,
         snprintf(update_query, sizeof(update_query),
             "UPDATE friendship SET status='accepted', responded_at=NOW() WHERE user_id=%d AND friend_id=%d AND status='pending';",
             friend_id, user_id);
-        PGresult *update_res = PQexec(db, update_query);
+        PGresult *update_res = db_exec(db, update_query);
         if (PQresultStatus(update_res) == PGRES_COMMAND_OK && atoi(PQcmdTuples(update_res)) > 0) {
             // Insert reverse relation for easy query
             char insert_query[256];
             snprintf(insert_query, sizeof(insert_query),
                 "INSERT INTO friendship (user_id, friend_id, status) VALUES (%d, %d, 'accepted') ON CONFLICT DO NOTHING;",
                 user_id, friend_id);
-            PQexec(db, insert_query);
+            db_exec(db, insert_query);
             char response[] = "FRIEND_ACCEPTED\n";
-            send(session->socket_fd, response, strlen(response), 0);
-            printf("[Server] Send to client %d: %s", session->socket_fd, response);
+            send_to_client(session->socket_fd, response);
+            LOG_DEBUG("[Server] Send to client %d: %s", session->socket_fd, response);
         } else {
             char error[] = "ERROR|No pending request found\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
         }
         PQclear(update_res);
     }
@@ -87,14 +89,14 @@ void handle_friend_decline(ClientSession *session, int num_params, char *param1,
         snprintf(update_query, sizeof(update_query),
             "UPDATE friendship SET status='declined', responded_at=NOW() WHERE user_id=%d AND friend_id=%d AND status='pending';",
             friend_id, user_id);
-        PGresult *update_res = PQexec(db, update_query);
+        PGresult *update_res = db_exec(db, update_query);
         if (PQresultStatus(update_res) == PGRES_COMMAND_OK && atoi(PQcmdTuples(update_res)) > 0) {
             char response[] = "FRIEND_DECLINED\n";
-            send(session->socket_fd, response, strlen(response), 0);
-            printf("[Server] Send to client %d: %s", session->socket_fd, response);
+            send_to_client(session->socket_fd, response);
+            LOG_DEBUG("[Server] Send to client %d: %s", session->socket_fd, response);
         } else {
             char error[] = "ERROR|No pending request found\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
         }
         PQclear(update_res);
     }
@@ -113,7 +115,7 @@ void handle_friend_list(ClientSession *session, int num_params, char *param1, PG
         "WHERE f.user_id=%d AND f.status='accepted';",
         user_id);
 
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
 
     if (PQresultStatus(res) == PGRES_TUPLES_OK) {
         char response[2048] = "FRIEND_LIST|";
@@ -142,10 +144,10 @@ void handle_friend_list(ClientSession *session, int num_params, char *param1, PG
         }
 
         strcat(response, "\n");
-        send(session->socket_fd, response, strlen(response), 0);
+        send_to_client(session->socket_fd, response);
     } else {
         char error[] = "ERROR|Failed to get friend list\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
     }
 
     PQclear(res);
@@ -161,7 +163,7 @@ void handle_friend_requests(ClientSession *session, int num_params, char *param1
             "INNER JOIN friendship f ON u.user_id = f.user_id "
             "WHERE f.friend_id=%d AND f.status='pending';",
             user_id);
-        PGresult *res = PQexec(db, query);
+        PGresult *res = db_exec(db, query);
         if (PQresultStatus(res) == PGRES_TUPLES_OK) {
             char response[2048] = "FRIEND_REQUESTS|";
             for (int i = 0; i < PQntuples(res); i++) {
@@ -173,11 +175,11 @@ void handle_friend_requests(ClientSession *session, int num_params, char *param1
                 if (i < PQntuples(res) - 1) strcat(response, ",");
             }
             strcat(response, "\n");
-            send(session->socket_fd, response, strlen(response), 0);
-            printf("[Server] Send to client %d: %s", session->socket_fd, response);
+            send_to_client(session->socket_fd, response);
+            LOG_DEBUG("[Server] Send to client %d: %s", session->socket_fd, response);
         } else {
             char error[] = "ERROR|Failed to get friend requests\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
         }
         PQclear(res);
     }
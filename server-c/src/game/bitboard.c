@@ -0,0 +1,170 @@
+#include "bitboard.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#define SLIDER_HAVE_PEXT 1
+#endif
+
+// Leaper attacks are plain lookups (see bitboard.h). Sliders use "fancy"
+// magic bitboards: the blockers that matter for a square (its rays minus the
+// board edge) are hashed by a multiply and shift into a slice of one shared
+// attack table. On CPUs with BMI2 the index is the PEXT of those blockers
+// instead, which needs no magic multiplier. Either way the tables are built
+// once by bitboard_init() and only read afterwards.
+
+typedef struct {
+    Bitboard mask;              // Relevant blockers
+    Bitboard magic;
+    const Bitboard *attacks;    // This square's slice of the attack table
+    unsigned shift;             // 64 - popcount(mask)
+} SliderMagic;
+
+// Sizes are the sums of 2^popcount(mask) over all squares
+#define BISHOP_TABLE_SIZE 5248
+#define ROOK_TABLE_SIZE 102400
+
+static SliderMagic bishop_magics[64];
+static SliderMagic rook_magics[64];
+static Bitboard bishop_table[BISHOP_TABLE_SIZE];
+static Bitboard rook_table[ROOK_TABLE_SIZE];
+static int use_pext = 0;
+
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+static const RayDirection bishop_directions[4] = {
+    RAY_NORTH_EAST, RAY_NORTH_WEST, RAY_SOUTH_EAST, RAY_SOUTH_WEST
+};
+static const RayDirection rook_directions[4] = {
+    RAY_NORTH, RAY_SOUTH, RAY_EAST, RAY_WEST
+};
+
+// Reference attacks used to fill the tables: each ray up to and including
+// the nearest blocker
+static Bitboard ray_attacks(int sq, const RayDirection *directions, Bitboard occupied) {
+    Bitboard attacks = 0;
+
+    for (int i = 0; i < 4; i++) {
+        RayDirection dir = directions[i];
+        Bitboard ray = ray_table[dir][sq];
+        Bitboard blockers = ray & occupied;
+        if (blockers) {
+            int blocker = RAY_IS_POSITIVE(dir) ? bb_lsb(blockers) : bb_msb(blockers);
+            ray ^= ray_table[dir][blocker];
+        }
+        attacks |= ray;
+    }
+    return attacks;
+}
+
+// xorshift64*; the seeds are fixed so every start finds the same magics
+static Bitboard random_bitboard(Bitboard *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static void init_slider(SliderMagic *magics, Bitboard *table, const RayDirection *directions) {
+    static Bitboard occupancy[4096], reference[4096];
+    static int epoch[4096];
+    // Per-row PRNG seeds that find all magics quickly (~50 ms)
+    static const Bitboard seeds[8] = { 728, 10316, 55013, 32803, 12281, 15100, 16645, 255 };
+    Bitboard *slice = table;
+
+    for (int sq = 0; sq < 64; sq++) {
+        SliderMagic *m = &magics[sq];
+        int row = SQUARE_ROW(sq), col = SQUARE_COL(sq);
+        // Edge squares never block anything behind them; leave them out
+        // unless the piece stands on that edge itself
+        Bitboard edges = ((RANK_8_BB | RANK_1_BB) & ~(RANK_8_BB << (row * 8))) |
+                         ((FILE_A_BB | FILE_H_BB) & ~(FILE_A_BB << col));
+
+        m->mask = ray_attacks(sq, directions, 0) & ~edges;
+        m->shift = 64 - bb_popcount(m->mask);
+        m->attacks = slice;
+        Bitboard seed = seeds[row];
+
+        // Walk every subset of the mask (carry-rippler). Subsets come out in
+        // PEXT index order, so the PEXT table is filled directly.
+        int size = 0;
+        Bitboard subset = 0;
+        do {
+            occupancy[size] = subset;
+            reference[size] = ray_attacks(sq, directions, subset);
+            size++;
+            subset = (subset - m->mask) & m->mask;
+        } while (subset);
+
+        if (use_pext) {
+            memcpy(slice, reference, size * sizeof(Bitboard));
+            slice += size;
+            continue;
+        }
+
+        // Try sparse random multipliers until one maps every subset to a
+        // slot holding the right attacks (constructive collisions are fine)
+        memset(epoch, 0, sizeof(epoch));
+        for (int attempt = 1; ; attempt++) {
+            do {
+                m->magic = random_bitboard(&seed) & random_bitboard(&seed) & random_bitboard(&seed);
+            } while (bb_popcount((m->mask * m->magic) >> 56) < 6);
+
+            int i;
+            for (i = 0; i < size; i++) {
+                unsigned index = (unsigned)((occupancy[i] * m->magic) >> m->shift);
+                if (epoch[index] < attempt) {
+                    epoch[index] = attempt;
+                    slice[index] = reference[i];
+                } else if (slice[index] != reference[i]) {
+                    break;
+                }
+            }
+            if (i == size) break;
+        }
+        slice += size;
+    }
+}
+
+static void init_tables(void) {
+#ifdef SLIDER_HAVE_PEXT
+    // BITBOARD_PEXT=0 forces magics, e.g. on AMD before Zen 3 where PEXT is
+    // microcoded and slower than a multiply
+    const char *env = getenv("BITBOARD_PEXT");
+    use_pext = __builtin_cpu_supports("bmi2") && !(env && strcmp(env, "0") == 0);
+#endif
+    init_slider(bishop_magics, bishop_table, bishop_directions);
+    init_slider(rook_magics, rook_table, rook_directions);
+}
+
+void bitboard_init(void) {
+    pthread_once(&init_once, init_tables);
+}
+
+const char* bitboard_slider_backend(void) {
+    return use_pext ? "pext" : "magic";
+}
+
+#ifdef SLIDER_HAVE_PEXT
+__attribute__((target("bmi2")))
+static Bitboard slider_attacks_pext(const SliderMagic *m, Bitboard occupied) {
+    return m->attacks[_pext_u64(occupied, m->mask)];
+}
+#endif
+
+static inline Bitboard slider_attacks(const SliderMagic *m, Bitboard occupied) {
+#ifdef SLIDER_HAVE_PEXT
+    if (use_pext) return slider_attacks_pext(m, occupied);
+#endif
+    return m->attacks[((occupied & m->mask) * m->magic) >> m->shift];
+}
+
+Bitboard bishop_attacks(int sq, Bitboard occupied) {
+    return slider_attacks(&bishop_magics[sq], occupied);
+}
+
+Bitboard rook_attacks(int sq, Bitboard occupied) {
+    return slider_attacks(&rook_magics[sq], occupied);
+}
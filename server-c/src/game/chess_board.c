@@ -3,18 +3,13 @@
 
 int board_has_king(ChessBoard *board, PlayerColor color)
 {
-    char king = (color == COLOR_WHITE) ? WHITE_KING : BLACK_KING;
-
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            if (board->board[r][c] == king)
-                return 1;
-        }
-    }
-    return 0;
+    return board->pieces[BB_INDEX(color, PIECE_KING)] != 0;
 }
 
 void chess_board_init(ChessBoard *board) {
+    bitboard_init();
+    zobrist_init();
+
     // Rank 8 (Black)
     board->board[0][0] = BLACK_ROOK;
     board->board[0][1] = BLACK_KNIGHT;
@@ -63,16 +58,74 @@ void chess_board_init(ChessBoard *board) {
     board->black_king_row = 0;
     board->black_king_col = 4;
     
-    chess_board_to_fen(board, board->fen);
+    chess_board_sync_bitboards(board);
+    chess_board_get_fen(board);
+}
+
+void chess_board_sync_bitboards(ChessBoard *board) {
+    memset(board->pieces, 0, sizeof(board->pieces));
+    board->occupied_by[COLOR_WHITE] = 0;
+    board->occupied_by[COLOR_BLACK] = 0;
+
+    for (int sq = 0; sq < 64; sq++) {
+        int index = piece_bb_index(board->board[SQUARE_ROW(sq)][SQUARE_COL(sq)]);
+        if (index < 0) continue;
+        board->pieces[index] |= SQUARE_BB(sq);
+        board->occupied_by[index / PIECE_KINDS] |= SQUARE_BB(sq);
+    }
+    board->occupied = board->occupied_by[COLOR_WHITE] | board->occupied_by[COLOR_BLACK];
+    board->fen_dirty = 1;
+
+    board->hash = chess_board_state_key(board);
+    for (int index = 0; index < BB_PIECE_COUNT; index++) {
+        Bitboard set = board->pieces[index];
+        while (set) {
+            board->hash ^= zobrist_piece[index][bb_pop_lsb(&set)];
+        }
+    }
+}
+
+int chess_board_castling_rights(const ChessBoard *board) {
+    return (board->white_kingside_castle ? 1 : 0) |
+           (board->white_queenside_castle ? 2 : 0) |
+           (board->black_kingside_castle ? 4 : 0) |
+           (board->black_queenside_castle ? 8 : 0);
+}
+
+ZobristKey chess_board_state_key(const ChessBoard *board) {
+    ZobristKey key = zobrist_castling[chess_board_castling_rights(board)];
+
+    // The en passant file only matters when the side to move can capture
+    if (board->en_passant_file >= 0) {
+        PlayerColor us = board->current_turn;
+        int sq = SQUARE(board->en_passant_rank, board->en_passant_file);
+        if (pawn_attacks(!us, sq) & board->pieces[BB_INDEX(us, PIECE_PAWN)]) {
+            key ^= zobrist_en_passant[board->en_passant_file];
+        }
+    }
+    if (board->current_turn == COLOR_BLACK) key ^= zobrist_black_to_move;
+    return key;
 }
 
 void chess_board_copy(ChessBoard *dest, ChessBoard *src) {
     memcpy(dest, src, sizeof(ChessBoard));
 }
 
-void chess_board_to_fen(ChessBoard *board, char *fen) {
-    char temp[256] = "";
-    
+// Write a non-negative integer, return the end
+static char* write_uint(char *p, int value) {
+    char digits[12];
+    int n = 0;
+    do {
+        digits[n++] = (char)('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+    while (n > 0) *p++ = digits[--n];
+    return p;
+}
+
+void chess_board_to_fen(const ChessBoard *board, char *fen) {
+    char *p = fen;
+
     // Board position
     for (int row = 0; row < 8; row++) {
         int empty_count = 0;
@@ -80,49 +133,181 @@ void chess_board_to_fen(ChessBoard *board, char *fen) {
             char piece = board->board[row][col];
             if (piece == EMPTY) {
                 empty_count++;
+                continue;
+            }
+            if (empty_count > 0) {
+                *p++ = (char)('0' + empty_count);
+                empty_count = 0;
+            }
+            *p++ = piece;
+        }
+        if (empty_count > 0) *p++ = (char)('0' + empty_count);
+        if (row < 7) *p++ = '/';
+    }
+
+    *p++ = ' ';
+    *p++ = (board->current_turn == COLOR_WHITE) ? 'w' : 'b';
+    *p++ = ' ';
+
+    char *castling = p;
+    if (board->white_kingside_castle) *p++ = 'K';
+    if (board->white_queenside_castle) *p++ = 'Q';
+    if (board->black_kingside_castle) *p++ = 'k';
+    if (board->black_queenside_castle) *p++ = 'q';
+    if (p == castling) *p++ = '-';
+    *p++ = ' ';
+
+    if (board->en_passant_file >= 0) {
+        *p++ = (char)('a' + board->en_passant_file);
+        *p++ = (char)('0' + 8 - board->en_passant_rank);
+    } else {
+        *p++ = '-';
+    }
+
+    *p++ = ' ';
+    p = write_uint(p, board->halfmove_clock);
+    *p++ = ' ';
+    p = write_uint(p, (board->move_count / 2) + 1);
+    *p = '\0';
+}
+
+const char* chess_board_get_fen(ChessBoard *board) {
+    if (board->fen_dirty) {
+        chess_board_to_fen(board, board->fen);
+        board->fen_dirty = 0;
+    }
+    return board->fen;
+}
+
+// Read a non-negative integer; NULL if there is none or it is absurd
+static const char* parse_uint(const char *p, int *value) {
+    if (*p < '0' || *p > '9') return NULL;
+    int v = 0;
+    while (*p >= '0' && *p <= '9') {
+        v = v * 10 + (*p++ - '0');
+        if (v > 100000) return NULL;
+    }
+    *value = v;
+    return p;
+}
+
+int chess_board_from_fen(ChessBoard *board, const char *fen) {
+    ChessBoard parsed;
+    const char *p = fen;
+
+    bitboard_init();
+    zobrist_init();
+    memset(&parsed, 0, sizeof(parsed));
+
+    // Piece placement, rank 8 first
+    for (int row = 0; row < 8; row++) {
+        int col = 0;
+        while (col < 8) {
+            char c = *p++;
+            if (c >= '1' && c <= '8') {
+                if (col + (c - '0') > 8) return -1;
+                for (int i = 0; i < c - '0'; i++) parsed.board[row][col++] = EMPTY;
+            } else if (piece_bb_index(c) >= 0) {
+                // Pawns can never stand on the first or last rank
+                if ((c == WHITE_PAWN || c == BLACK_PAWN) && (row == 0 || row == 7)) return -1;
+                parsed.board[row][col++] = c;
             } else {
-                if (empty_count > 0) {
-                    char num[12];
-                    sprintf(num, "%d", empty_count);
-                    strcat(temp, num);
-                    empty_count = 0;
-                }
-                char piece_str[2] = {piece, '\0'};
-                strcat(temp, piece_str);
+                return -1;
             }
         }
-        if (empty_count > 0) {
-            char num[12];
-            sprintf(num, "%d", empty_count);
-            strcat(temp, num);
+        if (*p++ != (row < 7 ? '/' : ' ')) return -1;
+    }
+
+    // Side to move
+    if (*p == 'w') parsed.current_turn = COLOR_WHITE;
+    else if (*p == 'b') parsed.current_turn = COLOR_BLACK;
+    else return -1;
+    p++;
+    if (*p++ != ' ') return -1;
+
+    // Castling rights
+    if (*p == '-') {
+        p++;
+    } else {
+        int rights = 0;
+        for (; *p && *p != ' '; p++) {
+            int bit = (*p == 'K') ? 1 : (*p == 'Q') ? 2 : (*p == 'k') ? 4 : (*p == 'q') ? 8 : 0;
+            if (bit == 0 || (rights & bit)) return -1;
+            rights |= bit;
         }
-        if (row < 7) strcat(temp, "/");
+        if (rights == 0) return -1;
+        parsed.white_kingside_castle = (rights & 1) != 0;
+        parsed.white_queenside_castle = (rights & 2) != 0;
+        parsed.black_kingside_castle = (rights & 4) != 0;
+        parsed.black_queenside_castle = (rights & 8) != 0;
     }
-    
-    strcat(temp, board->current_turn == COLOR_WHITE ? " w " : " b ");
-    
-    char castling[5] = "";
-    if (board->white_kingside_castle) strcat(castling, "K");
-    if (board->white_queenside_castle) strcat(castling, "Q");
-    if (board->black_kingside_castle) strcat(castling, "k");
-    if (board->black_queenside_castle) strcat(castling, "q");
-    if (strlen(castling) == 0) strcat(castling, "-");
-    strcat(temp, castling);
-    strcat(temp, " ");
-    
-    if (board->en_passant_file >= 0) {
-        char ep[3];
-        sprintf(ep, "%c%d", 'a' + board->en_passant_file, board->en_passant_rank);
-        strcat(temp, ep);
+    if (*p++ != ' ') return -1;
+
+    // En passant target square
+    parsed.en_passant_file = -1;
+    parsed.en_passant_rank = -1;
+    if (*p == '-') {
+        p++;
     } else {
-        strcat(temp, "-");
+        if (*p < 'a' || *p > 'h') return -1;
+        int file = *p++ - 'a';
+        int digit = *p++;
+        // The target is on rank 6 when white is to move and rank 3 when
+        // black is. Older servers wrote the row index instead of the rank
+        // (2 and 5), accept that too.
+        int row;
+        if (parsed.current_turn == COLOR_WHITE && (digit == '6' || digit == '2')) row = 2;
+        else if (parsed.current_turn == COLOR_BLACK && (digit == '3' || digit == '5')) row = 5;
+        else return -1;
+
+        // The pawn that just moved two squares must be in front of the
+        // target, with the target and its start square empty
+        int pawn_row = (row == 2) ? 3 : 4;
+        int start_row = (row == 2) ? 1 : 6;
+        char pawn = (row == 2) ? BLACK_PAWN : WHITE_PAWN;
+        if (parsed.board[pawn_row][file] != pawn ||
+            parsed.board[row][file] != EMPTY ||
+            parsed.board[start_row][file] != EMPTY) return -1;
+        parsed.en_passant_file = file;
+        parsed.en_passant_rank = row;
     }
-    
-    char moves[32];
-    sprintf(moves, " %d %d", board->halfmove_clock, (board->move_count / 2) + 1);
-    strcat(temp, moves);
-    
-    strcpy(fen, temp);
+
+    // Move counters are optional (some tools send only four fields)
+    int fullmove = 1;
+    if (*p == ' ') {
+        p = parse_uint(p + 1, &parsed.halfmove_clock);
+        if (p == NULL) return -1;
+        if (*p == ' ') {
+            p = parse_uint(p + 1, &fullmove);
+            if (p == NULL || fullmove < 1) return -1;
+        }
+    }
+    while (*p == ' ' || *p == '\r' || *p == '\n') p++;
+    if (*p != '\0') return -1;
+    parsed.move_count = (fullmove - 1) * 2 + (parsed.current_turn == COLOR_BLACK ? 1 : 0);
+
+    chess_board_sync_bitboards(&parsed);
+
+    // Exactly one king each, and the side that just moved is not in check
+    Bitboard white_king = parsed.pieces[BB_INDEX(COLOR_WHITE, PIECE_KING)];
+    Bitboard black_king = parsed.pieces[BB_INDEX(COLOR_BLACK, PIECE_KING)];
+    if (bb_popcount(white_king) != 1 || bb_popcount(black_king) != 1) return -1;
+    parsed.white_king_row = SQUARE_ROW(bb_lsb(white_king));
+    parsed.white_king_col = SQUARE_COL(bb_lsb(white_king));
+    parsed.black_king_row = SQUARE_ROW(bb_lsb(black_king));
+    parsed.black_king_col = SQUARE_COL(bb_lsb(black_king));
+    if (is_king_in_check(&parsed, parsed.current_turn == COLOR_WHITE ? COLOR_BLACK : COLOR_WHITE)) return -1;
+
+    // Castling rights need the king and rook on their home squares
+    if ((parsed.white_kingside_castle || parsed.white_queenside_castle) && parsed.board[7][4] != WHITE_KING) return -1;
+    if ((parsed.black_kingside_castle || parsed.black_queenside_castle) && parsed.board[0][4] != BLACK_KING) return -1;
+    if ((parsed.white_kingside_castle && parsed.board[7][7] != WHITE_ROOK) ||
+        (parsed.white_queenside_castle && parsed.board[7][0] != WHITE_ROOK) ||
+        (parsed.black_kingside_castle && parsed.board[0][7] != BLACK_ROOK) ||
+        (parsed.black_queenside_castle && parsed.board[0][0] != BLACK_ROOK)) return -1;
+
+    memcpy(board, &parsed, sizeof(parsed));
+    return 0;
 }
 
 void chess_board_print(ChessBoard *board) {
@@ -155,6 +340,22 @@ char get_piece_at(ChessBoard *board, int row, int col) {
 
 void set_piece_at(ChessBoard *board, int row, int col, char piece) {
     if (row < 0 || row >= 8 || col < 0 || col >= 8) return;
+
+    Bitboard bit = SQUARE_BB(SQUARE(row, col));
+    int old_index = piece_bb_index(board->board[row][col]);
+    if (old_index >= 0) {
+        board->pieces[old_index] &= ~bit;
+        board->occupied_by[old_index / PIECE_KINDS] &= ~bit;
+        board->hash ^= zobrist_piece[old_index][SQUARE(row, col)];
+    }
+    int new_index = piece_bb_index(piece);
+    if (new_index >= 0) {
+        board->pieces[new_index] |= bit;
+        board->occupied_by[new_index / PIECE_KINDS] |= bit;
+        board->hash ^= zobrist_piece[new_index][SQUARE(row, col)];
+    }
+    board->occupied = board->occupied_by[COLOR_WHITE] | board->occupied_by[COLOR_BLACK];
+
     board->board[row][col] = piece;
     
     if (piece == WHITE_KING) {
@@ -177,3 +378,21 @@ int is_black_piece(char piece) {
 PlayerColor get_piece_color(char piece) {
     return is_white_piece(piece) ? COLOR_WHITE : COLOR_BLACK;
 }
+
+int piece_bb_index(char piece) {
+    switch (piece) {
+        case WHITE_PAWN:   return BB_INDEX(COLOR_WHITE, PIECE_PAWN);
+        case WHITE_KNIGHT: return BB_INDEX(COLOR_WHITE, PIECE_KNIGHT);
+        case WHITE_BISHOP: return BB_INDEX(COLOR_WHITE, PIECE_BISHOP);
+        case WHITE_ROOK:   return BB_INDEX(COLOR_WHITE, PIECE_ROOK);
+        case WHITE_QUEEN:  return BB_INDEX(COLOR_WHITE, PIECE_QUEEN);
+        case WHITE_KING:   return BB_INDEX(COLOR_WHITE, PIECE_KING);
+        case BLACK_PAWN:   return BB_INDEX(COLOR_BLACK, PIECE_PAWN);
+        case BLACK_KNIGHT: return BB_INDEX(COLOR_BLACK, PIECE_KNIGHT);
+        case BLACK_BISHOP: return BB_INDEX(COLOR_BLACK, PIECE_BISHOP);
+        case BLACK_ROOK:   return BB_INDEX(COLOR_BLACK, PIECE_ROOK);
+        case BLACK_QUEEN:  return BB_INDEX(COLOR_BLACK, PIECE_QUEEN);
+        case BLACK_KING:   return BB_INDEX(COLOR_BLACK, PIECE_KING);
+        default:           return -1;
+    }
+}
@@ -18,7 +18,7 @@ static void get_opponent_info(PGconn *db, int match_id, int my_user_id,
              "SELECT white_user_id, black_user_id FROM matches WHERE match_id = %d", 
              match_id);
     
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         PQclear(res);
         *opponent_id = -1;
@@ -49,7 +49,7 @@ static void get_opponent_info(PGconn *db, int match_id, int my_user_id,
              "SELECT username FROM users WHERE user_id = %d", 
              *opponent_id);
     
-    res = PQexec(db, query);
+    res = db_exec(db, query);
     if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
         strncpy(opponent_username, PQgetvalue(res, 0, 0), 63);
         opponent_username[63] = '\0';
@@ -78,7 +78,7 @@ void handle_game_chat(ClientSession *session, int match_id, const char *message,
              "SELECT username FROM users WHERE user_id = %d", 
              session->user_id);
     
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
     char sender_username[64] = {0};
     if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
         strncpy(sender_username, PQgetvalue(res, 0, 0), 63);
@@ -90,7 +90,7 @@ void handle_game_chat(ClientSession *session, int match_id, const char *message,
     char buf[1024];
     snprintf(buf, sizeof(buf), "GAME_CHAT_FROM|%s|%s\n", sender_username, message);
     
-    if (send(opponent_fd, buf, strlen(buf), 0) < 0) {
+    if (send_to_client(opponent_fd, buf) < 0) {
         // Failed to send, but don't report error to client
         perror("send_game_chat");
     }
@@ -1,6 +1,7 @@
 #include "game.h"
 #include "history.h"
 #include "timer.h"
+#include "log.h"
 #include <string.h>
 #include <sys/socket.h>
 #include <unistd.h>
@@ -47,8 +48,9 @@ GameMatch* game_manager_create_match(GameManager *manager, Player white, Player
     match->rematch_id = 0;  // ✅ Initialize rematch_id
 
     
-    chess_board_init(&match->board);
+    game_match_init_board(match);
     pthread_mutex_init(&match->lock, NULL);
+    match->refs = 1;    // The manager's, dropped when the match is removed
     
     // Add to manager
     manager->matches[manager->match_count] = match;
@@ -59,7 +61,7 @@ GameMatch* game_manager_create_match(GameManager *manager, Player white, Player
     
     pthread_mutex_unlock(&manager->lock);
     
-    printf("[Game Manager] Created match %d: %s vs %s\n", 
+    LOG_INFO("[Game Manager] Created match %d: %s vs %s\n", 
            match_id, white.username, black.username);
     
     return match;
@@ -94,8 +96,9 @@ GameMatch* game_manager_create_bot_match(GameManager *manager, Player white, Pla
     
     match->rematch_id = 0;  // ✅ Initialize rematch_id
     
-    chess_board_init(&match->board);
+    game_match_init_board(match);
     pthread_mutex_init(&match->lock, NULL);
+    match->refs = 1;    // The manager's, dropped when the match is removed
     strncpy(match->bot_difficulty, difficulty, sizeof(match->bot_difficulty)-1);
     match->bot_difficulty[sizeof(match->bot_difficulty)-1] = '\0';
     
@@ -108,41 +111,81 @@ GameMatch* game_manager_create_bot_match(GameManager *manager, Player white, Pla
     
     pthread_mutex_unlock(&manager->lock);
     
-    printf("[Game Manager] Created bot match %d: %s vs %s (difficulty: %s)\n", 
+    LOG_INFO("[Game Manager] Created bot match %d: %s vs %s (difficulty: %s)\n", 
            match_id, white.username, black.username, difficulty);
     
     return match;
 }
 
-GameMatch* game_manager_find_match(GameManager *manager, int match_id) {
+// Reactors, DB workers and engine workers all look matches up while shard 0
+// removes finished ones, so a match found by id is pinned under the manager
+// lock before that lock is released. The pin keeps the memory, not the
+// listing: check match->status under match->lock as usual.
+GameMatch* game_manager_acquire_match(GameManager *manager, int match_id) {
     pthread_mutex_lock(&manager->lock);
     
+    GameMatch *found = NULL;
     for (int i = 0; i < manager->match_count; i++) {
         if (manager->matches[i] && manager->matches[i]->match_id == match_id) {
-            GameMatch *match = manager->matches[i];
-            pthread_mutex_unlock(&manager->lock);
-            return match;
+            found = manager->matches[i];
+            __atomic_add_fetch(&found->refs, 1, __ATOMIC_RELAXED);
+            break;
         }
     }
     
     pthread_mutex_unlock(&manager->lock);
-    return NULL;
+    return found;
 }
 
-GameMatch* game_manager_find_match_by_player(GameManager *manager, int socket_fd) {
+GameMatch* game_manager_acquire_match_by_player(GameManager *manager, int socket_fd) {
     pthread_mutex_lock(&manager->lock);
     
+    GameMatch *found = NULL;
     for (int i = 0; i < manager->match_count; i++) {
         GameMatch *match = manager->matches[i];
         if (match && (match->white_player.socket_fd == socket_fd || 
                      match->black_player.socket_fd == socket_fd)) {
-            pthread_mutex_unlock(&manager->lock);
-            return match;
+            found = match;
+            __atomic_add_fetch(&found->refs, 1, __ATOMIC_RELAXED);
+            break;
         }
     }
     
     pthread_mutex_unlock(&manager->lock);
-    return NULL;
+    return found;
+}
+
+// Call after unlocking match->lock: the last release destroys it. Takes no
+// lock itself, so manager->lock may be held.
+void game_match_release(GameMatch *match) {
+    if (match != NULL && __atomic_sub_fetch(&match->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        pthread_mutex_destroy(&match->lock);
+        free(match);
+    }
+}
+
+// Unlist matches[index] and drop the manager's reference. Handlers that
+// still hold the match keep it allocated until they release it.
+// Call with manager->lock held.
+static void game_manager_drop_match_locked(GameManager *manager, int index) {
+    GameMatch *match = manager->matches[index];
+
+    timer_manager_stop_timer(&manager->timer_manager, match->match_id);
+
+    // A search still running for this match would hold an engine worker
+    // until its deadline
+    pthread_mutex_lock(&match->lock);
+    game_match_cancel_bot_search(match);
+    pthread_mutex_unlock(&match->lock);
+
+    // Shift remaining matches
+    for (int j = index; j < manager->match_count - 1; j++) {
+        manager->matches[j] = manager->matches[j + 1];
+    }
+    manager->matches[manager->match_count - 1] = NULL;
+    manager->match_count--;
+
+    game_match_release(match);
 }
 
 void game_manager_remove_match(GameManager *manager, int match_id) {
@@ -150,20 +193,8 @@ void game_manager_remove_match(GameManager *manager, int match_id) {
     
     for (int i = 0; i < manager->match_count; i++) {
         if (manager->matches[i] && manager->matches[i]->match_id == match_id) {
-            // Stop timer for this match
-            timer_manager_stop_timer(&manager->timer_manager, match_id);
-            
-            pthread_mutex_destroy(&manager->matches[i]->lock);
-            free(manager->matches[i]);
-            
-            // Shift remaining matches
-            for (int j = i; j < manager->match_count - 1; j++) {
-                manager->matches[j] = manager->matches[j + 1];
-            }
-            manager->matches[manager->match_count - 1] = NULL;
-            manager->match_count--;
-            
-            printf("[Game Manager] Removed match %d\n", match_id);
+            game_manager_drop_match_locked(manager, i);
+            LOG_INFO("[Game Manager] Removed match %d\n", match_id);
             break;
         }
     }
@@ -274,22 +305,24 @@ int game_match_make_move(GameMatch *match,
 
     /* 6️⃣ EXECUTE MOVE */
     execute_move(&match->board, &move);
+    game_match_record_position(match);
 
     /* 7️⃣ SAVE MOVE TO DB */
+    const char *fen = chess_board_get_fen(&match->board);
     char notation[16];
     snprintf(notation, sizeof(notation), "%s%s", from, to);
     history_save_move(db,
                       match->match_id,
                       current_player->user_id,
                       notation,
-                      match->board.fen);
+                      fen);
 
     /* 8️⃣ SEND RESPONSES */
     char response[BUFFER_SIZE];
     snprintf(response, sizeof(response),
              "MOVE_SUCCESS|%s|%s\n",
              notation,
-             match->board.fen);
+             fen);
     send_to_client(player_socket_fd, response);
 
     if (opponent->socket_fd > 0 &&
@@ -297,7 +330,7 @@ int game_match_make_move(GameMatch *match,
         snprintf(response, sizeof(response),
                  "OPPONENT_MOVE|%s|%s\n",
                  notation,
-                 match->board.fen);
+                 fen);
         send_to_client(opponent->socket_fd, response);
     }
 
@@ -308,6 +341,31 @@ int game_match_make_move(GameMatch *match,
     return 1;
 }
 
+void game_match_init_board(GameMatch *match) {
+    chess_board_init(&match->board);
+    repetition_table_clear(&match->repetitions);
+    match->position_repeats = repetition_table_add(&match->repetitions, match->board.hash);
+    match->bot_search_cancel = NULL;
+}
+
+void game_match_record_position(GameMatch *match) {
+    // Positions before a pawn move or capture can never come back
+    if (match->board.halfmove_clock == 0) {
+        repetition_table_clear(&match->repetitions);
+    }
+    match->position_repeats = repetition_table_add(&match->repetitions, match->board.hash);
+}
+
+void game_match_cancel_bot_search(GameMatch *match) {
+    if (match->bot_search_cancel) {
+        // The job owns the flag. It acquires the match by id, so a removed
+        // match is never touched, and a listed one is pinned while the job
+        // checks the pointer under this lock; clearing it disowns the job
+        __atomic_store_n(match->bot_search_cancel, 1, __ATOMIC_RELAXED);
+        match->bot_search_cancel = NULL;
+    }
+}
+
 static void force_end_game(GameMatch *match,
                            PGconn *db,
                            int winner_id,
@@ -349,33 +407,30 @@ void force_black_win(GameMatch *match, PGconn *db)
 
 
 int game_match_check_end_condition(GameMatch *match, PGconn *db) {
+    PlayerColor next_player = match->board.current_turn;
+    PositionState state = classify_position(&match->board, match->position_repeats);
 
-    if (!board_has_king(&match->board, COLOR_WHITE)) {
+    LOG_DEBUG("[DEBUG] game_match_check_end_condition: match_id=%d, current_turn=%s, state=%s\n",
+           match->match_id, (next_player == COLOR_WHITE ? "WHITE" : "BLACK"),
+           position_state_reason(state));
+
+    if (state == POSITION_NO_WHITE_KING) {
         force_black_win(match, db);
         return 1;
     }
-    if (!board_has_king(&match->board, COLOR_BLACK)) {
+    if (state == POSITION_NO_BLACK_KING) {
         force_white_win(match, db);
         return 1;
     }
-
-    PlayerColor next_player = match->board.current_turn;
-    
-    printf("[DEBUG] game_match_check_end_condition: match_id=%d, current_turn=%s\n", 
-           match->match_id, (next_player == COLOR_WHITE ? "WHITE" : "BLACK"));
-    
-    // Check checkmate
-    int checkmate = is_checkmate(&match->board, next_player);
-    printf("[DEBUG] is_checkmate() returned: %d\n", checkmate);
     
-    if (checkmate) {
+    if (state == POSITION_CHECKMATE) {
         match->status = GAME_FINISHED;
         match->result = (next_player == COLOR_WHITE) ? RESULT_BLACK_WIN : RESULT_WHITE_WIN;
         match->winner_id = (next_player == COLOR_WHITE) ? 
                           match->black_player.user_id : match->white_player.user_id;
         match->end_time = time(NULL);
         
-        printf("[DEBUG] CHECKMATE DETECTED! Setting status=GAME_FINISHED, result=%s, winner_id=%d\n",
+        LOG_DEBUG("[DEBUG] CHECKMATE DETECTED! Setting status=GAME_FINISHED, result=%s, winner_id=%d\n",
                (match->result == RESULT_WHITE_WIN ? "WHITE_WIN" : "BLACK_WIN"), match->winner_id);
         
         // Update database
@@ -398,7 +453,7 @@ int game_match_check_end_condition(GameMatch *match, PGconn *db) {
         sprintf(msg, "GAME_END|checkmate|winner:%d\n", match->winner_id);
         broadcast_to_match(match, msg, -1);
         
-        printf("[Match %d] CHECKMATE! Winner: %d\n", match->match_id, match->winner_id);
+        LOG_INFO("[Match %d] CHECKMATE! Winner: %d\n", match->match_id, match->winner_id);
         
         // For bot match: send BOT_GAME_END if needed
         if (match->black_player.user_id == 0) {
@@ -413,69 +468,18 @@ int game_match_check_end_condition(GameMatch *match, PGconn *db) {
         return 1;
     }
     
-    // Check stalemate
-    if (!is_king_in_check(&match->board, next_player) &&
-    is_stalemate(&match->board, next_player)){
+    // Stalemate, threefold repetition, 50-move rule, insufficient material
+    if (state != POSITION_ONGOING) {
+        const char *draw_reason = position_state_reason(state);
         match->status = GAME_FINISHED;
         match->result = RESULT_DRAW;
         match->end_time = time(NULL);
-        
         history_update_match_result(db, match->match_id, "draw", 0);
-        
-        // Stop timer
         timer_manager_stop_timer(&game_manager.timer_manager, match->match_id);
-        
         char msg[BUFFER_SIZE];
-        sprintf(msg, "GAME_END|stalemate|draw\n");
+        sprintf(msg, "GAME_END|%s|draw\n", draw_reason);
         broadcast_to_match(match, msg, -1);
-        
-        printf("[Match %d] STALEMATE! Draw\n", match->match_id);
-        
-        // For bot match: send BOT_GAME_END if needed
-        if (match->black_player.user_id == 0) {
-            sprintf(msg, "BOT_GAME_END|draw\n");
-            send_to_client(match->white_player.socket_fd, msg);
-        }
-        
-        return 1;
-    }
-    
-    // Check 50-move rule
-    if (match->board.halfmove_clock >= 100) {
-        match->status = GAME_FINISHED;
-        match->result = RESULT_DRAW;
-        match->end_time = time(NULL);
-        history_update_match_result(db, match->match_id, "draw", 0);
-        timer_manager_stop_timer(&game_manager.timer_manager, match->match_id);
-        char msg[BUFFER_SIZE];
-        sprintf(msg, "GAME_END|fifty_move_rule|draw\n");
-        broadcast_to_match(match, msg, -1);
-        printf("[Match %d] Draw by 50-move rule\n", match->match_id);
-        // For bot match: send BOT_GAME_END if needed
-        if (match->black_player.user_id == 0) {
-            sprintf(msg, "BOT_GAME_END|draw\n");
-            send_to_client(match->white_player.socket_fd, msg);
-        }
-        return 1;
-    }
-
-    // Check insufficient material (chỉ còn mỗi vua hoặc không đủ quân để chiếu hết)
-    int insufficient = is_insufficient_material(&match->board);
-    printf("[DEBUG] is_insufficient_material() returned: %d\n", insufficient);
-    
-    if (insufficient) {
-        match->status = GAME_FINISHED;
-        match->result = RESULT_DRAW;
-        match->end_time = time(NULL);
-        
-        printf("[DEBUG] INSUFFICIENT MATERIAL DETECTED! Updating database...\n");
-        history_update_match_result(db, match->match_id, "draw", 0);
-        
-        timer_manager_stop_timer(&game_manager.timer_manager, match->match_id);
-        char msg[BUFFER_SIZE];
-        sprintf(msg, "GAME_END|insufficient_material|draw\n");
-        broadcast_to_match(match, msg, -1);
-        printf("[Match %d] Draw by insufficient material\n", match->match_id);
+        LOG_INFO("[Match %d] Draw by %s\n", match->match_id, draw_reason);
         // For bot match: send BOT_GAME_END if needed
         if (match->black_player.user_id == 0) {
             sprintf(msg, "BOT_GAME_END|draw\n");
@@ -496,7 +500,7 @@ int game_match_check_end_condition(GameMatch *match, PGconn *db) {
             sprintf(msg, "BOT_GAME_END|draw\n");
         }
         send_to_client(match->white_player.socket_fd, msg);
-        printf("[Bot Match %d] Game ended: %s\n", match->match_id, msg);
+        LOG_INFO("[Bot Match %d] Game ended: %s\n", match->match_id, msg);
     }
     
     return 0;
@@ -515,6 +519,7 @@ void game_match_handle_surrender(GameMatch *match, int player_socket_fd, PGconn
     
     match->status = GAME_FINISHED;
     match->end_time = time(NULL);
+    game_match_cancel_bot_search(match);
     
     history_update_match_result(db, match->match_id, "surrender", match->winner_id);
     
@@ -535,15 +540,11 @@ void game_match_handle_surrender(GameMatch *match, int player_socket_fd, PGconn
     sprintf(response, "SURRENDER_SUCCESS|%d\n", match->winner_id);
     send_to_client(player_socket_fd, response);
     
-    printf("[Match %d] Surrender! Winner: %d\n", match->match_id, match->winner_id);
+    LOG_INFO("[Match %d] Surrender! Winner: %d\n", match->match_id, match->winner_id);
     
     pthread_mutex_unlock(&match->lock);
 }
 
-void send_to_client(int socket_fd, const char *message) {
-    send(socket_fd, message, strlen(message), 0);
-}
-
 void broadcast_to_match(GameMatch *match, const char *message, int exclude_fd) {
     if (match->white_player.socket_fd != exclude_fd && match->white_player.is_online) {
         send_to_client(match->white_player.socket_fd, message);
@@ -555,10 +556,10 @@ void broadcast_to_match(GameMatch *match, const char *message, int exclude_fd) {
 
 // Timer callback function for game timeout
 void game_timeout_callback(int match_id) {
-    printf("[Timer] Game %d timed out - ending game\n", match_id);
+    LOG_INFO("[Timer] Game %d timed out - ending game\n", match_id);
     
     // Find the match and end it with timeout
-    GameMatch *match = game_manager_find_match(&game_manager, match_id);
+    GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
     if (match) {
         pthread_mutex_lock(&match->lock);
         
@@ -592,10 +593,11 @@ void game_timeout_callback(int match_id) {
             sprintf(msg, "GAME_END|timeout|winner:%d\n", match->winner_id);
             broadcast_to_match(match, msg, -1);
             
-            printf("[Match %d] TIMEOUT! Winner: %d\n", match->match_id, match->winner_id);
+            LOG_INFO("[Match %d] TIMEOUT! Winner: %d\n", match->match_id, match->winner_id);
         }
         
         pthread_mutex_unlock(&match->lock);
+        game_match_release(match);
     }
 }
 
@@ -613,22 +615,10 @@ void game_manager_cleanup_finished_matches(GameManager *manager) {
         if (match && match->status == GAME_FINISHED && 
             match->end_time > 0 && (now - match->end_time) > 60) {
             
-            printf("[Cleanup] Removing finished match %d (ended %ld seconds ago)\n", 
+            LOG_INFO("[Cleanup] Removing finished match %d (ended %ld seconds ago)\n", 
                    match->match_id, now - match->end_time);
             
-            // Stop timer
-            timer_manager_stop_timer(&manager->timer_manager, match->match_id);
-            
-            // Free match
-            pthread_mutex_destroy(&match->lock);
-            free(match);
-            
-            // Shift remaining matches
-            for (int j = i; j < manager->match_count - 1; j++) {
-                manager->matches[j] = manager->matches[j + 1];
-            }
-            manager->matches[manager->match_count - 1] = NULL;
-            manager->match_count--;
+            game_manager_drop_match_locked(manager, i);
             cleaned++;
             
             // Don't increment i, check the same index again
@@ -640,7 +630,7 @@ void game_manager_cleanup_finished_matches(GameManager *manager) {
     pthread_mutex_unlock(&manager->lock);
     
     if (cleaned > 0) {
-        printf("[Cleanup] Cleaned %d finished matches. Active matches: %d\n", 
+        LOG_INFO("[Cleanup] Cleaned %d finished matches. Active matches: %d\n", 
                cleaned, manager->match_count);
     }
 }
@@ -659,22 +649,10 @@ void game_manager_force_cleanup_stale_matches(GameManager *manager) {
         if (match && match->status == GAME_PLAYING && 
             (now - match->start_time) > 1800) {  // 30 minutes
             
-            printf("[Force Cleanup] Removing stale match %d (started %ld seconds ago, no activity)\n", 
+            LOG_INFO("[Force Cleanup] Removing stale match %d (started %ld seconds ago, no activity)\n", 
                    match->match_id, now - match->start_time);
             
-            // Stop timer
-            timer_manager_stop_timer(&manager->timer_manager, match->match_id);
-            
-            // Free match
-            pthread_mutex_destroy(&match->lock);
-            free(match);
-            
-            // Shift remaining matches
-            for (int j = i; j < manager->match_count - 1; j++) {
-                manager->matches[j] = manager->matches[j + 1];
-            }
-            manager->matches[manager->match_count - 1] = NULL;
-            manager->match_count--;
+            game_manager_drop_match_locked(manager, i);
             cleaned++;
             
         } else {
@@ -683,7 +661,7 @@ void game_manager_force_cleanup_stale_matches(GameManager *manager) {
     }
     
     if (cleaned > 0) {
-        printf("[Force Cleanup] Removed %d stale matches. Active matches: %d\n", 
+        LOG_INFO("[Force Cleanup] Removed %d stale matches. Active matches: %d\n", 
                cleaned, manager->match_count);
     }
     
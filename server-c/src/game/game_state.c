@@ -1,26 +1,29 @@
 #include "game.h"
+#include "log.h"
 
 int has_legal_moves(ChessBoard *board, PlayerColor player_color) {
-    // Try all possible moves for all pieces of this color
-    for (int from_row = 0; from_row < 8; from_row++) {
-        for (int from_col = 0; from_col < 8; from_col++) {
-            char piece = board->board[from_row][from_col];
-            if (piece == EMPTY) continue;
-            if (get_piece_color(piece) != player_color) continue;
-            
-            // Try all possible destination squares
-            for (int to_row = 0; to_row < 8; to_row++) {
-                for (int to_col = 0; to_col < 8; to_col++) {
-                    if (from_row == to_row && from_col == to_col) continue;
-                    
-                    Move move = {from_row, from_col, to_row, to_col, piece, 
-                                board->board[to_row][to_col], 0, 0, 0, 0};
-                    
-                    if (validate_move(board, &move, player_color)) {
-                        return 1; // Found at least one legal move
-                    }
-                }
-            }
+    // A king step to a square no enemy piece attacks is always legal. Most
+    // positions have one, and finding it is far cheaper than generating the
+    // whole move list. The king is lifted off the board first so a slider
+    // checking along a line still covers the square behind it.
+    Bitboard king = board->pieces[BB_INDEX(player_color, PIECE_KING)];
+    if (king) {
+        int king_sq = bb_lsb(king);
+        Bitboard occupied = board->occupied ^ king;
+        Bitboard targets = king_attacks(king_sq) & ~board->occupied_by[player_color];
+        while (targets) {
+            int to = bb_pop_lsb(&targets);
+            if (!attackers_to(board, to, !player_color, occupied)) return 1;
+        }
+    }
+
+    // Otherwise generate pseudo-legal moves and stop at the first legal one
+    MoveList list;
+    generate_pseudo_legal_moves(board, player_color, &list);
+
+    for (int i = 0; i < list.count; i++) {
+        if (is_move_legal(board, &list.moves[i], player_color)) {
+            return 1; // Found at least one legal move
         }
     }
     
@@ -40,51 +43,62 @@ int is_stalemate(ChessBoard *board, PlayerColor player_color) {
 }
 
 int is_insufficient_material(const ChessBoard *board) {
-    // Count pieces on the board
-    int white_minor = 0, black_minor = 0;
-    int white_other = 0, black_other = 0;
-    
-    printf("[DEBUG is_insufficient_material] Checking board...\n");
-    
-    for (int r = 0; r < BOARD_SIZE; r++) {
-        for (int c = 0; c < BOARD_SIZE; c++) {
-            char p = board->board[r][c];
-            if (p == EMPTY) continue;
-            if (p == WHITE_KING || p == BLACK_KING) continue;
-            
-            printf("[DEBUG] Found piece '%c' at (%d,%d)\n", p, r, c);
-            
-            // Count minor pieces (bishop, knight)
-            if (p == WHITE_BISHOP || p == WHITE_KNIGHT) {
-                white_minor++;
-            } else if (p == BLACK_BISHOP || p == BLACK_KNIGHT) {
-                black_minor++;
-            }
-            // Count other pieces (pawn, rook, queen)
-            else if (p == WHITE_PAWN || p == WHITE_ROOK || p == WHITE_QUEEN) {
-                white_other++;
-            } else if (p == BLACK_PAWN || p == BLACK_ROOK || p == BLACK_QUEEN) {
-                black_other++;
-            }
-        }
-    }
-    
-    printf("[DEBUG is_insufficient_material] white_minor=%d, black_minor=%d, white_other=%d, black_other=%d\n",
-           white_minor, black_minor, white_other, black_other);
-    
+    // Count pieces by kind straight from the bitboards
+    const Bitboard *white = &board->pieces[BB_INDEX(COLOR_WHITE, 0)];
+    const Bitboard *black = &board->pieces[BB_INDEX(COLOR_BLACK, 0)];
+
+    Bitboard others = white[PIECE_PAWN] | white[PIECE_ROOK] | white[PIECE_QUEEN] |
+                      black[PIECE_PAWN] | black[PIECE_ROOK] | black[PIECE_QUEEN];
+    Bitboard knights = white[PIECE_KNIGHT] | black[PIECE_KNIGHT];
+    Bitboard bishops = white[PIECE_BISHOP] | black[PIECE_BISHOP];
+
+    LOG_DEBUG("[DEBUG is_insufficient_material] others=%d, knights=%d, light_bishops=%d, dark_bishops=%d\n",
+           bb_popcount(others), bb_popcount(knights),
+           bb_popcount(bishops & LIGHT_SQUARES_BB), bb_popcount(bishops & ~LIGHT_SQUARES_BB));
+
+    // A pawn, rook or queen left on the board can still give mate
+    if (others) return 0;
+
     // Case 1: Chỉ còn mỗi vua (King vs King)
-    if (white_minor == 0 && black_minor == 0 && white_other == 0 && black_other == 0) {
-        return 1;
-    }
-    
     // Case 2: Vua vs vua + tượng hoặc mã (King vs King+Bishop/Knight)
-    if ((white_minor == 1 && white_other == 0 && black_minor == 0 && black_other == 0) ||
-        (black_minor == 1 && black_other == 0 && white_minor == 0 && white_other == 0)) {
+    if (bb_popcount(knights | bishops) <= 1) return 1;
+
+    // Case 3: Vua + tượng vs vua + tượng (cùng màu ô). Bishops that all stand
+    // on one square color can never cover both a king's square and its
+    // flight squares, whoever owns them.
+    if (!knights && (!(bishops & LIGHT_SQUARES_BB) || !(bishops & ~LIGHT_SQUARES_BB))) {
         return 1;
     }
-    
-    // Case 3: Vua + tượng vs vua + tượng (cùng màu ô) - simplified check
-    // (Nâng cao hơn cần kiểm tra xem 2 tượng có cùng màu ô hay không)
-    
+
     return 0;
 }
+
+PositionState classify_position(ChessBoard *board, int repetitions) {
+    if (!board_has_king(board, COLOR_WHITE)) return POSITION_NO_WHITE_KING;
+    if (!board_has_king(board, COLOR_BLACK)) return POSITION_NO_BLACK_KING;
+
+    // Mate and stalemate share the move scan; check decides which it is
+    PlayerColor to_move = board->current_turn;
+    if (!has_legal_moves(board, to_move)) {
+        return is_king_in_check(board, to_move) ? POSITION_CHECKMATE : POSITION_STALEMATE;
+    }
+
+    if (repetitions >= 3) return POSITION_THREEFOLD_REPETITION;
+    if (board->halfmove_clock >= 100) return POSITION_FIFTY_MOVE_RULE;
+    if (is_insufficient_material(board)) return POSITION_INSUFFICIENT_MATERIAL;
+
+    return POSITION_ONGOING;
+}
+
+const char* position_state_reason(PositionState state) {
+    switch (state) {
+        case POSITION_NO_WHITE_KING:
+        case POSITION_NO_BLACK_KING:        return "invalid_state";
+        case POSITION_CHECKMATE:            return "checkmate";
+        case POSITION_STALEMATE:            return "stalemate";
+        case POSITION_THREEFOLD_REPETITION: return "threefold_repetition";
+        case POSITION_FIFTY_MOVE_RULE:      return "fifty_move_rule";
+        case POSITION_INSUFFICIENT_MATERIAL: return "insufficient_material";
+        default:                            return "ongoing";
+    }
+}
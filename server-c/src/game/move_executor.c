@@ -1,11 +1,23 @@
 #include "game.h"
 #include <ctype.h>
 
-int execute_move(ChessBoard *board, Move *move) {
+void make_move(ChessBoard *board, const Move *move, MoveUndo *undo) {
+    // Save what the move overwrites and cannot be derived from it
+    undo->captured_piece = board->board[move->to_row][move->to_col];
+    undo->castling = (unsigned char)chess_board_castling_rights(board);
+    undo->en_passant_file = (signed char)board->en_passant_file;
+    undo->en_passant_rank = (signed char)board->en_passant_rank;
+    undo->halfmove_clock = board->halfmove_clock;
+    undo->hash = board->hash;
+
+    // Pieces are rehashed by set_piece_at(); the rest is swapped out here
+    // and back in once the move is done
+    board->hash ^= chess_board_state_key(board);
+
     // Handle en passant
     if (move->is_en_passant) {
         int captured_pawn_row = move->from_row;
-        board->board[captured_pawn_row][move->to_col] = EMPTY;
+        set_piece_at(board, captured_pawn_row, move->to_col, EMPTY);
     }
     
     // Handle castling
@@ -14,22 +26,13 @@ int execute_move(ChessBoard *board, Move *move) {
         
         // Kingside
         if (move->to_col == 6) {
-            board->board[row][7] = EMPTY;
-            board->board[row][5] = is_white_piece(move->piece) ? WHITE_ROOK : BLACK_ROOK;
+            set_piece_at(board, row, 7, EMPTY);
+            set_piece_at(board, row, 5, is_white_piece(move->piece) ? WHITE_ROOK : BLACK_ROOK);
         }
         // Queenside
         else if (move->to_col == 2) {
-            board->board[row][0] = EMPTY;
-            board->board[row][3] = is_white_piece(move->piece) ? WHITE_ROOK : BLACK_ROOK;
-        }
-        
-        // Update castling rights
-        if (is_white_piece(move->piece)) {
-            board->white_kingside_castle = 0;
-            board->white_queenside_castle = 0;
-        } else {
-            board->black_kingside_castle = 0;
-            board->black_queenside_castle = 0;
+            set_piece_at(board, row, 0, EMPTY);
+            set_piece_at(board, row, 3, is_white_piece(move->piece) ? WHITE_ROOK : BLACK_ROOK);
         }
     }
     
@@ -39,18 +42,18 @@ int execute_move(ChessBoard *board, Move *move) {
         piece_to_place = move->promotion_piece;
     }
     
-    // Move the piece
-    board->board[move->to_row][move->to_col] = piece_to_place;
-    board->board[move->from_row][move->from_col] = EMPTY;
+    // Move the piece (set_piece_at also updates the bitboards and king position)
+    set_piece_at(board, move->to_row, move->to_col, piece_to_place);
+    set_piece_at(board, move->from_row, move->from_col, EMPTY);
     
-    // Update king position
+    // A king that has moved can no longer castle
     if (toupper(move->piece) == 'K') {
         if (is_white_piece(move->piece)) {
-            board->white_king_row = move->to_row;
-            board->white_king_col = move->to_col;
+            board->white_kingside_castle = 0;
+            board->white_queenside_castle = 0;
         } else {
-            board->black_king_row = move->to_row;
-            board->black_king_col = move->to_col;
+            board->black_kingside_castle = 0;
+            board->black_queenside_castle = 0;
         }
     }
     
@@ -80,9 +83,13 @@ int execute_move(ChessBoard *board, Move *move) {
         }
     }
     
-    // Reset en passant
+    // Reset en passant; a double pawn push opens it on the skipped square
     board->en_passant_file = -1;
     board->en_passant_rank = -1;
+    if (toupper(move->piece) == 'P' && abs(move->to_row - move->from_row) == 2) {
+        board->en_passant_file = move->from_col;
+        board->en_passant_rank = (move->from_row + move->to_row) / 2;
+    }
     
     // Update halfmove clock (for 50-move rule)
     if (toupper(move->piece) == 'P' || move->captured_piece != EMPTY) {
@@ -94,9 +101,49 @@ int execute_move(ChessBoard *board, Move *move) {
     // Switch turn
     board->current_turn = (board->current_turn == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
     board->move_count++;
-    
-    // Update FEN
-    chess_board_to_fen(board, board->fen);
-    
+
+    board->hash ^= chess_board_state_key(board);
+    board->fen_dirty = 1;
+}
+
+void unmake_move(ChessBoard *board, const Move *move, const MoveUndo *undo) {
+    board->current_turn = (board->current_turn == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    board->move_count--;
+
+    // Put the mover back (un-promoting) and restore whatever stood on the target
+    set_piece_at(board, move->from_row, move->from_col, move->piece);
+    set_piece_at(board, move->to_row, move->to_col, undo->captured_piece);
+
+    if (move->is_en_passant) {
+        set_piece_at(board, move->from_row, move->to_col,
+                     is_white_piece(move->piece) ? BLACK_PAWN : WHITE_PAWN);
+    }
+
+    if (move->is_castling) {
+        int row = move->from_row;
+        char rook = is_white_piece(move->piece) ? WHITE_ROOK : BLACK_ROOK;
+        if (move->to_col == 6) {
+            set_piece_at(board, row, 5, EMPTY);
+            set_piece_at(board, row, 7, rook);
+        } else if (move->to_col == 2) {
+            set_piece_at(board, row, 3, EMPTY);
+            set_piece_at(board, row, 0, rook);
+        }
+    }
+
+    board->white_kingside_castle = (undo->castling & 1) != 0;
+    board->white_queenside_castle = (undo->castling & 2) != 0;
+    board->black_kingside_castle = (undo->castling & 4) != 0;
+    board->black_queenside_castle = (undo->castling & 8) != 0;
+    board->en_passant_file = undo->en_passant_file;
+    board->en_passant_rank = undo->en_passant_rank;
+    board->halfmove_clock = undo->halfmove_clock;
+    board->hash = undo->hash;
+    board->fen_dirty = 1;
+}
+
+int execute_move(ChessBoard *board, Move *move) {
+    MoveUndo undo;
+    make_move(board, move, &undo);
     return 1;
 }
\ No newline at end of file
@@ -0,0 +1,167 @@
+#include "game.h"
+
+// Pseudo-legal moves follow the piece rules (including castling through
+// unattacked squares and en passant) but may leave the mover's king in
+// check; the legal filter plays each one with make_move(), tests the king
+// and takes it back.
+
+static const char promotion_pieces[2][4] = {
+    { WHITE_QUEEN, WHITE_ROOK, WHITE_BISHOP, WHITE_KNIGHT },
+    { BLACK_QUEEN, BLACK_ROOK, BLACK_BISHOP, BLACK_KNIGHT },
+};
+
+static inline void add_move(MoveList *list, ChessBoard *board, int from, int to, char piece) {
+    Move *move = &list->moves[list->count++];
+    move->from_row = SQUARE_ROW(from);
+    move->from_col = SQUARE_COL(from);
+    move->to_row = SQUARE_ROW(to);
+    move->to_col = SQUARE_COL(to);
+    move->piece = piece;
+    move->captured_piece = board->board[move->to_row][move->to_col];
+    move->is_castling = 0;
+    move->is_en_passant = 0;
+    move->is_promotion = 0;
+    move->promotion_piece = 0;
+}
+
+static void add_pawn_moves(MoveList *list, ChessBoard *board, int from, Bitboard targets,
+                           PlayerColor color, char piece) {
+    while (targets) {
+        int to = bb_pop_lsb(&targets);
+        int to_row = SQUARE_ROW(to);
+        if (to_row == 0 || to_row == 7) {
+            for (int i = 0; i < 4; i++) {
+                add_move(list, board, from, to, piece);
+                Move *move = &list->moves[list->count - 1];
+                move->is_promotion = 1;
+                move->promotion_piece = promotion_pieces[color][i];
+            }
+        } else {
+            add_move(list, board, from, to, piece);
+        }
+    }
+}
+
+static void generate_pawn_moves(ChessBoard *board, PlayerColor color, MoveList *list,
+                                Bitboard enemies) {
+    Bitboard pawns = board->pieces[BB_INDEX(color, PIECE_PAWN)];
+    char piece = (color == COLOR_WHITE) ? WHITE_PAWN : BLACK_PAWN;
+    int step = (color == COLOR_WHITE) ? -8 : 8;
+    int start_row = (color == COLOR_WHITE) ? 6 : 1;
+    Bitboard empty = ~board->occupied;
+
+    Bitboard ep_target = 0;
+    if (board->en_passant_file >= 0) {
+        ep_target = SQUARE_BB(SQUARE(board->en_passant_rank, board->en_passant_file));
+    }
+
+    while (pawns) {
+        int from = bb_pop_lsb(&pawns);
+        Bitboard targets = pawn_attacks(color, from) & enemies;
+
+        int one = from + step;
+        if (empty & SQUARE_BB(one)) {
+            targets |= SQUARE_BB(one);
+            int two = one + step;
+            if (SQUARE_ROW(from) == start_row && (empty & SQUARE_BB(two))) {
+                targets |= SQUARE_BB(two);
+            }
+        }
+        add_pawn_moves(list, board, from, targets, color, piece);
+
+        if (pawn_attacks(color, from) & ep_target) {
+            add_move(list, board, from, bb_lsb(ep_target), piece);
+            list->moves[list->count - 1].is_en_passant = 1;
+        }
+    }
+}
+
+static void generate_piece_moves(ChessBoard *board, PlayerColor color, MoveList *list,
+                                 PieceKind kind, Bitboard targets_mask) {
+    static const char pieces[2][PIECE_KINDS] = {
+        { WHITE_PAWN, WHITE_KNIGHT, WHITE_BISHOP, WHITE_ROOK, WHITE_QUEEN, WHITE_KING },
+        { BLACK_PAWN, BLACK_KNIGHT, BLACK_BISHOP, BLACK_ROOK, BLACK_QUEEN, BLACK_KING },
+    };
+    Bitboard set = board->pieces[BB_INDEX(color, kind)];
+
+    while (set) {
+        int from = bb_pop_lsb(&set);
+        Bitboard targets;
+        switch (kind) {
+            case PIECE_KNIGHT: targets = knight_attacks(from); break;
+            case PIECE_BISHOP: targets = bishop_attacks(from, board->occupied); break;
+            case PIECE_ROOK:   targets = rook_attacks(from, board->occupied); break;
+            case PIECE_QUEEN:  targets = queen_attacks(from, board->occupied); break;
+            case PIECE_KING:   targets = king_attacks(from); break;
+            default:           targets = 0; break;
+        }
+        targets &= targets_mask;
+        while (targets) {
+            add_move(list, board, from, bb_pop_lsb(&targets), pieces[color][kind]);
+        }
+    }
+}
+
+static void generate_castling(ChessBoard *board, PlayerColor color, MoveList *list) {
+    int row = (color == COLOR_WHITE) ? 7 : 0;
+    int kingside = (color == COLOR_WHITE) ? board->white_kingside_castle : board->black_kingside_castle;
+    int queenside = (color == COLOR_WHITE) ? board->white_queenside_castle : board->black_queenside_castle;
+    char king = (color == COLOR_WHITE) ? WHITE_KING : BLACK_KING;
+    char rook = (color == COLOR_WHITE) ? WHITE_ROOK : BLACK_ROOK;
+    PlayerColor enemy = (color == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+
+    if ((!kingside && !queenside) || board->board[row][4] != king) return;
+    if (is_square_attacked(board, row, 4, enemy)) return;
+
+    Bitboard occupied = board->occupied;
+    if (kingside && board->board[row][7] == rook &&
+        !(occupied & (SQUARE_BB(SQUARE(row, 5)) | SQUARE_BB(SQUARE(row, 6)))) &&
+        !is_square_attacked(board, row, 5, enemy) &&
+        !is_square_attacked(board, row, 6, enemy)) {
+        add_move(list, board, SQUARE(row, 4), SQUARE(row, 6), king);
+        list->moves[list->count - 1].is_castling = 1;
+    }
+    if (queenside && board->board[row][0] == rook &&
+        !(occupied & (SQUARE_BB(SQUARE(row, 1)) | SQUARE_BB(SQUARE(row, 2)) | SQUARE_BB(SQUARE(row, 3)))) &&
+        !is_square_attacked(board, row, 3, enemy) &&
+        !is_square_attacked(board, row, 2, enemy)) {
+        add_move(list, board, SQUARE(row, 4), SQUARE(row, 2), king);
+        list->moves[list->count - 1].is_castling = 1;
+    }
+}
+
+int generate_pseudo_legal_moves(ChessBoard *board, PlayerColor color, MoveList *list) {
+    PlayerColor enemy = (color == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
+    // Kings are never captured; a position where that is possible is already lost
+    Bitboard enemies = board->occupied_by[enemy] & ~board->pieces[BB_INDEX(enemy, PIECE_KING)];
+    Bitboard targets = ~board->occupied | enemies;
+
+    list->count = 0;
+    generate_pawn_moves(board, color, list, enemies);
+    for (PieceKind kind = PIECE_KNIGHT; kind <= PIECE_KING; kind++) {
+        generate_piece_moves(board, color, list, kind, targets);
+    }
+    generate_castling(board, color, list);
+    return list->count;
+}
+
+int is_move_legal(ChessBoard *board, const Move *move, PlayerColor color) {
+    MoveUndo undo;
+    make_move(board, move, &undo);
+    int legal = !is_king_in_check(board, color);
+    unmake_move(board, move, &undo);
+    return legal;
+}
+
+int generate_legal_moves(ChessBoard *board, PlayerColor color, MoveList *list) {
+    generate_pseudo_legal_moves(board, color, list);
+
+    int kept = 0;
+    for (int i = 0; i < list->count; i++) {
+        if (is_move_legal(board, &list->moves[i], color)) {
+            list->moves[kept++] = list->moves[i];
+        }
+    }
+    list->count = kept;
+    return kept;
+}
@@ -45,18 +45,8 @@ int validate_move(ChessBoard *board, Move *move, PlayerColor player_color) {
     
     if (!valid) return 0;
     
-    // Test if move leaves king in check
-    ChessBoard test_board;
-    chess_board_copy(&test_board, board);
-    
-    Move test_move = *move;
-    execute_move(&test_board, &test_move);
-    
-    if (is_king_in_check(&test_board, player_color)) {
-        return 0;
-    }
-    
-    return 1;
+    // Test if move leaves king in check (played and taken back in place)
+    return is_move_legal(board, move, player_color);
 }
 
 int validate_pawn_move(ChessBoard *board, Move *move) {
@@ -98,9 +88,7 @@ int validate_pawn_move(ChessBoard *board, Move *move) {
 
         if (board->board[middle_row][move->from_col] == EMPTY &&
             board->board[move->to_row][move->to_col] == EMPTY) {
-
-            board->en_passant_file = move->from_col;
-            board->en_passant_rank = middle_row;
+            // execute_move() records the en passant square
             return 1;
         }
     }
@@ -147,23 +135,21 @@ int validate_knight_move(ChessBoard *board, Move *move) {
     return (row_diff == 2 && col_diff == 1) || (row_diff == 1 && col_diff == 2);
 }
 
+// Sliders: the target must be in the piece's attack set, which already
+// stops at the first piece in the way
 int validate_bishop_move(ChessBoard *board, Move *move) {
-    int row_diff = abs(move->to_row - move->from_row);
-    int col_diff = abs(move->to_col - move->from_col);
-    
-    if (row_diff != col_diff) return 0;
-    
-    return is_path_clear(board, move->from_row, move->from_col, move->to_row, move->to_col);
+    int from = SQUARE(move->from_row, move->from_col);
+    return (bishop_attacks(from, board->occupied) & SQUARE_BB(SQUARE(move->to_row, move->to_col))) != 0;
 }
 
 int validate_rook_move(ChessBoard *board, Move *move) {
-    if (move->from_row != move->to_row && move->from_col != move->to_col) return 0;
-    
-    return is_path_clear(board, move->from_row, move->from_col, move->to_row, move->to_col);
+    int from = SQUARE(move->from_row, move->from_col);
+    return (rook_attacks(from, board->occupied) & SQUARE_BB(SQUARE(move->to_row, move->to_col))) != 0;
 }
 
 int validate_queen_move(ChessBoard *board, Move *move) {
-    return validate_bishop_move(board, move) || validate_rook_move(board, move);
+    int from = SQUARE(move->from_row, move->from_col);
+    return (queen_attacks(from, board->occupied) & SQUARE_BB(SQUARE(move->to_row, move->to_col))) != 0;
 }
 
 int validate_king_move(ChessBoard *board, Move *move) {
@@ -225,7 +211,7 @@ int is_path_clear(ChessBoard *board, int from_row, int from_col, int to_row, int
     int col = from_col + col_step;
     
     while (row != to_row || col != to_col) {
-        if (board->board[row][col] != EMPTY) return 0;
+        if (board->occupied & SQUARE_BB(SQUARE(row, col))) return 0;
         row += row_step;
         col += col_step;
     }
@@ -233,57 +219,32 @@ int is_path_clear(ChessBoard *board, int from_row, int from_col, int to_row, int
     return 1;
 }
 
+Bitboard attackers_to(const ChessBoard *board, int sq, PlayerColor attacker_color, Bitboard occupied) {
+    const Bitboard *attacker = &board->pieces[BB_INDEX(attacker_color, 0)];
+
+    // A pawn attacks sq exactly when a pawn of the other color on sq would
+    // attack the pawn's square
+    Bitboard attackers = (pawn_attacks(!attacker_color, sq) & attacker[PIECE_PAWN]) |
+                         (knight_attacks(sq) & attacker[PIECE_KNIGHT]) |
+                         (king_attacks(sq) & attacker[PIECE_KING]);
+
+    Bitboard diagonal = attacker[PIECE_BISHOP] | attacker[PIECE_QUEEN];
+    if (diagonal) attackers |= bishop_attacks(sq, occupied) & diagonal;
+    Bitboard straight = attacker[PIECE_ROOK] | attacker[PIECE_QUEEN];
+    if (straight) attackers |= rook_attacks(sq, occupied) & straight;
+
+    return attackers;
+}
+
 int is_square_attacked(ChessBoard *board, int row, int col, PlayerColor attacker_color) {
-    // Check all opponent pieces to see if they can attack this square
-    for (int r = 0; r < 8; r++) {
-        for (int c = 0; c < 8; c++) {
-            char piece = board->board[r][c];
-            if (piece == EMPTY) continue;
-            if (get_piece_color(piece) != attacker_color) continue;
-            
-            Move test_move = {r, c, row, col, piece, board->board[row][col], 0, 0, 0, 0};
-            
-            char piece_type = toupper(piece);
-            int can_attack = 0;
-            
-            switch (piece_type) {
-                case 'P': {
-                    int direction = is_white_piece(piece) ? -1 : 1;
-                    int row_diff = row - r;
-                    int col_diff = abs(col - c);
-                    can_attack = (col_diff == 1 && row_diff == direction);
-                    break;
-                }
-                case 'N': can_attack = validate_knight_move(board, &test_move); break;
-                case 'B': can_attack = validate_bishop_move(board, &test_move); break;
-                case 'R': can_attack = validate_rook_move(board, &test_move); break;
-                case 'Q': can_attack = validate_queen_move(board, &test_move); break;
-                case 'K': {
-                    int rd = abs(row - r);
-                    int cd = abs(col - c);
-                    can_attack = (rd <= 1 && cd <= 1);
-                    break;
-                }
-            }
-            
-            if (can_attack) return 1;
-        }
-    }
-    
-    return 0;
+    return attackers_to(board, SQUARE(row, col), attacker_color, board->occupied) != 0;
 }
 
 int is_king_in_check(ChessBoard *board, PlayerColor king_color) {
-    int king_row, king_col;
-    
-    if (king_color == COLOR_WHITE) {
-        king_row = board->white_king_row;
-        king_col = board->white_king_col;
-    } else {
-        king_row = board->black_king_row;
-        king_col = board->black_king_col;
-    }
-    
+    Bitboard king = board->pieces[BB_INDEX(king_color, PIECE_KING)];
+    if (king == 0) return 0;
+
+    int king_sq = bb_lsb(king);
     PlayerColor attacker_color = (king_color == COLOR_WHITE) ? COLOR_BLACK : COLOR_WHITE;
-    return is_square_attacked(board, king_row, king_col, attacker_color);
+    return is_square_attacked(board, SQUARE_ROW(king_sq), SQUARE_COL(king_sq), attacker_color);
 }
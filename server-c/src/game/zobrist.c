@@ -0,0 +1,74 @@
+#include "zobrist.h"
+#include <pthread.h>
+#include <string.h>
+
+ZobristKey zobrist_piece[BB_PIECE_COUNT][64];
+ZobristKey zobrist_castling[16];
+ZobristKey zobrist_en_passant[8];
+ZobristKey zobrist_black_to_move;
+
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+// xorshift64*
+static ZobristKey random_key(uint64_t *state) {
+    *state ^= *state >> 12;
+    *state ^= *state << 25;
+    *state ^= *state >> 27;
+    return *state * 0x2545F4914F6CDD1DULL;
+}
+
+static void init_keys(void) {
+    uint64_t state = 1070372;
+
+    for (int index = 0; index < BB_PIECE_COUNT; index++) {
+        for (int sq = 0; sq < 64; sq++) {
+            zobrist_piece[index][sq] = random_key(&state);
+        }
+    }
+
+    // Each right gets a key; a combination is the XOR of its rights, so the
+    // no-rights entry stays 0
+    ZobristKey rights[4];
+    for (int i = 0; i < 4; i++) rights[i] = random_key(&state);
+    for (int bits = 0; bits < 16; bits++) {
+        zobrist_castling[bits] = 0;
+        for (int i = 0; i < 4; i++) {
+            if (bits & (1 << i)) zobrist_castling[bits] ^= rights[i];
+        }
+    }
+
+    for (int file = 0; file < 8; file++) {
+        zobrist_en_passant[file] = random_key(&state);
+    }
+    zobrist_black_to_move = random_key(&state);
+}
+
+void zobrist_init(void) {
+    pthread_once(&init_once, init_keys);
+}
+
+void repetition_table_clear(RepetitionTable *table) {
+    memset(table->counts, 0, sizeof(table->counts));
+}
+
+int repetition_table_add(RepetitionTable *table, ZobristKey key) {
+    // Linear probing; the table is never more than half full
+    unsigned slot = (unsigned)key & (REPETITION_SLOTS - 1);
+
+    while (table->counts[slot] != 0 && table->keys[slot] != key) {
+        slot = (slot + 1) & (REPETITION_SLOTS - 1);
+    }
+    table->keys[slot] = key;
+    if (table->counts[slot] < 255) table->counts[slot]++;
+    return table->counts[slot];
+}
+
+int repetition_table_count(const RepetitionTable *table, ZobristKey key) {
+    unsigned slot = (unsigned)key & (REPETITION_SLOTS - 1);
+
+    while (table->counts[slot] != 0) {
+        if (table->keys[slot] == key) return table->counts[slot];
+        slot = (slot + 1) & (REPETITION_SLOTS - 1);
+    }
+    return 0;
+}
@@ -1,6 +1,7 @@
 #include "history.h"
 #include "database.h"
 #include "game.h"
+#include "log.h"
 #include <string.h>
 
 // These are wrapper functions that call the database layer
@@ -53,10 +54,10 @@ int history_get_user_matches(PGconn *conn, int user_id, MatchHistoryItem *items,
         "ORDER BY mg.starttime DESC LIMIT 20",
         user_id, user_id);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        fprintf(stderr, "[DB] Get history failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Get history failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return 0;
     }
@@ -90,7 +91,7 @@ int history_get_user_matches(PGconn *conn, int user_id, MatchHistoryItem *items,
     
     PQclear(res);
     
-    printf("[DB] Retrieved %d match history items for user %d\n", rows, user_id);
+    LOG_INFO("[DB] Retrieved %d match history items for user %d\n", rows, user_id);
     
     return 1;
 }
@@ -106,10 +107,10 @@ int replay_get_moves(PGconn *conn, int match_id, MoveRecord *moves, int *count)
         "FROM move WHERE match_id = %d ORDER BY move_id ASC",
         match_id);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
-        fprintf(stderr, "[DB] Get replay failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Get replay failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return 0;
     }
@@ -127,7 +128,7 @@ int replay_get_moves(PGconn *conn, int match_id, MoveRecord *moves, int *count)
     
     PQclear(res);
     
-    printf("[DB] Retrieved %d moves for replay of match %d\n", rows, match_id);
+    LOG_INFO("[DB] Retrieved %d moves for replay of match %d\n", rows, match_id);
     
     return 1;
 }
@@ -142,7 +143,7 @@ int replay_validate_access(PGconn *conn, int match_id, int user_id) {
         "WHERE match_id = %d AND user_id = %d",
         match_id, user_id);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK) {
         PQclear(res);
@@ -174,7 +175,7 @@ int stats_get_player_stats(PGconn *conn, int user_id, PlayerStats *stats) {
         "GROUP BY u.elo_point",
         user_id);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_TUPLES_OK || PQntuples(res) == 0) {
         // No games played yet
@@ -204,7 +205,7 @@ int stats_get_player_stats(PGconn *conn, int user_id, PlayerStats *stats) {
     
     PQclear(res);
     
-    printf("[DB] Retrieved stats for user %d: %d games, %d wins\n", 
+    LOG_INFO("[DB] Retrieved stats for user %d: %d games, %d wins\n", 
            user_id, stats->total_games, stats->wins);
     
     return 1;
@@ -221,17 +222,17 @@ int stats_update_elo(PGconn *conn, int winner_id, int loser_id) {
         "UPDATE users SET elo_point = GREATEST(elo_point - 30, 0) WHERE user_id = %d;",
         winner_id, loser_id);
     
-    PGresult *res = PQexec(conn, query);
+    PGresult *res = db_exec(conn, query);
     
     if (PQresultStatus(res) != PGRES_COMMAND_OK) {
-        fprintf(stderr, "[DB] Update ELO failed: %s\n", PQerrorMessage(conn));
+        LOG_ERROR("[DB] Update ELO failed: %s\n", PQerrorMessage(conn));
         PQclear(res);
         return 0;
     }
     
     PQclear(res);
     
-    printf("[DB] Updated ELO: winner %d (+30), loser %d (-30)\n", winner_id, loser_id);
+    LOG_INFO("[DB] Updated ELO: winner %d (+30), loser %d (-30)\n", winner_id, loser_id);
     
     return 1;
 }
@@ -1,5 +1,6 @@
 #include "history.h"
 #include "game.h"
+#include "log.h"
 #include <sys/socket.h>
 
 // Format history response as JSON for Flask backend
@@ -79,33 +80,33 @@ void format_stats_response(PlayerStats *stats, char *response) {
 
 // Handle history request
 void handle_history_request(PGconn *conn, int client_fd, int user_id) {
-    printf("[History] User %d requested match history\n", user_id);
+    LOG_INFO("[History] User %d requested match history\n", user_id);
     
     MatchHistoryItem items[MAX_HISTORY_ITEMS];
     int count = 0;
     
     if (!history_get_user_matches(conn, user_id, items, &count)) {
         char error_msg[] = "ERROR|Failed to retrieve history\n";
-        send(client_fd, error_msg, strlen(error_msg), 0);
+        send_to_client(client_fd, error_msg);
         return;
     }
     
     char response[BUFFER_SIZE * 2];
     format_history_response(items, count, response);
     
-    send(client_fd, response, strlen(response), 0);
+    send_to_client(client_fd, response);
     
-    printf("[History] Sent %d match history items to user %d\n", count, user_id);
+    LOG_INFO("[History] Sent %d match history items to user %d\n", count, user_id);
 }
 
 // Handle replay request
 void handle_replay_request(PGconn *conn, int client_fd, int match_id, int user_id) {
-    printf("[Replay] User %d requested replay of match %d\n", user_id, match_id);
+    LOG_INFO("[Replay] User %d requested replay of match %d\n", user_id, match_id);
     
     // Validate access (optional - can allow anyone to view any replay)
     // if (!replay_validate_access(conn, match_id, user_id)) {
     //     char error_msg[] = "ERROR|Access denied to this replay\n";
-    //     send(client_fd, error_msg, strlen(error_msg), 0);
+    //     send_to_client(client_fd, error_msg);
     //     return;
     // }
     
@@ -114,41 +115,41 @@ void handle_replay_request(PGconn *conn, int client_fd, int match_id, int user_i
     
     if (!replay_get_moves(conn, match_id, moves, &count)) {
         char error_msg[] = "ERROR|Failed to retrieve replay\n";
-        send(client_fd, error_msg, strlen(error_msg), 0);
+        send_to_client(client_fd, error_msg);
         return;
     }
     
     if (count == 0) {
         char error_msg[] = "ERROR|Match not found or has no moves\n";
-        send(client_fd, error_msg, strlen(error_msg), 0);
+        send_to_client(client_fd, error_msg);
         return;
     }
     
     char response[BUFFER_SIZE * 4];
     format_replay_response(moves, count, response);
     
-    send(client_fd, response, strlen(response), 0);
+    send_to_client(client_fd, response);
     
-    printf("[Replay] Sent %d moves to user %d for match %d\n", count, user_id, match_id);
+    LOG_INFO("[Replay] Sent %d moves to user %d for match %d\n", count, user_id, match_id);
 }
 
 // Handle stats request
 void handle_stats_request(PGconn *conn, int client_fd, int user_id) {
-    printf("[Stats] User %d requested statistics\n", user_id);
+    LOG_INFO("[Stats] User %d requested statistics\n", user_id);
     
     PlayerStats stats;
     
     if (!stats_get_player_stats(conn, user_id, &stats)) {
         char error_msg[] = "ERROR|Failed to retrieve statistics\n";
-        send(client_fd, error_msg, strlen(error_msg), 0);
+        send_to_client(client_fd, error_msg);
         return;
     }
     
     char response[512];
     format_stats_response(&stats, response);
     
-    send(client_fd, response, strlen(response), 0);
+    send_to_client(client_fd, response);
     
-    printf("[Stats] Sent statistics to user %d: %d games, %.1f%% win rate\n",
+    LOG_INFO("[Stats] Sent statistics to user %d: %d games, %.1f%% win rate\n",
            user_id, stats.total_games, stats.win_rate);
 }
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <time.h>
+
+// Bounded multi-producer ring: producers claim a slot with one atomic
+// compare-and-swap, format straight into it and publish it through the
+// slot's sequence number; the writer thread is the only consumer. When the
+// ring is full the message is dropped and counted rather than blocking the
+// caller.
+
+#define LOG_SLOTS 4096          // Power of two
+#define LOG_LINE_MAX 512
+
+typedef struct {
+    size_t seq;
+    int level;
+    int len;
+    char text[LOG_LINE_MAX];
+} LogSlot;
+
+int log_runtime_level = LOG_LEVEL_INFO;
+
+static LogSlot *slots = NULL;
+static size_t ring_tail = 0;        // Next ticket for producers
+static size_t ring_head = 0;        // Next slot for the writer
+static size_t dropped = 0;
+static int running = 0;
+
+static pthread_t writer_thread;
+static pthread_mutex_t writer_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t writer_wakeup = PTHREAD_COND_INITIALIZER;
+static int writer_sleeping = 0;
+
+static FILE* log_stream(int level) {
+    return level >= LOG_LEVEL_ERROR ? stderr : stdout;
+}
+
+static int log_parse_level(const char *name) {
+    if (strcasecmp(name, "debug") == 0) return LOG_LEVEL_DEBUG;
+    if (strcasecmp(name, "info") == 0) return LOG_LEVEL_INFO;
+    if (strcasecmp(name, "warn") == 0 || strcasecmp(name, "warning") == 0) return LOG_LEVEL_WARN;
+    if (strcasecmp(name, "error") == 0) return LOG_LEVEL_ERROR;
+    if (strcasecmp(name, "off") == 0) return LOG_LEVEL_OFF;
+    return -1;
+}
+
+// Write one published slot, or return 0 when the ring is empty
+static int log_drain_one(void) {
+    LogSlot *slot = &slots[ring_head & (LOG_SLOTS - 1)];
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != ring_head + 1) {
+        return 0;
+    }
+
+    fwrite(slot->text, 1, (size_t)slot->len, log_stream(slot->level));
+
+    // Hand the slot back to producers for the next lap
+    __atomic_store_n(&slot->seq, ring_head + LOG_SLOTS, __ATOMIC_RELEASE);
+    __atomic_store_n(&ring_head, ring_head + 1, __ATOMIC_RELEASE);
+    return 1;
+}
+
+static void* log_writer(void *arg) {
+    (void)arg;
+    size_t reported_drops = 0;
+
+    while (1) {
+        int wrote = 0;
+        while (log_drain_one()) {
+            wrote = 1;
+        }
+        if (wrote) {
+            fflush(stdout);
+        }
+
+        size_t drops = __atomic_load_n(&dropped, __ATOMIC_RELAXED);
+        if (drops != reported_drops) {
+            fprintf(stderr, "[Log] Dropped %zu message(s): log ring full\n", drops - reported_drops);
+            reported_drops = drops;
+        }
+
+        // Sleep until a producer signals; re-check after announcing it so a
+        // message published in between is not missed
+        pthread_mutex_lock(&writer_lock);
+        __atomic_store_n(&writer_sleeping, 1, __ATOMIC_SEQ_CST);
+        LogSlot *next = &slots[ring_head & (LOG_SLOTS - 1)];
+        if (__atomic_load_n(&next->seq, __ATOMIC_SEQ_CST) != ring_head + 1) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += 100 * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&writer_wakeup, &writer_lock, &deadline);
+        }
+        __atomic_store_n(&writer_sleeping, 0, __ATOMIC_SEQ_CST);
+        pthread_mutex_unlock(&writer_lock);
+    }
+    return NULL;
+}
+
+void log_init(void) {
+    const char *env = getenv("LOG_LEVEL");
+    if (env != NULL) {
+        int level = log_parse_level(env);
+        if (level >= 0) {
+            log_runtime_level = level;
+        } else {
+            fprintf(stderr, "[Log] Unknown LOG_LEVEL '%s', using info\n", env);
+        }
+    }
+
+    if (running) return;
+    slots = (LogSlot*)calloc(LOG_SLOTS, sizeof(LogSlot));
+    if (slots == NULL) {
+        fprintf(stderr, "[Log] Out of memory, logging synchronously\n");
+        return;
+    }
+    for (size_t i = 0; i < LOG_SLOTS; i++) {
+        slots[i].seq = i;
+    }
+    if (pthread_create(&writer_thread, NULL, log_writer, NULL) != 0) {
+        fprintf(stderr, "[Log] Failed to start writer thread, logging synchronously\n");
+        free(slots);
+        slots = NULL;
+        return;
+    }
+    pthread_detach(writer_thread);
+    __atomic_store_n(&running, 1, __ATOMIC_RELEASE);
+}
+
+void log_write(int level, const char *fmt, ...) {
+    va_list ap;
+    va_start(ap, fmt);
+
+    if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        vfprintf(log_stream(level), fmt, ap);
+        va_end(ap);
+        return;
+    }
+
+    // Claim a slot
+    LogSlot *slot;
+    size_t pos = __atomic_load_n(&ring_tail, __ATOMIC_RELAXED);
+    while (1) {
+        slot = &slots[pos & (LOG_SLOTS - 1)];
+        size_t seq = __atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE);
+        if (seq == pos) {
+            if (__atomic_compare_exchange_n(&ring_tail, &pos, pos + 1, 0,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if ((long)(seq - pos) < 0) {
+            __atomic_fetch_add(&dropped, 1, __ATOMIC_RELAXED);
+            va_end(ap);
+            return;
+        } else {
+            pos = __atomic_load_n(&ring_tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    int len = vsnprintf(slot->text, LOG_LINE_MAX, fmt, ap);
+    va_end(ap);
+    if (len < 0) {
+        len = 0;
+    } else if (len >= LOG_LINE_MAX) {
+        len = LOG_LINE_MAX - 1;
+        slot->text[len - 1] = '\n';
+    }
+    slot->len = len;
+    slot->level = level;
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_SEQ_CST);
+
+    if (__atomic_load_n(&writer_sleeping, __ATOMIC_SEQ_CST)) {
+        pthread_mutex_lock(&writer_lock);
+        pthread_cond_signal(&writer_wakeup);
+        pthread_mutex_unlock(&writer_lock);
+    }
+}
+
+void log_flush(void) {
+    if (!__atomic_load_n(&running, __ATOMIC_ACQUIRE)) {
+        fflush(stdout);
+        return;
+    }
+
+    size_t target = __atomic_load_n(&ring_tail, __ATOMIC_ACQUIRE);
+    pthread_mutex_lock(&writer_lock);
+    pthread_cond_signal(&writer_wakeup);
+    pthread_mutex_unlock(&writer_lock);
+
+    // Bounded wait: a stuck stdout must not hang shutdown
+    struct timespec pause = { 0, 1000000L };
+    for (int i = 0; i < 2000; i++) {
+        if ((long)(__atomic_load_n(&ring_head, __ATOMIC_ACQUIRE) - target) >= 0) break;
+        nanosleep(&pause, NULL);
+    }
+    fflush(stdout);
+}
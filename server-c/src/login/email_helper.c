@@ -1,3 +1,4 @@
+#include "log.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -25,7 +26,7 @@ int send_otp_email(const char *email, const char *otp) {
 
     // Fallback: still log to console if missing config
     if (!smtp_user || !smtp_pass || !smtp_host || !smtp_port || !smtp_from) {
-        fprintf(stderr, "[EMAIL] SMTP env not set. Falling back to console output.\n");
+        LOG_WARN("[EMAIL] SMTP env not set. Falling back to console output.\n");
         printf("========================================\n");
         printf("To: %s\n", email);
         printf("Subject: Chess Game - Password Reset OTP\n");
@@ -46,10 +47,10 @@ int send_otp_email(const char *email, const char *otp) {
 
     int ret = system(cmd);
     if (ret != 0) {
-        fprintf(stderr, "[EMAIL] Failed to send email via script. Exit code: %d\n", ret);
+        LOG_ERROR("[EMAIL] Failed to send email via script. Exit code: %d\n", ret);
         return 0;
     }
 
-    printf("[EMAIL] OTP sent to %s\n", email);
+    LOG_INFO("[EMAIL] OTP sent to %s\n", email);
     return 1;
 }
@@ -1,6 +1,7 @@
 #include "login.h"
 #include "database.h"
 #include "online_users.h"
+#include "log.h"
 #include <stdio.h>
 #include <string.h>
 #include <sys/socket.h>
@@ -12,14 +13,14 @@ unsigned long long simple_hash(const char *str);
 void handle_login(ClientSession *session, char *param1, char *param2, PGconn *db) {
     if (param1 == NULL || param2 == NULL || strlen(param1) == 0 || strlen(param2) == 0) {
         char error[] = "ERROR|Missing credentials\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
         return;
     }
 
     int user_id = db_verify_user(db, param1, param2);
     if (user_id <= 0) {
         char error[] = "ERROR|Invalid credentials\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
         return;
     }
 
@@ -30,8 +31,8 @@ void handle_login(ClientSession *session, char *param1, char *param2, PGconn *db
         if (online_users.entries[i].user_id == user_id) {
             pthread_mutex_unlock(&online_users.lock);
             char error[] = "ERROR|User already logged in\n";
-            send(session->socket_fd, error, strlen(error), 0);
-            printf("[Login] User %d already logged in, rejecting duplicate login\n", user_id);
+            send_to_client(session->socket_fd, error);
+            LOG_INFO("[Login] User %d already logged in, rejecting duplicate login\n", user_id);
             return;
         }
     }
@@ -40,7 +41,7 @@ void handle_login(ClientSession *session, char *param1, char *param2, PGconn *db
     char user_info[256];
     if (!db_get_user_info(db, user_id, user_info, sizeof(user_info))) {
         char error[] = "ERROR|Failed to load user info\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
         return;
     }
 
@@ -59,12 +60,12 @@ void handle_login(ClientSession *session, char *param1, char *param2, PGconn *db
     char update_query[256];
     snprintf(update_query, sizeof(update_query), 
         "UPDATE users SET state = 'online' WHERE user_id = %d", user_id);
-    PGresult *res = PQexec(db, update_query);
+    PGresult *res = db_exec(db, update_query);
     PQclear(res);
 
     char response[256];
     snprintf(response, sizeof(response), "LOGIN_SUCCESS|%d|%s|%s\n", user_id, name, elo);
-    send(session->socket_fd, response, strlen(response), 0);
+    send_to_client(session->socket_fd, response);
 }
 
 void handle_register_validate(ClientSession *session, int num_params, char *param1, char *param2, char *param3, PGconn *db) {
@@ -77,11 +78,11 @@ void handle_register_validate(ClientSession *session, int num_params, char *para
     // Kiểm tra username đã tồn tại chưa
     char query[256];
     snprintf(query, sizeof(query), "SELECT user_id FROM users WHERE name = '%s'", username);
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
     if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
         PQclear(res);
         const char *resp = "REGISTER_ERROR|Username already exists\n";
-        send(session->socket_fd, resp, strlen(resp), 0);
+        send_to_client(session->socket_fd, resp);
         return;
     }
     PQclear(res);
@@ -95,17 +96,17 @@ void handle_register_validate(ClientSession *session, int num_params, char *para
     snprintf(query, sizeof(query),
         "INSERT INTO users (name, password_hash, email) VALUES ('%s', '%s', '%s') RETURNING user_id",
         username, hashstr, email);
-    res = PQexec(db, query);
+    res = db_exec(db, query);
     if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
         int user_id = atoi(PQgetvalue(res, 0, 0));
         PQclear(res);
         char resp[128];
         snprintf(resp, sizeof(resp), "REGISTER_OK|%d\n", user_id);
-        send(session->socket_fd, resp, strlen(resp), 0);
+        send_to_client(session->socket_fd, resp);
     } else {
-        fprintf(stderr, "[Register] DB error: %s\n", PQerrorMessage(db));
+        LOG_ERROR("[Register] DB error: %s\n", PQerrorMessage(db));
         PQclear(res);
         const char *resp = "REGISTER_ERROR|Database error\n";
-        send(session->socket_fd, resp, strlen(resp), 0);
+        send_to_client(session->socket_fd, resp);
     }
 }
@@ -1,4 +1,5 @@
 #include "login.h"
+#include "database.h"
 #include <string.h>
 #include <stdio.h>
 #include <libpq-fe.h>
@@ -21,11 +22,11 @@ void handle_register(ClientSession *session, char *param1, char *param2, char *p
     
     snprintf(query, sizeof(query), "SELECT user_id FROM users WHERE name = '%s'", escaped_username);
     
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
     if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
         PQclear(res);
         const char *resp = "REGISTER_ERROR|Username already exists\n";
-        send(session->socket_fd, resp, strlen(resp), 0);
+        send_to_client(session->socket_fd, resp);
         return;
     }
     PQclear(res);
@@ -42,16 +43,16 @@ void handle_register(ClientSession *session, char *param1, char *param2, char *p
         "INSERT INTO users (name, password_hash, email) VALUES ('%s', '%s', '%s') RETURNING user_id",
         escaped_username, hashstr, escaped_email);
     
-    res = PQexec(db, query);
+    res = db_exec(db, query);
     if (PQresultStatus(res) == PGRES_TUPLES_OK && PQntuples(res) > 0) {
         int user_id = atoi(PQgetvalue(res, 0, 0));
         PQclear(res);
         char resp[128];
         snprintf(resp, sizeof(resp), "REGISTER_OK|%d\n", user_id);
-        send(session->socket_fd, resp, strlen(resp), 0);
+        send_to_client(session->socket_fd, resp);
     } else {
         PQclear(res);
         const char *resp = "REGISTER_ERROR|Database error\n";
-        send(session->socket_fd, resp, strlen(resp), 0);
+        send_to_client(session->socket_fd, resp);
     }
 }
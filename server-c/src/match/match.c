@@ -1,6 +1,8 @@
 #include "match.h"
 #include "game.h"
 #include "elo.h"
+#include "log.h"
+#include "database.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -19,7 +21,7 @@ void handle_start_match(ClientSession *session, char *param1, char *param2,
     char username2[64];
     strcpy(username2, param4);
     
-    printf("[Match] Creating match: %s (ID:%d) vs %s (ID:%d)\n", 
+    LOG_INFO("[Match] Creating match: %s (ID:%d) vs %s (ID:%d)\n", 
            username1, user1_id, username2, user2_id);
     
     // White player (creator) - connected now
@@ -38,22 +40,22 @@ void handle_start_match(ClientSession *session, char *param1, char *param2,
         char update_query[128];
         snprintf(update_query, sizeof(update_query),
             "UPDATE match_game SET status='playing' WHERE match_id=%d", match->match_id);
-        PGresult *res = PQexec(db, update_query);
+        PGresult *res = db_exec(db, update_query);
         PQclear(res);
         
-        session->current_match = match;
+        client_session_set_match(session, match);
         session->user_id = user1_id;
         strcpy(session->username, username1);
         
         char response[512];
-        sprintf(response, "MATCH_CREATED|%d|%s\n", match->match_id, match->board.fen);
-        send(session->socket_fd, response, strlen(response), 0);
+        sprintf(response, "MATCH_CREATED|%d|%s\n", match->match_id, chess_board_get_fen(&match->board));
+        send_to_client(session->socket_fd, response);
         
-        printf("[Match] Match %d created successfully (waiting for opponent)\n", match->match_id);
+        LOG_INFO("[Match] Match %d created successfully (waiting for opponent)\n", match->match_id);
     } else {
         char error[] = "ERROR|Failed to create match\n";
-        send(session->socket_fd, error, strlen(error), 0);
-        printf("[Match] Failed to create match\n");
+        send_to_client(session->socket_fd, error);
+        LOG_WARN("[Match] Failed to create match\n");
     }
 }
 
@@ -66,11 +68,11 @@ void handle_join_match(ClientSession *session, char *param1, char *param2,
     char username[64];
     strcpy(username, param3);
     
-    GameMatch *match = game_manager_find_match(&game_manager, match_id);
+    GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
     
     if (match == NULL) {
         char error[] = "ERROR|Match not found\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
         return;
     }
     
@@ -83,17 +85,18 @@ void handle_join_match(ClientSession *session, char *param1, char *param2,
         match->white_player.socket_fd = session->socket_fd;
         match->white_player.is_online = 1;
         strcpy(match->white_player.username, username);
-        printf("[Match] User %d joined match %d as WHITE\n", user_id, match_id);
+        LOG_INFO("[Match] User %d joined match %d as WHITE\n", user_id, match_id);
     } else if (match->black_player.user_id == user_id) {
         match->black_player.socket_fd = session->socket_fd;
         match->black_player.is_online = 1;
         strcpy(match->black_player.username, username);
         is_black_joining = 1;
-        printf("[Match] User %d joined match %d as BLACK\n", user_id, match_id);
+        LOG_INFO("[Match] User %d joined match %d as BLACK\n", user_id, match_id);
     } else {
         pthread_mutex_unlock(&match->lock);
+        game_match_release(match);
         char error[] = "ERROR|You are not a player in this match\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
         return;
     }
     
@@ -104,33 +107,34 @@ void handle_join_match(ClientSession *session, char *param1, char *param2,
                 "UPDATE match_game SET status='playing' WHERE match_id=%d AND status='waiting'",
                 match_id);
         
-        PGresult *res = PQexec(db, update_query);
+        PGresult *res = db_exec(db, update_query);
         if (PQresultStatus(res) == PGRES_COMMAND_OK) {
             match->status = GAME_PLAYING;
             
             // ✅ FIX: Create timer when match starts (for rematch scenario)
             timer_manager_create_timer(&game_manager.timer_manager, match_id, 30, game_timeout_callback);
             
-            printf("[Match] ✅ Match %d: WAITING → PLAYING (timer created)\n", match_id);
+            LOG_INFO("[Match] ✅ Match %d: WAITING → PLAYING (timer created)\n", match_id);
         } else {
-            printf("[Match] ⚠️ Failed to update match %d status: %s\n", 
+            LOG_WARN("[Match] ⚠️ Failed to update match %d status: %s\n", 
                    match_id, PQerrorMessage(db));
         }
         PQclear(res);
     } else if (!is_black_joining && match->status == GAME_WAITING) {
         // White player joined first - match still waiting for black
-        printf("[Match] White player joined - waiting for black player to start\n");
+        LOG_INFO("[Match] White player joined - waiting for black player to start\n");
     }
     
-    session->current_match = match;
+    client_session_set_match(session, match);
     session->user_id = user_id;
     strcpy(session->username, username);
     
+    char response[300];
+    sprintf(response, "MATCH_JOINED|%d|%s\n", match_id, chess_board_get_fen(&match->board));
+
     pthread_mutex_unlock(&match->lock);
     
-    char response[300];
-    sprintf(response, "MATCH_JOINED|%d|%s\n", match_id, match->board.fen);
-    send(session->socket_fd, response, strlen(response), 0);
+    send_to_client(session->socket_fd, response);
     
     // Notify opponent
     int opponent_fd = (match->white_player.user_id == user_id) 
@@ -140,11 +144,12 @@ void handle_join_match(ClientSession *session, char *param1, char *param2,
     if (opponent_fd > 0 && opponent_fd != session->socket_fd) {
         char notify[256];
         sprintf(notify, "OPPONENT_JOINED|%s\n", username);
-        send(opponent_fd, notify, strlen(notify), 0);
-        printf("[Match] Notified opponent (fd=%d) that %s joined\n", opponent_fd, username);
+        send_to_client(opponent_fd, notify);
+        LOG_INFO("[Match] Notified opponent (fd=%d) that %s joined\n", opponent_fd, username);
     }
     
-    printf("[Match] User %d joined match %d successfully\n", user_id, match_id);
+    LOG_INFO("[Match] User %d joined match %d successfully\n", user_id, match_id);
+    game_match_release(match);
 }
 
 void handle_get_match_status(ClientSession *session, char *param1, PGconn *db) {
@@ -152,11 +157,11 @@ void handle_get_match_status(ClientSession *session, char *param1, PGconn *db) {
     (void)db;
     
     int match_id = atoi(param1);
-    GameMatch *match = game_manager_find_match(&game_manager, match_id);
+    GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
     
     if (match == NULL) {
         char error[] = "ERROR|Match not found\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
         return;
     }
     
@@ -177,19 +182,22 @@ void handle_get_match_status(ClientSession *session, char *param1, PGconn *db) {
             match_id, status_str,
             match->white_player.is_online,
             match->black_player.is_online,
-            match->board.fen,
+            chess_board_get_fen(&match->board),
             match->rematch_id);
     
+    int rematch_id = match->rematch_id;
     pthread_mutex_unlock(&match->lock);
+    game_match_release(match);
     
-    send(session->socket_fd, response, strlen(response), 0);
-    printf("[Match] Sent status for match %d: %s, rematch_id=%d\n", 
-           match_id, status_str, match->rematch_id);
+    send_to_client(session->socket_fd, response);
+    LOG_DEBUG("[Match] Sent status for match %d: %s, rematch_id=%d\n", 
+           match_id, status_str, rematch_id);
 }
 
 void handle_move(ClientSession *session, int num_params, char *param1, 
                 char *param2, char *param3, char *param4, PGconn *db) {
     // MOVE|match_id|player_id|from|to (API) or MOVE|from|to (CLI)
+    GameMatch *current;
     
     if (num_params >= 5) {
         // API format
@@ -198,10 +206,10 @@ void handle_move(ClientSession *session, int num_params, char *param1,
         char *from_square = param3;
         char *to_square = param4;
 
-        GameMatch *match = game_manager_find_match(&game_manager, match_id);
+        GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
         if (match == NULL) {
             char error[] = "ERROR|Match not found\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
             return;
         }
         
@@ -217,9 +225,10 @@ void handle_move(ClientSession *session, int num_params, char *param1,
             } else {
                 snprintf(error, sizeof(error), "ERROR|Game is not in playing state\n");
             }
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
+            LOG_DEBUG("[Move] Rejected: match %d status=%d\n", match_id, match->status);
             pthread_mutex_unlock(&match->lock);
-            printf("[Move] Rejected: match %d status=%d\n", match_id, match->status);
+            game_match_release(match);
             return;
         }
         
@@ -234,19 +243,21 @@ void handle_move(ClientSession *session, int num_params, char *param1,
             player_color = COLOR_BLACK;
         } else {
             char error[] = "ERROR|Player not in match\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
             pthread_mutex_unlock(&match->lock);
-            printf("[Move] Rejected: player %d not in match %d\n", player_id, match_id);
+            game_match_release(match);
+            LOG_DEBUG("[Move] Rejected: player %d not in match %d\n", player_id, match_id);
             return;
         }
         
         // CHECK 3: Must be player's turn
         if (match->board.current_turn != player_color) {
             char error[] = "ERROR|Not your turn\n";
-            send(session->socket_fd, error, strlen(error), 0);
-            pthread_mutex_unlock(&match->lock);
-            printf("[Move] Rejected: not player %d's turn (current=%d)\n", 
+            send_to_client(session->socket_fd, error);
+            LOG_DEBUG("[Move] Rejected: not player %d's turn (current=%d)\n", 
                    player_id, match->board.current_turn);
+            pthread_mutex_unlock(&match->lock);
+            game_match_release(match);
             return;
         }
         
@@ -254,29 +265,32 @@ void handle_move(ClientSession *session, int num_params, char *param1,
         
         // All checks passed
         game_match_make_move(match, player_socket, player_id, from_square, to_square, db);
+        game_match_release(match);
         
-    } else if (num_params >= 3 && session->current_match != NULL) {
+    } else if (num_params >= 3 && (current = client_session_acquire_match(session)) != NULL) {
         // CLI format
-        game_match_make_move(session->current_match, session->socket_fd, 0, param1, param2, db);
+        game_match_make_move(current, session->socket_fd, 0, param1, param2, db);
+        game_match_release(current);
     } else {
         char error[] = "ERROR|Invalid MOVE command format\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
     }
 }
 
 void handle_surrender(ClientSession *session, int num_params, char *param1, 
                      char *param2, PGconn *db) {
     // SURRENDER|match_id|player_id (API) or SURRENDER (CLI)
+    GameMatch *current;
     
     if (num_params >= 3) {
         // API format
         int match_id = atoi(param1);
         int player_id = atoi(param2);
 
-        GameMatch *match = game_manager_find_match(&game_manager, match_id);
+        GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
         if (match == NULL) {
             char error[] = "ERROR|Match not found\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
             return;
         }
         
@@ -302,23 +316,25 @@ void handle_surrender(ClientSession *session, int num_params, char *param1,
             game_match_handle_surrender(match, player_socket, db);
         } else {
             char error[] = "ERROR|Player not in match\n";
-            send(session->socket_fd, error, strlen(error), 0);
+            send_to_client(session->socket_fd, error);
         }
-    } else if (session->current_match != NULL) {
+        game_match_release(match);
+    } else if ((current = client_session_acquire_match(session)) != NULL) {
         // CLI format
-        game_match_handle_surrender(session->current_match, session->socket_fd, db);
+        game_match_handle_surrender(current, session->socket_fd, db);
+        game_match_release(current);
     } else {
         char error[] = "ERROR|Not in a match\n";
-        send(session->socket_fd, error, strlen(error), 0);
+        send_to_client(session->socket_fd, error);
     }
 }
 
 void handle_create_match(ClientSession *session, char *param1, char *param2, PGconn *db) {
     // TODO: Implement actual logic
-    printf("handle_create_match called (stub)\n");
+    LOG_DEBUG("handle_create_match called (stub)\n");
 }
 
 void handle_get_game_state(ClientSession *session, char *param1, PGconn *db) {
     // TODO: Implement actual logic
-    printf("handle_get_game_state called (stub)\n");
+    LOG_DEBUG("handle_get_game_state called (stub)\n");
 }
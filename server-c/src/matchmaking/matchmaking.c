@@ -2,11 +2,13 @@
 #include "client_session.h"
 #include "database.h"
 #include "game.h"
+#include "log.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include <sys/socket.h>
+#include <pthread.h>
 
 typedef struct MMPlayer {
     char id[64];        // username
@@ -29,6 +31,9 @@ static MMPlayer *g_players = NULL;   // tất cả player từng join
 static MMPlayer *g_waiting = NULL;   // hàng chờ
 static int g_next_match_id = 1;
 
+// The queue is shared by every reactor thread
+static pthread_mutex_t g_mm_lock = PTHREAD_MUTEX_INITIALIZER;
+
 static MMPlayer *find_player(const char *id) {
     MMPlayer *p = g_players;
     while (p) {
@@ -82,7 +87,7 @@ static MMPlayer *find_match(MMPlayer *me) {
  * -> QUEUED
  * -> MATCHED <match_id> <white_id> <black_id> <my_color>
  */
-int handle_mmjoin(const char *payload, char *out, size_t out_size) {
+static int mmjoin_locked(const char *payload, char *out, size_t out_size) {
     // Parse payload: <user_id> <elo> <time_mode>
     char user_id[64], time_mode[16];
     int elo;
@@ -161,7 +166,7 @@ int handle_mmjoin(const char *payload, char *out, size_t out_size) {
  * -> MATCHED <match_id> <white_id> <black_id> <my_color>
  * -> NOTFOUND
  */
-int handle_mmstatus(const char *payload, char *out, size_t out_size) {
+static int mmstatus_locked(const char *payload, char *out, size_t out_size) {
     char user_id[64];
     if (sscanf(payload, "%63s", user_id) != 1) {
         snprintf(out, out_size, "ERROR|Invalid MMSTATUS payload\n");
@@ -201,7 +206,7 @@ int handle_mmstatus(const char *payload, char *out, size_t out_size) {
  * -> CANCELED
  * -> NOTFOUND
  */
-int handle_mmcancel(const char *payload, char *out, size_t out_size) {
+static int mmcancel_locked(const char *payload, char *out, size_t out_size) {
     char user_id[64];
     if (sscanf(payload, "%63s", user_id) != 1) {
         snprintf(out, out_size, "ERROR|Invalid MMCANCEL payload\n");
@@ -233,11 +238,11 @@ static void update_user_status(PGconn *db, int user_id, const char *status) {
     char query[256];
     snprintf(query, sizeof(query), 
         "UPDATE users SET state = '%s' WHERE user_id = %d", status, user_id);
-    PGresult *res = PQexec(db, query);
+    PGresult *res = db_exec(db, query);
     PQclear(res);
 }
 
-void handle_join_matchmaking(ClientSession *session, char *user_id_str, PGconn *db) {
+static void join_matchmaking_locked(ClientSession *session, char *user_id_str, PGconn *db) {
     int user_id = atoi(user_id_str);
     
     // Tạo hoặc tìm player
@@ -262,7 +267,7 @@ void handle_join_matchmaking(ClientSession *session, char *user_id_str, PGconn *
     while (p) {
         if (p == me) {
             char resp[] = "MATCHMAKING_QUEUED\n";
-            send(session->socket_fd, resp, strlen(resp), 0);
+            send_to_client(session->socket_fd, resp);
             return;
         }
         p = p->next;
@@ -336,8 +341,8 @@ void handle_join_matchmaking(ClientSession *session, char *user_id_str, PGconn *
             match->status = GAME_PLAYING;
             
             // Update both sessions
-            me->session->current_match = match;
-            opp->session->current_match = match;
+            client_session_set_match(me->session, match);
+            client_session_set_match(opp->session, match);
             
             // Gửi thông báo cho cả 2 người chơi với match_id thật từ database
             char msg_me[256], msg_opp[256];
@@ -346,31 +351,31 @@ void handle_join_matchmaking(ClientSession *session, char *user_id_str, PGconn *
             snprintf(msg_opp, sizeof(msg_opp), "MATCH_FOUND|%d|%s|%s\n", 
                      match->match_id, me->id, opp->color);
             
-            send(me->session->socket_fd, msg_me, strlen(msg_me), 0);
-            send(opp->session->socket_fd, msg_opp, strlen(msg_opp), 0);
+            send_to_client(me->session->socket_fd, msg_me);
+            send_to_client(opp->session->socket_fd, msg_opp);
             
-            printf("[Matchmaking] Match %d created: %s vs %s\n", 
+            LOG_INFO("[Matchmaking] Match %d created: %s vs %s\n", 
                    match->match_id, me->id, opp->id);
         } else {
             // Failed to create match
             char error[] = "ERROR|Failed to create match\n";
-            send(me->session->socket_fd, error, strlen(error), 0);
-            send(opp->session->socket_fd, error, strlen(error), 0);
+            send_to_client(me->session->socket_fd, error);
+            send_to_client(opp->session->socket_fd, error);
         }
     } else {
         // Thêm vào hàng chờ
         add_waiting(me);
         char resp[] = "MATCHMAKING_QUEUED\n";
-        send(session->socket_fd, resp, strlen(resp), 0);
-        printf("[Matchmaking] Player %s added to queue\n", me->id);
+        send_to_client(session->socket_fd, resp);
+        LOG_INFO("[Matchmaking] Player %s added to queue\n", me->id);
     }
 }
 
-void handle_leave_matchmaking(ClientSession *session, char *user_id_str, PGconn *db) {
+static void leave_matchmaking_locked(ClientSession *session, char *user_id_str, PGconn *db) {
     MMPlayer *me = find_player(session->username);
     if (!me) {
         char resp[] = "ERROR|Not in matchmaking\n";
-        send(session->socket_fd, resp, strlen(resp), 0);
+        send_to_client(session->socket_fd, resp);
         return;
     }
     
@@ -380,13 +385,46 @@ void handle_leave_matchmaking(ClientSession *session, char *user_id_str, PGconn
         if (p == me) {
             remove_waiting(me);
             char resp[] = "MATCHMAKING_LEFT\n";
-            send(session->socket_fd, resp, strlen(resp), 0);
-            printf("[Matchmaking] Player %s left queue\n", me->id);
+            send_to_client(session->socket_fd, resp);
+            LOG_INFO("[Matchmaking] Player %s left queue\n", me->id);
             return;
         }
         p = p->next;
     }
     
     char resp[] = "ERROR|Not in queue\n";
-    send(session->socket_fd, resp, strlen(resp), 0);
+    send_to_client(session->socket_fd, resp);
+}
+
+int handle_mmjoin(const char *payload, char *out, size_t out_size) {
+    pthread_mutex_lock(&g_mm_lock);
+    int rc = mmjoin_locked(payload, out, out_size);
+    pthread_mutex_unlock(&g_mm_lock);
+    return rc;
+}
+
+int handle_mmstatus(const char *payload, char *out, size_t out_size) {
+    pthread_mutex_lock(&g_mm_lock);
+    int rc = mmstatus_locked(payload, out, out_size);
+    pthread_mutex_unlock(&g_mm_lock);
+    return rc;
+}
+
+int handle_mmcancel(const char *payload, char *out, size_t out_size) {
+    pthread_mutex_lock(&g_mm_lock);
+    int rc = mmcancel_locked(payload, out, out_size);
+    pthread_mutex_unlock(&g_mm_lock);
+    return rc;
+}
+
+void handle_join_matchmaking(ClientSession *session, char *user_id_str, PGconn *db) {
+    pthread_mutex_lock(&g_mm_lock);
+    join_matchmaking_locked(session, user_id_str, db);
+    pthread_mutex_unlock(&g_mm_lock);
+}
+
+void handle_leave_matchmaking(ClientSession *session, char *user_id_str, PGconn *db) {
+    pthread_mutex_lock(&g_mm_lock);
+    leave_matchmaking_locked(session, user_id_str, db);
+    pthread_mutex_unlock(&g_mm_lock);
 }
@@ -14,9 +14,14 @@
 #include "chat.h"
 #include "game_chat.h"
 #include "email_helper.h"
+#include "log.h"
+#include "server_stats.h"
+#include "online_users.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
+#include <stdarg.h>
 #include <sys/socket.h>
 
 // External global variable
@@ -40,184 +45,486 @@ void handle_get_stats(ClientSession *session, char *param1, PGconn *db) {
     handle_stats_request(db, session->socket_fd, user_id);
 }
 
-void protocol_handle_command(ClientSession *session, const char *buffer, PGconn *db) {
-    // Parse command
-    char command[32], param1[64], param2[64], param3[64], param4[64];
-    memset(command, 0, sizeof(command));
-    memset(param1, 0, sizeof(param1));
-    memset(param2, 0, sizeof(param2));
-    memset(param3, 0, sizeof(param3));
-    memset(param4, 0, sizeof(param4));
-    
-    int num_params = sscanf(buffer, "%[^|]|%[^|]|%[^|]|%[^|]|%s", 
-                            command, param1, param2, param3, param4);
-    
-    printf("[Protocol] Command: '%s' | Params: %d\n", command, num_params);
-    
-    // Route to appropriate handler
-    if (strcmp(command, "LOGIN") == 0) {
-        handle_login(session, param1, param2, db);
-    } else if (strcmp(command, "LOGOUT") == 0) {
-        handle_logout(session);
-    } else if (strcmp(command, "REGISTER") == 0) {
-        handle_register_validate(session, num_params, param1, param2, param3, db);
-    } else if (strcmp(command, "REGISTER_VALIDATE") == 0) {
-        handle_register_validate(session, num_params, param1, param2, param3, db);
-    } else if (strcmp(command, "FORGOT_PASSWORD") == 0) {
-        // FORGOT_PASSWORD|email
-        char email[128] = {0};
-        int user_id = db_get_user_email(db, param1, email, sizeof(email));
-        
-        if (user_id > 0) {
-            char otp[7];
-            generate_otp(otp, 6);
-            
-            if (db_save_otp(db, user_id, otp)) {
-                if (send_otp_email(email, otp)) {
-                    char resp[256];
-                    snprintf(resp, sizeof(resp), "OTP_SENT|%d|%s\n", user_id, email);
-                    send(session->socket_fd, resp, strlen(resp), 0);
-                    printf("[Password Reset] OTP sent to %s for user_id %d\n", email, user_id);
-                } else {
-                    send(session->socket_fd, "ERROR|Failed to send OTP email\n", 32, 0);
-                }
+
+// ==================== TOKENIZER ====================
+
+static char protocol_empty_arg[1];
+
+// Split a line into '|'-separated fields in place: every separator becomes a
+// NUL and the fields are returned as slices of the caller's buffer. An empty
+// field ends the line, as it did for the old sscanf parser: "MOVE|1||e2" has
+// two fields, so a handler never sees a blank argument ahead of a real one.
+int protocol_tokenize(char *line, ProtocolArgs *args) {
+    int argc = 0;
+    char *field = line;
+    while (1) {
+        char *sep = strchr(field, '|');
+        // The last slot keeps the rest of the line
+        int last = (argc == PROTOCOL_MAX_ARGS - 1 || sep == NULL);
+        size_t len = last ? strlen(field) : (size_t)(sep - field);
+        if (len == 0) break;
+        if (!last) *sep = '\0';
+        args->argv[argc] = field;
+        args->len[argc] = len;
+        argc++;
+        if (last) break;
+        field = sep + 1;
+    }
+    args->argc = argc;
+    for (int i = argc; i < PROTOCOL_MAX_ARGS; i++) {
+        args->argv[i] = protocol_empty_arg;
+        args->len[i] = 0;
+    }
+    return argc;
+}
+
+// ==================== COMMAND TABLE ====================
+
+#define ARG(n) (args->argv[n])
+
+static void cmd_login(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_login(session, ARG(1), ARG(2), db);
+}
+
+static void cmd_logout(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    (void)args;
+    handle_logout(session, db);
+}
+
+static void cmd_register(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_register_validate(session, args->argc, ARG(1), ARG(2), ARG(3), db);
+}
+
+static void cmd_forgot_password(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    // FORGOT_PASSWORD|email
+    char email[128] = {0};
+    int user_id = db_get_user_email(db, ARG(1), email, sizeof(email));
+
+    if (user_id > 0) {
+        char otp[7];
+        generate_otp(otp, 6);
+
+        if (db_save_otp(db, user_id, otp)) {
+            if (send_otp_email(email, otp)) {
+                char resp[256];
+                snprintf(resp, sizeof(resp), "OTP_SENT|%d|%s\n", user_id, email);
+                send_to_client(session->socket_fd, resp);
+                LOG_INFO("[Password Reset] OTP sent to %s for user_id %d\n", email, user_id);
             } else {
-                send(session->socket_fd, "ERROR|Failed to save OTP\n", 26, 0);
+                send_to_client(session->socket_fd, "ERROR|Failed to send OTP email\n");
             }
         } else {
-            send(session->socket_fd, "ERROR|User not found or no email registered\n", 45, 0);
+            send_to_client(session->socket_fd, "ERROR|Failed to save OTP\n");
         }
-    } else if (strcmp(command, "RESET_PASSWORD") == 0) {
-        // RESET_PASSWORD|user_id|otp|new_password
-        int user_id = atoi(param1);
-        
-        if (db_reset_password(db, user_id, param3, param2)) {
-            send(session->socket_fd, "PASSWORD_RESET_OK\n", 18, 0);
-            printf("[Password Reset] Password reset successful for user_id %d\n", user_id);
-        } else {
-            send(session->socket_fd, "ERROR|Invalid or expired OTP\n", 30, 0);
-        }
-    } else if (strcmp(command, "CHAT") == 0) {
-        // CHAT|to_user|message
-        handle_chat(session, num_params, param1, param2);
-    } else if (strcmp(command, "GAME_CHAT") == 0) {
-        // GAME_CHAT|match_id|message
-        int match_id = atoi(param1);
-        handle_game_chat(session, match_id, param2, db);
-    }
-    // Match/game logic
-    else if (strcmp(command, "CREATE_MATCH") == 0) {
-        handle_create_match(session, param1, param2, db);
-    } else if (strcmp(command, "JOIN_MATCH") == 0) {
-        handle_join_match(session, param1, param2, param3, db);
-    } else if (strcmp(command, "START_MATCH") == 0) {
-        handle_start_match(session, param1, param2, param3, param4, db);
-    } else if (strcmp(command, "GET_MATCH_STATUS") == 0) {
-        handle_get_match_status(session, param1, db);
-    } else if (strcmp(command, "MOVE") == 0) {
-        handle_move(session, num_params, param1, param2, param3, param4, db);
-    } else if (strcmp(command, "SURRENDER") == 0) {
-        handle_surrender(session, num_params, param1, param2, db);
-    } else if (strcmp(command, "GET_GAME_STATE") == 0) {
-        handle_get_game_state(session, param1, db);
-    } else if (strcmp(command, "GET_HISTORY") == 0) {
-        handle_get_history(session, param1, db);
-    } else if (strcmp(command, "GET_REPLAY") == 0) {
-        handle_get_replay(session, param1, db);
-    } else if (strcmp(command, "GET_STATS") == 0) {
-        handle_get_stats(session, param1, db);
+    } else {
+        send_to_client(session->socket_fd, "ERROR|User not found or no email registered\n");
     }
-    // Bot
-    else if (strcmp(command, "MODE_BOT") == 0) {
-        // MODE_BOT|user_id|difficulty
-        handle_mode_bot(session, param1, param2, db);
-    } else if (strcmp(command, "BOT_MOVE") == 0) {
-        // BOT_MOVE|match_id|player_move|difficulty
-        handle_bot_move(session, num_params, param1, param2, param3, db);
+}
+
+static void cmd_reset_password(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    // RESET_PASSWORD|user_id|otp|new_password
+    int user_id = atoi(ARG(1));
+
+    if (db_reset_password(db, user_id, ARG(3), ARG(2))) {
+        send_to_client(session->socket_fd, "PASSWORD_RESET_OK\n");
+        LOG_INFO("[Password Reset] Password reset successful for user_id %d\n", user_id);
+    } else {
+        send_to_client(session->socket_fd, "ERROR|Invalid or expired OTP\n");
     }
-    // Friend
-    else if (strcmp(command, "FRIEND_REQUEST") == 0) {
-        handle_friend_request(session, num_params, param1, param2, db);
-    } else if (strcmp(command, "FRIEND_ACCEPT") == 0) {
-        handle_friend_accept(session, num_params, param1, param2, db);
-    } else if (strcmp(command, "FRIEND_DECLINE") == 0) {
-        handle_friend_decline(session, num_params, param1, param2, db);
-    } else if (strcmp(command, "FRIEND_LIST") == 0) {
-        handle_friend_list(session, num_params, param1, db);
-    } else if (strcmp(command, "FRIEND_REQUESTS") == 0) {
-        handle_friend_requests(session, num_params, param1, db);
+}
+
+static void cmd_chat(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    // CHAT|to_user|message
+    (void)db;
+    handle_chat(session, args->argc, ARG(1), ARG(2));
+}
+
+static void cmd_game_chat(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    // GAME_CHAT|match_id|message
+    handle_game_chat(session, atoi(ARG(1)), ARG(2), db);
+}
+
+// Match/game logic
+static void cmd_create_match(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_create_match(session, ARG(1), ARG(2), db);
+}
+
+static void cmd_join_match(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_join_match(session, ARG(1), ARG(2), ARG(3), db);
+}
+
+static void cmd_start_match(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_start_match(session, ARG(1), ARG(2), ARG(3), ARG(4), db);
+}
+
+static void cmd_get_match_status(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_get_match_status(session, ARG(1), db);
+}
+
+static void cmd_move(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_move(session, args->argc, ARG(1), ARG(2), ARG(3), ARG(4), db);
+}
+
+static void cmd_surrender(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_surrender(session, args->argc, ARG(1), ARG(2), db);
+}
+
+static void cmd_get_game_state(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_get_game_state(session, ARG(1), db);
+}
+
+static void cmd_get_history(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_get_history(session, ARG(1), db);
+}
+
+static void cmd_get_replay(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_get_replay(session, ARG(1), db);
+}
+
+static void cmd_get_stats(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_get_stats(session, ARG(1), db);
+}
+
+// Bot
+static void cmd_mode_bot(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    // MODE_BOT|user_id|difficulty
+    handle_mode_bot(session, ARG(1), ARG(2), db);
+}
+
+static void cmd_bot_move(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    // BOT_MOVE|match_id|player_move|difficulty
+    handle_bot_move(session, args->argc, ARG(1), ARG(2), ARG(3), db);
+}
+
+// Friend
+static void cmd_friend_request(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_friend_request(session, args->argc, ARG(1), ARG(2), db);
+}
+
+static void cmd_friend_accept(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_friend_accept(session, args->argc, ARG(1), ARG(2), db);
+}
+
+static void cmd_friend_decline(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_friend_decline(session, args->argc, ARG(1), ARG(2), db);
+}
+
+static void cmd_friend_list(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_friend_list(session, args->argc, ARG(1), db);
+}
+
+static void cmd_friend_requests(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_friend_requests(session, args->argc, ARG(1), db);
+}
+
+// Timer
+static void cmd_start_timer(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_start_timer(session, ARG(1), db);
+}
+
+static void cmd_stop_timer(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_stop_timer(session, ARG(1), db);
+}
+
+static void cmd_pause_timer(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_pause_timer(session, ARG(1), db);
+}
+
+static void cmd_resume_timer(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_resume_timer(session, ARG(1), db);
+}
+
+static void cmd_get_time(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_get_time(session, ARG(1), db);
+}
+
+// Game control
+static void cmd_pause(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_pause(session, args->argc, ARG(1), ARG(2), db);
+}
+
+static void cmd_resume(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_resume(session, args->argc, ARG(1), ARG(2), db);
+}
+
+static void cmd_draw(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_draw_request(session, args->argc, ARG(1), ARG(2), db);
+}
+
+static void cmd_draw_accept(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_draw_accept(session, args->argc, ARG(1), ARG(2), db);
+}
+
+static void cmd_draw_decline(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_draw_decline(session, args->argc, ARG(1), ARG(2), db);
+}
+
+static void cmd_rematch(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_rematch_request(session, args->argc, ARG(1), ARG(2), db);
+}
+
+static void cmd_rematch_accept(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_rematch_accept(session, args->argc, ARG(1), ARG(2), db);
+}
+
+static void cmd_rematch_decline(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_rematch_decline(session, args->argc, ARG(1), ARG(2), db);
+}
+
+// Matchmaking
+static void cmd_join_matchmaking(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_join_matchmaking(session, ARG(1), db);
+}
+
+static void cmd_leave_matchmaking(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    handle_leave_matchmaking(session, ARG(1), db);
+}
+
+static void cmd_mmjoin(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    (void)db;
+    char payload[256];
+    snprintf(payload, sizeof(payload), "%s %s %s", ARG(1), ARG(2), ARG(3));
+    char resp[256];
+    memset(resp, 0, sizeof(resp));
+    handle_mmjoin(payload, resp, sizeof(resp));
+    send_to_client(session->socket_fd, resp);
+}
+
+static void cmd_mmstatus(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    (void)db;
+    char resp[256];
+    memset(resp, 0, sizeof(resp));
+    handle_mmstatus(ARG(1), resp, sizeof(resp));
+    send_to_client(session->socket_fd, resp);
+}
+
+static void cmd_mmcancel(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    (void)db;
+    char resp[256];
+    memset(resp, 0, sizeof(resp));
+    handle_mmcancel(ARG(1), resp, sizeof(resp));
+    send_to_client(session->socket_fd, resp);
+}
+
+// ELO Leaderboard
+static void cmd_get_leaderboard(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    char output[2048] = {0};
+    int limit = 20;
+    if (args->argc >= 2) limit = atoi(ARG(1));
+    elo_get_leaderboard(db, output, sizeof(output), limit);
+    send_to_client(session->socket_fd, output);
+}
+
+// ELO History
+static void cmd_get_elo_history(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    char output[2048] = {0};
+    int user_id = atoi(ARG(1));
+    elo_get_history(db, user_id, output, sizeof(output));
+    send_to_client(session->socket_fd, output);
+}
+
+static void cmd_server_stats(ClientSession *session, ProtocolArgs *args, PGconn *db);
+
+#define COMMAND(name, fn, min_args, flags) { name, sizeof(name) - 1, fn, min_args, flags }
+
+// PROTOCOL_DB marks commands whose handlers are dominated by database
+// queries; the reactor runs those on the DB worker pool
+static const ProtocolCommand command_table[] = {
+    COMMAND("LOGIN",             cmd_login,             1, PROTOCOL_DB),
+    COMMAND("LOGOUT",            cmd_logout,            1, PROTOCOL_DB),
+    COMMAND("REGISTER",          cmd_register,          1, PROTOCOL_DB),
+    COMMAND("REGISTER_VALIDATE", cmd_register,          1, PROTOCOL_DB),
+    COMMAND("FORGOT_PASSWORD",   cmd_forgot_password,   1, PROTOCOL_DB),
+    COMMAND("RESET_PASSWORD",    cmd_reset_password,    1, PROTOCOL_DB),
+    COMMAND("CHAT",              cmd_chat,              1, 0),
+    COMMAND("GAME_CHAT",         cmd_game_chat,         1, PROTOCOL_DB),
+    COMMAND("CREATE_MATCH",      cmd_create_match,      1, 0),
+    COMMAND("JOIN_MATCH",        cmd_join_match,        1, 0),
+    COMMAND("START_MATCH",       cmd_start_match,       1, 0),
+    COMMAND("GET_MATCH_STATUS",  cmd_get_match_status,  1, 0),
+    COMMAND("MOVE",              cmd_move,              1, 0),
+    COMMAND("SURRENDER",         cmd_surrender,         1, PROTOCOL_DB),
+    COMMAND("GET_GAME_STATE",    cmd_get_game_state,    1, 0),
+    COMMAND("GET_HISTORY",       cmd_get_history,       1, PROTOCOL_DB),
+    COMMAND("GET_REPLAY",        cmd_get_replay,        1, PROTOCOL_DB),
+    COMMAND("GET_STATS",         cmd_get_stats,         1, PROTOCOL_DB),
+    COMMAND("MODE_BOT",          cmd_mode_bot,          1, 0),
+    COMMAND("BOT_MOVE",          cmd_bot_move,          1, 0),
+    COMMAND("FRIEND_REQUEST",    cmd_friend_request,    1, PROTOCOL_DB),
+    COMMAND("FRIEND_ACCEPT",     cmd_friend_accept,     1, PROTOCOL_DB),
+    COMMAND("FRIEND_DECLINE",    cmd_friend_decline,    1, PROTOCOL_DB),
+    COMMAND("FRIEND_LIST",       cmd_friend_list,       1, PROTOCOL_DB),
+    COMMAND("FRIEND_REQUESTS",   cmd_friend_requests,   1, PROTOCOL_DB),
+    COMMAND("START_TIMER",       cmd_start_timer,       1, 0),
+    COMMAND("STOP_TIMER",        cmd_stop_timer,        1, 0),
+    COMMAND("PAUSE_TIMER",       cmd_pause_timer,       1, 0),
+    COMMAND("RESUME_TIMER",      cmd_resume_timer,      1, 0),
+    COMMAND("GET_TIME",          cmd_get_time,          1, 0),
+    COMMAND("PAUSE",             cmd_pause,             1, 0),
+    COMMAND("RESUME",            cmd_resume,            1, 0),
+    COMMAND("DRAW",              cmd_draw,              1, 0),
+    COMMAND("DRAW_ACCEPT",       cmd_draw_accept,       1, 0),
+    COMMAND("DRAW_DECLINE",      cmd_draw_decline,      1, 0),
+    COMMAND("REMATCH",           cmd_rematch,           1, 0),
+    COMMAND("REMATCH_ACCEPT",    cmd_rematch_accept,    1, 0),
+    COMMAND("REMATCH_DECLINE",   cmd_rematch_decline,   1, 0),
+    COMMAND("JOIN_MATCHMAKING",  cmd_join_matchmaking,  2, 0),
+    COMMAND("LEAVE_MATCHMAKING", cmd_leave_matchmaking, 2, 0),
+    COMMAND("MMJOIN",            cmd_mmjoin,            4, 0),
+    COMMAND("MMSTATUS",          cmd_mmstatus,          2, 0),
+    COMMAND("MMCANCEL",          cmd_mmcancel,          2, 0),
+    COMMAND("GET_LEADERBOARD",   cmd_get_leaderboard,   1, PROTOCOL_DB),
+    COMMAND("GET_ELO_HISTORY",   cmd_get_elo_history,   1, PROTOCOL_DB),
+    COMMAND("SERVER_STATS",      cmd_server_stats,      2, 0),
+};
+
+#define COMMAND_COUNT (sizeof(command_table) / sizeof(command_table[0]))
+_Static_assert(COMMAND_COUNT <= SERVER_STATS_MAX_COMMANDS, "raise SERVER_STATS_MAX_COMMANDS");
+#define COMMAND_SLOTS 512       // Power of two, a few times the command count
+
+// Perfect hash over the command names: protocol_init() picks a seed under
+// which every command lands in its own slot, so a lookup is one hash and
+// one compare with no probing
+static const ProtocolCommand *command_slots[COMMAND_SLOTS];
+static uint32_t command_seed;
+
+static inline uint32_t command_hash(uint32_t seed, const char *name, size_t len) {
+    uint32_t h = seed;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)name[i]) * 16777619u;
     }
-    // Timer
-    else if (strcmp(command, "START_TIMER") == 0) {
-        handle_start_timer(session, param1, db);
-    } else if (strcmp(command, "STOP_TIMER") == 0) {
-        handle_stop_timer(session, param1, db);
-    } else if (strcmp(command, "PAUSE_TIMER") == 0) {
-        handle_pause_timer(session, param1, db);
-    } else if (strcmp(command, "RESUME_TIMER") == 0) {
-        handle_resume_timer(session, param1, db);
-    } else if (strcmp(command, "GET_TIME") == 0) {
-        handle_get_time(session, param1, db);
+    return (h ^ (h >> 15)) & (COMMAND_SLOTS - 1);
+}
+
+int protocol_init(void) {
+    for (uint32_t seed = 2166136261u; seed != 2166136261u + 100000; seed++) {
+        memset(command_slots, 0, sizeof(command_slots));
+        size_t i;
+        for (i = 0; i < COMMAND_COUNT; i++) {
+            const ProtocolCommand *cmd = &command_table[i];
+            uint32_t slot = command_hash(seed, cmd->name, cmd->name_len);
+            if (command_slots[slot] != NULL) break;
+            command_slots[slot] = cmd;
+        }
+        if (i == COMMAND_COUNT) {
+            command_seed = seed;
+            return 0;
+        }
     }
-    // Game control
-    else if (strcmp(command, "PAUSE") == 0) {
-        handle_pause(session, num_params, param1, param2, db);
-    } else if (strcmp(command, "RESUME") == 0) {
-        handle_resume(session, num_params, param1, param2, db);
-    } else if (strcmp(command, "DRAW") == 0) {
-        handle_draw_request(session, num_params, param1, param2, db);
-    } else if (strcmp(command, "DRAW_ACCEPT") == 0) {
-        handle_draw_accept(session, num_params, param1, param2, db);
-    } else if (strcmp(command, "DRAW_DECLINE") == 0) {
-        handle_draw_decline(session, num_params, param1, param2, db);
-    } else if (strcmp(command, "REMATCH") == 0) {
-        handle_rematch_request(session, num_params, param1, param2, db);
-    } else if (strcmp(command, "REMATCH_ACCEPT") == 0) {
-        handle_rematch_accept(session, num_params, param1, param2, db);
-    } else if (strcmp(command, "REMATCH_DECLINE") == 0) {
-        handle_rematch_decline(session, num_params, param1, param2, db);
+    memset(command_slots, 0, sizeof(command_slots));
+    LOG_ERROR("[Protocol] No collision-free seed for the command table\n");
+    return -1;
+}
+
+const ProtocolCommand* protocol_find_command(const char *line) {
+    size_t len = strcspn(line, "|");
+    const ProtocolCommand *cmd = command_slots[command_hash(command_seed, line, len)];
+    if (cmd != NULL && cmd->name_len == len && memcmp(cmd->name, line, len) == 0) {
+        return cmd;
     }
-    // Matchmaking
-    else if (strcmp(command, "JOIN_MATCHMAKING") == 0 && num_params >= 2) {
-        handle_join_matchmaking(session, param1, db);
-    } else if (strcmp(command, "LEAVE_MATCHMAKING") == 0 && num_params >= 2) {
-        handle_leave_matchmaking(session, param1, db);
-    } else if (strcmp(command, "MMJOIN") == 0 && num_params >= 4) {
-        char payload[256];
-        snprintf(payload, sizeof(payload), "%s %s %s", param1, param2, param3);
-        char resp[256];
-        memset(resp, 0, sizeof(resp));
-        handle_mmjoin(payload, resp, sizeof(resp));
-        send(session->socket_fd, resp, strlen(resp), 0);
-    } else if (strcmp(command, "MMSTATUS") == 0 && num_params >= 2) {
-        char resp[256];
-        memset(resp, 0, sizeof(resp));
-        handle_mmstatus(param1, resp, sizeof(resp));
-        send(session->socket_fd, resp, strlen(resp), 0);
-    } else if (strcmp(command, "MMCANCEL") == 0 && num_params >= 2) {
-        char resp[256];
-        memset(resp, 0, sizeof(resp));
-        handle_mmcancel(param1, resp, sizeof(resp));
-        send(session->socket_fd, resp, strlen(resp), 0);
+    return NULL;
+}
+
+// ==================== SERVER STATS ====================
+
+#define STATS_US(ns) ((double)(ns) / 1000.0)
+
+// Append to the first len bytes of out[size]. Returns the new length, which
+// stops at size - 1 when the text does not fit, so the line is cut short
+// but stays terminated.
+static size_t stats_append(char *out, size_t size, size_t len, const char *fmt, ...) {
+    if (len + 1 >= size) return len;
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(out + len, size - len, fmt, ap);
+    va_end(ap);
+    if (n < 0) return len;
+    len += (size_t)n;
+    return len < size ? len : size - 1;
+}
+
+static size_t stats_append_histogram(char *out, size_t size, size_t len,
+                                     const char *label, const LatencyHistogram *hist) {
+    return stats_append(out, size, len, "|%s_p50=%.1f|%s_p99=%.1f|%s_p999=%.1f",
+                        label, STATS_US(latency_histogram_percentile(hist, 50.0)),
+                        label, STATS_US(latency_histogram_percentile(hist, 99.0)),
+                        label, STATS_US(latency_histogram_percentile(hist, 99.9)));
+}
+
+// SERVER_STATS|token
+// One summary line, one SERVER_STATS_CMD line per command that has run
+// (latencies in microseconds), then SERVER_STATS_END
+static void cmd_server_stats(ClientSession *session, ProtocolArgs *args, PGconn *db) {
+    (void)db;
+    if (!server_stats_authorized(ARG(1))) {
+        send_to_client(session->socket_fd, "ERROR|Not authorized\n");
+        LOG_WARN("[Stats] Rejected SERVER_STATS from fd %d\n", session->socket_fd);
+        return;
     }
-    // ELO Leaderboard
-    else if (strcmp(command, "GET_LEADERBOARD") == 0) {
-        char output[2048] = {0};
-        int limit = 20;
-        if (num_params >= 2) limit = atoi(param1);
-        elo_get_leaderboard(db, output, sizeof(output), limit);
-        send(session->socket_fd, output, strlen(output), 0);
+
+    pthread_mutex_lock(&game_manager.lock);
+    int matches = game_manager.match_count;
+    pthread_mutex_unlock(&game_manager.lock);
+
+    pthread_mutex_lock(&game_manager.timer_manager.lock);
+    int timers = game_manager.timer_manager.timer_count;
+    pthread_mutex_unlock(&game_manager.timer_manager.lock);
+
+    pthread_mutex_lock(&online_users.lock);
+    int users = online_users.count;
+    pthread_mutex_unlock(&online_users.lock);
+
+    char line[512];
+    snprintf(line, sizeof(line),
+             "SERVER_STATS|uptime=%ld|sessions=%d|online_users=%d|matches=%d|timers=%d\n",
+             server_stats_uptime(), server_stats_sessions(), users, matches, timers);
+    send_to_client(session->socket_fd, line);
+
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        const CommandStats *stats = server_stats_command((int)i);
+        if (stats == NULL) break;
+        uint64_t count = __atomic_load_n(&stats->total.total_count, __ATOMIC_RELAXED);
+        if (count == 0) continue;
+
+        // Leave room for the newline even when the fields are cut short
+        size_t room = sizeof(line) - 1;
+        size_t len = stats_append(line, room, 0, "SERVER_STATS_CMD|%s|count=%llu|max=%.1f",
+                                  command_table[i].name, (unsigned long long)count,
+                                  STATS_US(__atomic_load_n(&stats->total.max, __ATOMIC_RELAXED)));
+        len = stats_append_histogram(line, room, len, "total", &stats->total);
+        len = stats_append_histogram(line, room, len, "db", &stats->db);
+        len = stats_append_histogram(line, room, len, "other", &stats->other);
+        line[len++] = '\n';
+        line[len] = '\0';
+        send_to_client(session->socket_fd, line);
     }
-    // ELO History
-    else if (strcmp(command, "GET_ELO_HISTORY") == 0) {
-        char output[2048] = {0};
-        int user_id = atoi(param1);
-        elo_get_history(db, user_id, output, sizeof(output));
-        send(session->socket_fd, output, strlen(output), 0);
-    } else {
+    send_to_client(session->socket_fd, "SERVER_STATS_END\n");
+}
+
+// ==================== DISPATCH ====================
+
+void protocol_execute(ClientSession *session, const ProtocolCommand *cmd, char *line, PGconn *db) {
+    ProtocolArgs args;
+    protocol_tokenize(line, &args);
+
+    LOG_DEBUG("[Protocol] Command: '%s' | Params: %d\n", args.argv[0], args.argc);
+
+    if (cmd == NULL || args.argc < cmd->min_args) {
         char error[128];
-        sprintf(error, "ERROR|Unknown command: %s\n", command);
-        send(session->socket_fd, error, strlen(error), 0);
-        printf("[Protocol] Unknown command: %s\n", command);
+        snprintf(error, sizeof(error), "ERROR|Unknown command: %.64s\n", args.argv[0]);
+        send_to_client(session->socket_fd, error);
+        LOG_WARN("[Protocol] Unknown command: %s\n", args.argv[0]);
+        return;
     }
+
+    // Drop DB time left over from work done outside a command on this thread
+    server_stats_take_db_time();
+    uint64_t start = server_stats_now_ns();
+    cmd->handler(session, &args, db);
+    uint64_t elapsed = server_stats_now_ns() - start;
+    server_stats_record_command((int)(cmd - command_table), elapsed, server_stats_take_db_time());
+}
+
+void protocol_handle_command(ClientSession *session, char *line, PGconn *db) {
+    protocol_execute(session, protocol_find_command(line), line, db);
 }
@@ -0,0 +1,46 @@
+#include "event_loop.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+const EventLoopOps* event_loop_backend(void) {
+    const char *name = getenv("REACTOR_BACKEND");
+    if (name == NULL || name[0] == '\0' || strcmp(name, "epoll") == 0) {
+        return &epoll_loop_ops;
+    }
+    if (strcmp(name, "poll") == 0) {
+        return &poll_loop_ops;
+    }
+    if (strcmp(name, "io_uring") == 0 || strcmp(name, "uring") == 0) {
+        return &uring_loop_ops;
+    }
+    LOG_WARN("[Server] Unknown REACTOR_BACKEND '%s', using epoll\n", name);
+    return &epoll_loop_ops;
+}
+
+int event_loop_init(EventLoop *loop, const EventLoopOps *ops, int max_fds) {
+    loop->ops = ops;
+    loop->impl = NULL;
+    if (ops->create(loop, max_fds) == 0) {
+        return 0;
+    }
+
+    if (ops != &epoll_loop_ops) {
+        perror("[Error] Event loop backend unavailable");
+        LOG_INFO("[Server] %s backend unavailable, falling back to epoll\n", ops->name);
+        loop->ops = &epoll_loop_ops;
+        if (epoll_loop_ops.create(loop, max_fds) == 0) {
+            return 0;
+        }
+    }
+    perror("[Error] Failed to create event loop");
+    return -1;
+}
+
+void event_loop_destroy(EventLoop *loop) {
+    if (loop->ops != NULL && loop->impl != NULL) {
+        loop->ops->destroy(loop);
+    }
+    loop->impl = NULL;
+}
@@ -0,0 +1,86 @@
+#include "event_loop.h"
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+
+#define EPOLL_BATCH 256
+
+typedef struct {
+    int epoll_fd;
+    struct epoll_event ready[EPOLL_BATCH];
+} EpollLoop;
+
+static uint32_t epoll_mask(unsigned events) {
+    uint32_t mask = 0;
+    if (events & LOOP_READ) mask |= EPOLLIN;
+    if (events & LOOP_WRITE) mask |= EPOLLOUT;
+    return mask;
+}
+
+static int epoll_loop_create(EventLoop *loop, int max_fds) {
+    (void)max_fds;
+    EpollLoop *impl = (EpollLoop*)malloc(sizeof(EpollLoop));
+    if (impl == NULL) return -1;
+
+    impl->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (impl->epoll_fd < 0) {
+        free(impl);
+        return -1;
+    }
+    loop->impl = impl;
+    return 0;
+}
+
+static void epoll_loop_destroy(EventLoop *loop) {
+    EpollLoop *impl = (EpollLoop*)loop->impl;
+    close(impl->epoll_fd);
+    free(impl);
+}
+
+static int epoll_loop_ctl(EventLoop *loop, int op, int fd, unsigned events) {
+    EpollLoop *impl = (EpollLoop*)loop->impl;
+    struct epoll_event ev;
+    ev.events = epoll_mask(events);
+    ev.data.fd = fd;
+    return epoll_ctl(impl->epoll_fd, op, fd, &ev);
+}
+
+static int epoll_loop_add(EventLoop *loop, int fd, unsigned events) {
+    return epoll_loop_ctl(loop, EPOLL_CTL_ADD, fd, events);
+}
+
+static int epoll_loop_modify(EventLoop *loop, int fd, unsigned events) {
+    return epoll_loop_ctl(loop, EPOLL_CTL_MOD, fd, events);
+}
+
+static int epoll_loop_remove(EventLoop *loop, int fd) {
+    EpollLoop *impl = (EpollLoop*)loop->impl;
+    return epoll_ctl(impl->epoll_fd, EPOLL_CTL_DEL, fd, NULL);
+}
+
+static int epoll_loop_wait(EventLoop *loop, LoopEvent *events, int max_events, int timeout_ms) {
+    EpollLoop *impl = (EpollLoop*)loop->impl;
+    if (max_events > EPOLL_BATCH) max_events = EPOLL_BATCH;
+
+    int ready = epoll_wait(impl->epoll_fd, impl->ready, max_events, timeout_ms);
+    for (int i = 0; i < ready; i++) {
+        uint32_t mask = impl->ready[i].events;
+        events[i].fd = impl->ready[i].data.fd;
+        events[i].events = 0;
+        if (mask & EPOLLIN) events[i].events |= LOOP_READ;
+        if (mask & EPOLLOUT) events[i].events |= LOOP_WRITE;
+        if (mask & (EPOLLHUP | EPOLLERR)) events[i].events |= LOOP_HUP;
+    }
+    return ready;
+}
+
+const EventLoopOps epoll_loop_ops = {
+    "epoll",
+    epoll_loop_create,
+    epoll_loop_destroy,
+    epoll_loop_add,
+    epoll_loop_modify,
+    epoll_loop_remove,
+    epoll_loop_wait,
+    NULL,
+};
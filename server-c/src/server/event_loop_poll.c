@@ -0,0 +1,122 @@
+#include "event_loop.h"
+#include <stdlib.h>
+#include <errno.h>
+#include <poll.h>
+
+// Portable fallback: one pollfd per descriptor, compacted on removal
+typedef struct {
+    struct pollfd *fds;
+    int *slot_of;       // fd -> index in fds, -1 when not watched
+    int count;
+    int max_fds;
+} PollLoop;
+
+static short poll_mask(unsigned events) {
+    short mask = 0;
+    if (events & LOOP_READ) mask |= POLLIN;
+    if (events & LOOP_WRITE) mask |= POLLOUT;
+    return mask;
+}
+
+static int poll_loop_create(EventLoop *loop, int max_fds) {
+    PollLoop *impl = (PollLoop*)calloc(1, sizeof(PollLoop));
+    if (impl == NULL) return -1;
+
+    impl->fds = (struct pollfd*)calloc((size_t)max_fds, sizeof(struct pollfd));
+    impl->slot_of = (int*)malloc((size_t)max_fds * sizeof(int));
+    if (impl->fds == NULL || impl->slot_of == NULL) {
+        free(impl->fds);
+        free(impl->slot_of);
+        free(impl);
+        return -1;
+    }
+    for (int fd = 0; fd < max_fds; fd++) {
+        impl->slot_of[fd] = -1;
+    }
+    impl->max_fds = max_fds;
+    loop->impl = impl;
+    return 0;
+}
+
+static void poll_loop_destroy(EventLoop *loop) {
+    PollLoop *impl = (PollLoop*)loop->impl;
+    free(impl->fds);
+    free(impl->slot_of);
+    free(impl);
+}
+
+static int poll_loop_add(EventLoop *loop, int fd, unsigned events) {
+    PollLoop *impl = (PollLoop*)loop->impl;
+    if (fd < 0 || fd >= impl->max_fds) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (impl->slot_of[fd] >= 0) {
+        errno = EEXIST;
+        return -1;
+    }
+    int slot = impl->count++;
+    impl->fds[slot].fd = fd;
+    impl->fds[slot].events = poll_mask(events);
+    impl->fds[slot].revents = 0;
+    impl->slot_of[fd] = slot;
+    return 0;
+}
+
+static int poll_loop_modify(EventLoop *loop, int fd, unsigned events) {
+    PollLoop *impl = (PollLoop*)loop->impl;
+    if (fd < 0 || fd >= impl->max_fds || impl->slot_of[fd] < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    impl->fds[impl->slot_of[fd]].events = poll_mask(events);
+    return 0;
+}
+
+static int poll_loop_remove(EventLoop *loop, int fd) {
+    PollLoop *impl = (PollLoop*)loop->impl;
+    if (fd < 0 || fd >= impl->max_fds || impl->slot_of[fd] < 0) {
+        errno = ENOENT;
+        return -1;
+    }
+    // Move the last entry into the freed slot
+    int slot = impl->slot_of[fd];
+    int last = --impl->count;
+    if (slot != last) {
+        impl->fds[slot] = impl->fds[last];
+        impl->slot_of[impl->fds[slot].fd] = slot;
+    }
+    impl->slot_of[fd] = -1;
+    return 0;
+}
+
+static int poll_loop_wait(EventLoop *loop, LoopEvent *events, int max_events, int timeout_ms) {
+    PollLoop *impl = (PollLoop*)loop->impl;
+    int ready = poll(impl->fds, (nfds_t)impl->count, timeout_ms);
+    if (ready <= 0) return ready;
+
+    int n = 0;
+    for (int i = 0; i < impl->count && n < max_events; i++) {
+        short revents = impl->fds[i].revents;
+        if (revents == 0) continue;
+
+        events[n].fd = impl->fds[i].fd;
+        events[n].events = 0;
+        if (revents & POLLIN) events[n].events |= LOOP_READ;
+        if (revents & POLLOUT) events[n].events |= LOOP_WRITE;
+        if (revents & (POLLHUP | POLLERR | POLLNVAL)) events[n].events |= LOOP_HUP;
+        n++;
+    }
+    return n;
+}
+
+const EventLoopOps poll_loop_ops = {
+    "poll",
+    poll_loop_create,
+    poll_loop_destroy,
+    poll_loop_add,
+    poll_loop_modify,
+    poll_loop_remove,
+    poll_loop_wait,
+    NULL,
+};
@@ -0,0 +1,409 @@
+#include "event_loop.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <signal.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+// io_uring readiness backend, driven through the raw syscalls (no liburing).
+// Every watched descriptor carries one multishot IORING_OP_POLL_ADD, so a
+// poll stays armed across completions, and interest changes are queued as
+// SQEs that go out with the next wait: one io_uring_enter() per loop
+// iteration submits and reaps everything.
+//
+// Listeners get a multishot IORING_OP_ACCEPT instead: the kernel accepts
+// every connection itself and posts the new descriptor as a completion, so
+// a burst of connections costs no accept() calls and no wakeup per client.
+// Client reads and writes stay readiness-driven; they go through the
+// session's buffers, which own the data on every backend.
+
+#define URING_ENTRIES 256
+#define URING_CANCEL_TAG UINT64_MAX
+
+// watched[] values
+#define URING_WATCH_POLL    1
+#define URING_WATCH_ACCEPT  2
+
+typedef struct {
+    int ring_fd;
+
+    void *sq_ring;
+    size_t sq_ring_size;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned sq_entries;
+    struct io_uring_sqe *sqes;
+    size_t sqes_size;
+    unsigned sq_queued;         // SQEs written but not yet submitted
+
+    void *cq_ring;
+    size_t cq_ring_size;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+
+    // Per-fd interest. The generation is part of each poll's user_data so
+    // completions from a poll that was replaced or removed are ignored.
+    unsigned *mask;
+    uint32_t *generation;
+    unsigned char *watched;     // 0, URING_WATCH_POLL or URING_WATCH_ACCEPT
+    int max_fds;
+} UringLoop;
+
+static int uring_setup(unsigned entries, struct io_uring_params *params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete,
+                       unsigned flags, void *arg, size_t arg_size) {
+    return (int)syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete,
+                        flags, arg, arg_size);
+}
+
+static void uring_unmap(UringLoop *impl) {
+    if (impl->sqes != NULL && impl->sqes != MAP_FAILED) {
+        munmap(impl->sqes, impl->sqes_size);
+    }
+    if (impl->cq_ring != NULL && impl->cq_ring != MAP_FAILED && impl->cq_ring != impl->sq_ring) {
+        munmap(impl->cq_ring, impl->cq_ring_size);
+    }
+    if (impl->sq_ring != NULL && impl->sq_ring != MAP_FAILED) {
+        munmap(impl->sq_ring, impl->sq_ring_size);
+    }
+}
+
+static void uring_free(UringLoop *impl) {
+    uring_unmap(impl);
+    if (impl->ring_fd >= 0) close(impl->ring_fd);
+    free(impl->mask);
+    free(impl->generation);
+    free(impl->watched);
+    free(impl);
+}
+
+static int uring_loop_create(EventLoop *loop, int max_fds) {
+    UringLoop *impl = (UringLoop*)calloc(1, sizeof(UringLoop));
+    if (impl == NULL) return -1;
+    impl->ring_fd = -1;
+
+    impl->mask = (unsigned*)calloc((size_t)max_fds, sizeof(unsigned));
+    impl->generation = (uint32_t*)calloc((size_t)max_fds, sizeof(uint32_t));
+    impl->watched = (unsigned char*)calloc((size_t)max_fds, 1);
+    impl->max_fds = max_fds;
+    if (impl->mask == NULL || impl->generation == NULL || impl->watched == NULL) {
+        uring_free(impl);
+        return -1;
+    }
+
+    struct io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    impl->ring_fd = uring_setup(URING_ENTRIES, &params);
+    if (impl->ring_fd < 0) {
+        uring_free(impl);
+        return -1;
+    }
+    // Needed for the wait timeout
+    if (!(params.features & IORING_FEAT_EXT_ARG)) {
+        uring_free(impl);
+        errno = ENOSYS;
+        return -1;
+    }
+
+    impl->sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    impl->cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (impl->cq_ring_size > impl->sq_ring_size) {
+            impl->sq_ring_size = impl->cq_ring_size;
+        }
+        impl->cq_ring_size = impl->sq_ring_size;
+    }
+
+    impl->sq_ring = mmap(NULL, impl->sq_ring_size, PROT_READ | PROT_WRITE,
+                         MAP_SHARED | MAP_POPULATE, impl->ring_fd, IORING_OFF_SQ_RING);
+    if (impl->sq_ring == MAP_FAILED) {
+        uring_free(impl);
+        return -1;
+    }
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        impl->cq_ring = impl->sq_ring;
+    } else {
+        impl->cq_ring = mmap(NULL, impl->cq_ring_size, PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE, impl->ring_fd, IORING_OFF_CQ_RING);
+        if (impl->cq_ring == MAP_FAILED) {
+            uring_free(impl);
+            return -1;
+        }
+    }
+    impl->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    impl->sqes = (struct io_uring_sqe*)mmap(NULL, impl->sqes_size, PROT_READ | PROT_WRITE,
+                                            MAP_SHARED | MAP_POPULATE, impl->ring_fd, IORING_OFF_SQES);
+    if (impl->sqes == MAP_FAILED) {
+        uring_free(impl);
+        return -1;
+    }
+
+    char *sq = (char*)impl->sq_ring;
+    impl->sq_head = (unsigned*)(sq + params.sq_off.head);
+    impl->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    impl->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    impl->sq_array = (unsigned*)(sq + params.sq_off.array);
+    impl->sq_entries = params.sq_entries;
+
+    char *cq = (char*)impl->cq_ring;
+    impl->cq_head = (unsigned*)(cq + params.cq_off.head);
+    impl->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    impl->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    impl->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+
+    loop->impl = impl;
+    return 0;
+}
+
+static void uring_loop_destroy(EventLoop *loop) {
+    uring_free((UringLoop*)loop->impl);
+}
+
+static int uring_submit(UringLoop *impl) {
+    while (impl->sq_queued > 0) {
+        int submitted = uring_enter(impl->ring_fd, impl->sq_queued, 0, 0, NULL, 0);
+        if (submitted < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        impl->sq_queued -= (unsigned)submitted;
+    }
+    return 0;
+}
+
+// Next free SQE; flushes the queue to the kernel when the ring is full
+static struct io_uring_sqe* uring_get_sqe(UringLoop *impl) {
+    unsigned tail = *impl->sq_tail;
+    unsigned head = __atomic_load_n(impl->sq_head, __ATOMIC_ACQUIRE);
+    if (tail - head >= impl->sq_entries) {
+        if (uring_submit(impl) < 0) return NULL;
+        head = __atomic_load_n(impl->sq_head, __ATOMIC_ACQUIRE);
+        if (tail - head >= impl->sq_entries) {
+            errno = EBUSY;
+            return NULL;
+        }
+    }
+
+    unsigned index = tail & *impl->sq_mask;
+    struct io_uring_sqe *sqe = &impl->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    impl->sq_array[index] = index;
+    __atomic_store_n(impl->sq_tail, tail + 1, __ATOMIC_RELEASE);
+    impl->sq_queued++;
+    return sqe;
+}
+
+static uint64_t uring_poll_tag(UringLoop *impl, int fd) {
+    return ((uint64_t)impl->generation[fd] << 32) | (uint32_t)fd;
+}
+
+static int uring_arm(UringLoop *impl, int fd) {
+    struct io_uring_sqe *sqe = uring_get_sqe(impl);
+    if (sqe == NULL) return -1;
+
+    impl->generation[fd]++;
+    if (impl->watched[fd] == URING_WATCH_ACCEPT) {
+        // Same flags as a plain accept(); no peer address per completion
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = fd;
+        sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        sqe->user_data = uring_poll_tag(impl, fd);
+        return 0;
+    }
+
+    unsigned events = impl->mask[fd];
+    uint32_t poll_events = 0;
+    if (events & LOOP_READ) poll_events |= POLLIN;
+    if (events & LOOP_WRITE) poll_events |= POLLOUT;
+
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = fd;
+    sqe->poll32_events = poll_events;   // POLLHUP/POLLERR are always reported
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = uring_poll_tag(impl, fd);
+    return 0;
+}
+
+static int uring_cancel(UringLoop *impl, int fd, unsigned char kind) {
+    struct io_uring_sqe *sqe = uring_get_sqe(impl);
+    if (sqe == NULL) return -1;
+
+    // POLL_REMOVE only finds polls; the accept needs the generic cancel
+    sqe->opcode = (kind == URING_WATCH_ACCEPT) ? IORING_OP_ASYNC_CANCEL : IORING_OP_POLL_REMOVE;
+    sqe->fd = -1;
+    sqe->addr = uring_poll_tag(impl, fd);
+    sqe->user_data = URING_CANCEL_TAG;
+    return 0;
+}
+
+static int uring_loop_add(EventLoop *loop, int fd, unsigned events) {
+    UringLoop *impl = (UringLoop*)loop->impl;
+    if (fd < 0 || fd >= impl->max_fds) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (impl->watched[fd]) {
+        errno = EEXIST;
+        return -1;
+    }
+    impl->mask[fd] = events;
+    impl->watched[fd] = URING_WATCH_POLL;
+    if (uring_arm(impl, fd) < 0) {
+        impl->watched[fd] = 0;
+        return -1;
+    }
+    return 0;
+}
+
+static int uring_loop_add_listener(EventLoop *loop, int fd) {
+    UringLoop *impl = (UringLoop*)loop->impl;
+    if (fd < 0 || fd >= impl->max_fds) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (impl->watched[fd]) {
+        errno = EEXIST;
+        return -1;
+    }
+    impl->mask[fd] = LOOP_READ;
+    impl->watched[fd] = URING_WATCH_ACCEPT;
+    if (uring_arm(impl, fd) < 0) {
+        impl->watched[fd] = 0;
+        return -1;
+    }
+    return 0;
+}
+
+static int uring_loop_modify(EventLoop *loop, int fd, unsigned events) {
+    UringLoop *impl = (UringLoop*)loop->impl;
+    if (fd < 0 || fd >= impl->max_fds || !impl->watched[fd]) {
+        errno = ENOENT;
+        return -1;
+    }
+    if (impl->watched[fd] == URING_WATCH_ACCEPT) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (impl->mask[fd] == events) return 0;
+
+    // Replace the poll; the new one reports current readiness right away
+    impl->mask[fd] = events;
+    if (uring_cancel(impl, fd, URING_WATCH_POLL) < 0) return -1;
+    return uring_arm(impl, fd);
+}
+
+static int uring_loop_remove(EventLoop *loop, int fd) {
+    UringLoop *impl = (UringLoop*)loop->impl;
+    if (fd < 0 || fd >= impl->max_fds || !impl->watched[fd]) {
+        errno = ENOENT;
+        return -1;
+    }
+    unsigned char kind = impl->watched[fd];
+    impl->watched[fd] = 0;
+    impl->mask[fd] = 0;
+    int result = uring_cancel(impl, fd, kind);
+    impl->generation[fd]++;
+    // Submit now: the pending poll holds a reference to the socket, which
+    // would otherwise keep it open after the caller closes the descriptor
+    if (uring_submit(impl) < 0) return -1;
+    return result;
+}
+
+static int uring_loop_wait(EventLoop *loop, LoopEvent *events, int max_events, int timeout_ms) {
+    UringLoop *impl = (UringLoop*)loop->impl;
+
+    unsigned head = *impl->cq_head;
+    unsigned tail = __atomic_load_n(impl->cq_tail, __ATOMIC_ACQUIRE);
+    if (head == tail || impl->sq_queued > 0) {
+        struct __kernel_timespec ts;
+        ts.tv_sec = timeout_ms / 1000;
+        ts.tv_nsec = (long long)(timeout_ms % 1000) * 1000000;
+
+        struct io_uring_getevents_arg arg;
+        memset(&arg, 0, sizeof(arg));
+        arg.sigmask_sz = _NSIG / 8;
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+
+        unsigned min_complete = (head == tail) ? 1 : 0;
+        int submitted = uring_enter(impl->ring_fd, impl->sq_queued, min_complete,
+                                    IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                                    &arg, sizeof(arg));
+        if (submitted >= 0) {
+            impl->sq_queued -= (unsigned)submitted;
+        } else if (errno != ETIME) {
+            return -1;
+        }
+        tail = __atomic_load_n(impl->cq_tail, __ATOMIC_ACQUIRE);
+    }
+
+    int n = 0;
+    while (head != tail && n < max_events) {
+        struct io_uring_cqe *cqe = &impl->cqes[head & *impl->cq_mask];
+        uint64_t tag = cqe->user_data;
+        int res = cqe->res;
+        unsigned flags = cqe->flags;
+        head++;
+
+        if (tag == URING_CANCEL_TAG) continue;
+
+        int fd = (int)(uint32_t)tag;
+        if (fd < 0 || fd >= impl->max_fds || !impl->watched[fd] || tag != uring_poll_tag(impl, fd)) {
+            continue;   // Completion from a poll that has since been replaced or removed
+        }
+
+        // The kernel ended the multishot request (error or overflow): re-arm it
+        if (!(flags & IORING_CQE_F_MORE)) {
+            uring_arm(impl, fd);
+        }
+        if (impl->watched[fd] == URING_WATCH_ACCEPT) {
+            // res is the accepted descriptor; a failed accept (EMFILE, a
+            // connection reset before it was taken) drops only that client
+            if (res >= 0) {
+                events[n].fd = res;
+                events[n].events = LOOP_ACCEPT;
+                n++;
+            }
+            continue;
+        }
+        if (res < 0) {
+            if (res != -ECANCELED) {
+                events[n].fd = fd;
+                events[n].events = LOOP_HUP;
+                n++;
+            }
+            continue;
+        }
+
+        events[n].fd = fd;
+        events[n].events = 0;
+        if (res & POLLIN) events[n].events |= LOOP_READ;
+        if (res & POLLOUT) events[n].events |= LOOP_WRITE;
+        if (res & (POLLHUP | POLLERR | POLLNVAL)) events[n].events |= LOOP_HUP;
+        n++;
+    }
+    __atomic_store_n(impl->cq_head, head, __ATOMIC_RELEASE);
+    return n;
+}
+
+const EventLoopOps uring_loop_ops = {
+    "io_uring",
+    uring_loop_create,
+    uring_loop_destroy,
+    uring_loop_add,
+    uring_loop_modify,
+    uring_loop_remove,
+    uring_loop_wait,
+    uring_loop_add_listener,
+};
@@ -4,6 +4,12 @@
 #include "game.h"
 #include "history.h"
 #include "online_users.h"
+#include "database.h"
+#include "worker_pool.h"
+#include "bot.h"
+#include "event_loop.h"
+#include "log.h"
+#include "server_stats.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -11,9 +17,16 @@
 #include <pthread.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <netinet/tcp.h>
 #include <arpa/inet.h>
-#include <poll.h>
-#define MAX_CLIENTS 1024
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/resource.h>
+#include <sys/eventfd.h>
+#include <stdint.h>
+#include <signal.h>
+
+#define MAX_EVENTS 256
 
 // External global variables
 extern GameManager game_manager;
@@ -26,11 +39,11 @@ void* client_handler(void *arg) {
     int client_fd = session->socket_fd;
     char buffer[BUFFER_SIZE];
     
-    printf("[Server] Client %d connected\n", client_fd);
+    LOG_INFO("[Server] Client %d connected\n", client_fd);
     
     // Send welcome message
     const char *welcome = "WELCOME|Chess Server v1.0\n";
-    send(client_fd, welcome, strlen(welcome), 0);
+    send_to_client(client_fd, welcome);
     
     while (1) {
         memset(buffer, 0, BUFFER_SIZE);
@@ -38,14 +51,14 @@ void* client_handler(void *arg) {
         
         if (bytes_read <= 0) {
             // Client disconnected
-            client_session_handle_disconnect(session);
+            client_session_handle_disconnect(session, db_conn);
             break;
         }
         
         // Remove newline
         buffer[strcspn(buffer, "\n")] = 0;
         
-        printf("[Server] Received from client %d: %s\n", client_fd, buffer);
+        LOG_DEBUG("[Server] Received from client %d: %s\n", client_fd, buffer);
         
         // Handle command
         protocol_handle_command(session, buffer, db_conn);
@@ -58,132 +71,695 @@ void* client_handler(void *arg) {
 
 // Server initialization
 int server_init(PGconn **db_connection) {
-    printf("========================================\n");
-    printf("     Chess Game Server Starting...     \n");
-    printf("========================================\n\n");
+    LOG_INFO("========================================\n");
+    LOG_INFO("     Chess Game Server Starting...     \n");
+    LOG_INFO("========================================\n\n");
     
     // Connect to database
     *db_connection = db_connect();
     if (*db_connection == NULL) {
-        fprintf(stderr, "[Error] Failed to connect to database\n");
+        LOG_ERROR("[Error] Failed to connect to database\n");
         return -1;
     }
     
+    server_stats_init();
+
+    bitboard_init();
+    LOG_INFO("[Server] Slider attack tables ready (%s)\n", bitboard_slider_backend());
+
     // Initialize game manager
     game_manager_init(&game_manager);
-    printf("[Server] Game manager initialized\n");
+    LOG_INFO("[Server] Game manager initialized\n");
+
+    if (protocol_init() < 0) {
+        return -1;
+    }
 
     pthread_mutex_init(&online_users.lock, NULL);
     online_users.count = 0;
+
+    // Allow as many descriptors as the session table can hold
+    struct rlimit rl;
+    if (getrlimit(RLIMIT_NOFILE, &rl) == 0 && rl.rlim_cur < MAX_CLIENTS) {
+        rl.rlim_cur = (rl.rlim_max < MAX_CLIENTS) ? rl.rlim_max : MAX_CLIENTS;
+        setrlimit(RLIMIT_NOFILE, &rl);
+    }
     
     return 0;
 }
 
-// Start server and accept connections using poll for I/O multiplexing
-void server_start() {
+// One reactor per thread. Each shard has its own SO_REUSEPORT listener,
+// event loop, fd-indexed session table and database connection.
+typedef struct ReactorShard {
+    int id;
+    pthread_t thread;
+    int listen_fd;
+    EventLoop loop;
+    int wake_fd;                    // eventfd: sessions handed off to this shard
+    PGconn *db;
+    ClientSession *sessions[MAX_CLIENTS];
+
+    pthread_mutex_t handoff_lock;
+    ClientSession *handoff_head;    // Sessions waiting to be adopted by this shard
+    struct DbJob *completed_head;   // DB jobs finished by workers, guarded by handoff_lock
+    // Sessions whose output queue just became non-empty, guarded by handoff_lock
+    int rearm_fds[MAX_CLIENTS];
+    unsigned char rearm_queued[MAX_CLIENTS];
+    int rearm_count;
+} ReactorShard;
+
+// A command line queued on the DB worker pool. The worker posts it back to
+// the shard that owns the session once the handler has run.
+typedef struct DbJob {
+    ReactorShard *shard;
+    ClientSession *session;
+    const ProtocolCommand *command;
+    struct DbJob *next;
+    char line[];
+} DbJob;
+
+static WorkerPool db_pool;
+
+static ReactorShard *shards[MAX_REACTOR_THREADS];
+static int shard_count = 0;
+static volatile sig_atomic_t stop_requested = 0;
+static __thread ReactorShard *current_shard = NULL;
+
+// Owning shard of every connected fd (-1 when unused), readable from any thread
+static int fd_owner[MAX_CLIENTS];
+
+// Put a socket into non-blocking mode (sockets are drained until EAGAIN)
+static int set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0) return -1;
+    return fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+}
+
+// Interest a session needs right now: input unless it is paused, output
+// only while replies are queued
+static unsigned shard_interest_for(ClientSession *session) {
+    unsigned events = 0;
+    int paused = (session->job_pending && client_session_input_full(session)) ||
+                 client_session_output_backlogged(session);
+    if (!paused) events |= LOOP_READ;
+    if (client_session_output_pending(session) > 0) events |= LOOP_WRITE;
+    return events;
+}
+
+static int shard_watch_client(ReactorShard *shard, ClientSession *session) {
+    session->watch_events = shard_interest_for(session);
+    return event_loop_add(&shard->loop, session->socket_fd, session->watch_events);
+}
+
+static void shard_update_interest(ReactorShard *shard, ClientSession *session) {
+    if (session->closing) return;
+    unsigned events = shard_interest_for(session);
+    if (events != session->watch_events) {
+        session->watch_events = events;
+        event_loop_modify(&shard->loop, session->socket_fd, events);
+    }
+}
+
+// Close a client and release its slot in the fd-indexed session table (O(1))
+static void shard_close_client(ReactorShard *shard, int client_fd) {
+    ClientSession *session = shard->sessions[client_fd];
+    if (session != NULL && session->job_pending) {
+        // A worker still holds the session: finish closing when its job comes back
+        session->closing = 1;
+        event_loop_remove(&shard->loop, client_fd);
+        return;
+    }
+    // A deferred close already dropped the fd from the loop
+    int was_closing = (session != NULL && session->closing);
+    if (session != NULL) {
+        client_session_handle_disconnect(session, shard->db);
+        client_session_destroy(session);
+        shard->sessions[client_fd] = NULL;
+        server_stats_session_closed();
+    }
+    __atomic_store_n(&fd_owner[client_fd], -1, __ATOMIC_RELEASE);
+    if (!was_closing) {
+        event_loop_remove(&shard->loop, client_fd);
+    }
+    close(client_fd);
+}
+
+// Give a freshly accepted connection a session on this shard and greet it.
+// client_addr may be NULL (io_uring accepts report no peer address).
+static void shard_register_client(ReactorShard *shard, int client_fd,
+                                  const struct sockaddr_in *client_addr) {
+    if (client_fd >= MAX_CLIENTS) {
+        LOG_WARN("[Server] Rejecting fd %d: session table full\n", client_fd);
+        close(client_fd);
+        return;
+    }
+
+    // Replies are small separate writes; without this Nagle holds the
+    // second one back until the peer's delayed ACK (~40 ms)
+    int nodelay = 1;
+    setsockopt(client_fd, IPPROTO_TCP, TCP_NODELAY, &nodelay, sizeof(nodelay));
+
+    ClientSession *session = client_session_create(client_fd);
+    if (session == NULL) {
+        close(client_fd);
+        return;
+    }
+    session->shard_id = shard->id;
+
+    if (shard_watch_client(shard, session) < 0) {
+        perror("[Error] Failed to watch client");
+        client_session_destroy(session);
+        close(client_fd);
+        return;
+    }
+    shard->sessions[client_fd] = session;
+    __atomic_store_n(&fd_owner[client_fd], shard->id, __ATOMIC_RELEASE);
+    server_stats_session_opened();
+
+    if (LOG_ENABLED(LOG_LEVEL_INFO)) {
+        struct sockaddr_in peer;
+        socklen_t peer_len = sizeof(peer);
+        if (client_addr == NULL &&
+            getpeername(client_fd, (struct sockaddr*)&peer, &peer_len) == 0) {
+            client_addr = &peer;
+        }
+        LOG_INFO("[Server] New connection from %s:%d (fd: %d, shard: %d)\n",
+               client_addr ? inet_ntoa(client_addr->sin_addr) : "?",
+               client_addr ? ntohs(client_addr->sin_port) : 0,
+               client_fd, shard->id);
+    }
+
+    // Send welcome message
+    const char *welcome = "WELCOME|Chess Server v1.0\n";
+    send_to_client(client_fd, welcome);
+}
+
+// Accept every pending connection (edge-triggered: drain until EAGAIN)
+static void shard_accept_clients(ReactorShard *shard) {
+    while (1) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        int client_fd = accept(shard->listen_fd, (struct sockaddr*)&client_addr, &client_len);
+        if (client_fd < 0) {
+            if (errno == EINTR) continue;
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                perror("[Error] accept failed");
+            }
+            return;
+        }
+        shard_register_client(shard, client_fd, &client_addr);
+    }
+}
+
+static void shard_wake(ReactorShard *shard) {
+    uint64_t one = 1;
+    if (write(shard->wake_fd, &one, sizeof(one)) < 0) {
+        perror("[Error] Failed to wake shard");
+    }
+}
+
+// Shard that should own this session: the one holding its opponent. Returns
+// the current shard when the match is already co-located (or has no opponent).
+static int shard_home_for(ReactorShard *shard, ClientSession *session) {
+    if (shard_count < 2) return shard->id;
+    GameMatch *match = client_session_acquire_match(session);
+    if (match == NULL) return shard->id;
+
+    pthread_mutex_lock(&match->lock);
+    int opponent_fd = (match->white_player.socket_fd == session->socket_fd)
+                      ? match->black_player.socket_fd
+                      : match->white_player.socket_fd;
+    pthread_mutex_unlock(&match->lock);
+    game_match_release(match);
+
+    if (opponent_fd <= 0 || opponent_fd >= MAX_CLIENTS || opponent_fd == session->socket_fd) {
+        return shard->id;
+    }
+    int owner = __atomic_load_n(&fd_owner[opponent_fd], __ATOMIC_ACQUIRE);
+    return (owner >= 0) ? owner : shard->id;
+}
+
+// Move a session to another shard so both players of a match are served by
+// the same reactor. Its remaining buffered input is processed by the target.
+static void shard_handoff(ReactorShard *shard, ClientSession *session, int target_id) {
+    ReactorShard *target = shards[target_id];
+    int client_fd = session->socket_fd;
+
+    event_loop_remove(&shard->loop, client_fd);
+    shard->sessions[client_fd] = NULL;
+    session->shard_id = target_id;
+    __atomic_store_n(&fd_owner[client_fd], target_id, __ATOMIC_RELEASE);
+
+    pthread_mutex_lock(&target->handoff_lock);
+    session->handoff_next = target->handoff_head;
+    target->handoff_head = session;
+    pthread_mutex_unlock(&target->handoff_lock);
+    shard_wake(target);
+
+    LOG_INFO("[Server] Client %d handed off from shard %d to shard %d\n",
+           client_fd, shard->id, target_id);
+}
+
+// Worker side of a DB job: run the handler on the worker's own connection
+static void db_job_run(void *arg, void *thread_ctx) {
+    DbJob *job = (DbJob*)arg;
+    ReactorShard *shard = job->shard;
+
+    protocol_execute(job->session, job->command, job->line, (PGconn*)thread_ctx);
+
+    pthread_mutex_lock(&shard->handoff_lock);
+    job->next = shard->completed_head;
+    shard->completed_head = job;
+    pthread_mutex_unlock(&shard->handoff_lock);
+    shard_wake(shard);
+}
+
+static void* db_worker_init(int worker_index) {
+    (void)worker_index;
+    return db_connect();
+}
+
+static void db_worker_exit(void *thread_ctx) {
+    db_disconnect((PGconn*)thread_ctx);
+}
+
+// Queue a DB-bound command. The session dispatches nothing else until the
+// job comes back, which keeps replies in request order.
+static void shard_submit_db_job(ReactorShard *shard, ClientSession *session,
+                                const ProtocolCommand *command, const char *line) {
+    size_t len = strlen(line);
+    DbJob *job = (DbJob*)malloc(sizeof(DbJob) + len + 1);
+    if (job != NULL) {
+        job->shard = shard;
+        job->session = session;
+        job->command = command;
+        job->next = NULL;
+        memcpy(job->line, line, len + 1);
+
+        session->job_pending = 1;
+        if (worker_pool_submit(&db_pool, db_job_run, job) == 0) {
+            return;
+        }
+        session->job_pending = 0;
+        free(job);
+    }
+    send_to_client(session->socket_fd, "ERROR|Server busy\n");
+}
+
+// After a command that may have put the session in a match: hand it to its
+// opponent's shard if the match is served elsewhere (returns 1)
+static int shard_follow_match(ReactorShard *shard, ClientSession *session) {
+    int home = shard_home_for(shard, session);
+    if (home == shard->id) return 0;
+    shard_handoff(shard, session, home);
+    return 1;
+}
+
+// Dispatch buffered lines until none is complete, a DB job is outstanding for
+// this session, or the session has to move to another shard (returns 1).
+static int shard_dispatch_input(ReactorShard *shard, ClientSession *session) {
+    char *line;
+    while (!session->job_pending && (line = client_session_next_line(session)) != NULL) {
+        LOG_DEBUG("[Server] Received from client %d: %s\n", session->socket_fd, line);
+
+        const ProtocolCommand *command = protocol_find_command(line);
+        if (command != NULL && (command->flags & PROTOCOL_DB)) {
+            shard_submit_db_job(shard, session, command, line);
+            continue;
+        }
+
+        protocol_execute(session, command, line, shard->db);
+
+        if (shard_follow_match(shard, session)) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Read everything available on a client socket (drain until EAGAIN)
+// and dispatch every complete line, so pipelined commands are all handled in
+// one wakeup. Returns 0 while the client stays connected, 1 when the session
+// was handed to another shard, -1 once it has gone away.
+static int shard_read_client(ReactorShard *shard, ClientSession *session) {
+    while (1) {
+        if (shard_dispatch_input(shard, session)) {
+            return 1;
+        }
+        // Buffer full of lines waiting behind a DB job: resume when it completes
+        if (session->job_pending && client_session_input_full(session)) {
+            return 0;
+        }
+        // Client is not reading its replies: stop reading its requests until
+        // the output queue drains (input interest is dropped meanwhile)
+        if (client_session_output_backlogged(session)) {
+            return 0;
+        }
+
+        ssize_t bytes_read = client_session_fill(session);
+        if (bytes_read < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            return 0;
+        }
+        if (bytes_read <= 0) {
+            return shard_dispatch_input(shard, session) ? 1 : -1;
+        }
+    }
+}
+
+// Resume sessions whose DB job has finished
+static void shard_complete_db_jobs(ReactorShard *shard) {
+    pthread_mutex_lock(&shard->handoff_lock);
+    DbJob *job = shard->completed_head;
+    shard->completed_head = NULL;
+    pthread_mutex_unlock(&shard->handoff_lock);
+
+    while (job != NULL) {
+        DbJob *next = job->next;
+        ClientSession *session = job->session;
+        int client_fd = session->socket_fd;
+        free(job);
+
+        session->job_pending = 0;
+        // DB commands can change the match too; follow it before reading on
+        int result;
+        if (session->closing) {
+            result = -1;
+        } else if (shard_follow_match(shard, session)) {
+            result = 1;
+        } else {
+            result = shard_read_client(shard, session);
+        }
+        if (result < 0) {
+            shard_close_client(shard, client_fd);
+        } else if (result == 0) {
+            shard_update_interest(shard, session);
+        }
+        job = next;
+    }
+}
+
+// Output was queued for a session (possibly from another thread): have its
+// owning shard start watching for writability
+static void shard_output_queued(int socket_fd) {
+    int owner = __atomic_load_n(&fd_owner[socket_fd], __ATOMIC_ACQUIRE);
+    if (owner < 0 || owner >= shard_count) return;
+    ReactorShard *shard = shards[owner];
+
+    pthread_mutex_lock(&shard->handoff_lock);
+    int queued = shard->rearm_queued[socket_fd];
+    if (!queued) {
+        shard->rearm_queued[socket_fd] = 1;
+        shard->rearm_fds[shard->rearm_count++] = socket_fd;
+    }
+    pthread_mutex_unlock(&shard->handoff_lock);
+
+    // The owning reactor drains the list itself before it next waits
+    if (!queued && shard != current_shard) {
+        shard_wake(shard);
+    }
+}
+
+static void shard_rearm_sessions(ReactorShard *shard) {
+    int fds[MAX_CLIENTS];
+
+    pthread_mutex_lock(&shard->handoff_lock);
+    int count = shard->rearm_count;
+    for (int i = 0; i < count; i++) {
+        fds[i] = shard->rearm_fds[i];
+        shard->rearm_queued[fds[i]] = 0;
+    }
+    shard->rearm_count = 0;
+    pthread_mutex_unlock(&shard->handoff_lock);
+
+    for (int i = 0; i < count; i++) {
+        // The fd may have moved shards or been reused since; re-checking
+        // the current session's interest is harmless either way
+        ClientSession *session = shard->sessions[fds[i]];
+        if (session != NULL) {
+            shard_update_interest(shard, session);
+        }
+    }
+}
+
+// Adopt sessions handed off by other shards
+static void shard_adopt_sessions(ReactorShard *shard) {
+    pthread_mutex_lock(&shard->handoff_lock);
+    ClientSession *session = shard->handoff_head;
+    shard->handoff_head = NULL;
+    pthread_mutex_unlock(&shard->handoff_lock);
+
+    while (session != NULL) {
+        ClientSession *next = session->handoff_next;
+        int client_fd = session->socket_fd;
+        session->handoff_next = NULL;
+
+        shard->sessions[client_fd] = session;
+        if (shard_watch_client(shard, session) < 0) {
+            perror("[Error] Failed to watch handed-off client");
+            shard_close_client(shard, client_fd);
+            session = next;
+            continue;
+        }
+
+        // Input left behind by the previous shard is dispatched here
+        int result = shard_read_client(shard, session);
+        if (result < 0) {
+            shard_close_client(shard, client_fd);
+        } else if (result == 0) {
+            shard_update_interest(shard, session);
+        }
+        session = next;
+    }
+}
+
+static int shard_open_listener(void) {
     int server_fd = socket(AF_INET, SOCK_STREAM, 0);
     if (server_fd < 0) {
         perror("[Error] Socket creation failed");
-        return;
+        return -1;
     }
     int opt = 1;
     setsockopt(server_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    // Every shard binds its own listener; the kernel spreads connections across them
+    setsockopt(server_fd, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
     struct sockaddr_in server_addr;
+    memset(&server_addr, 0, sizeof(server_addr));
     server_addr.sin_family = AF_INET;
     server_addr.sin_addr.s_addr = INADDR_ANY;
     server_addr.sin_port = htons(PORT);
     if (bind(server_fd, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
         perror("[Error] Bind failed");
         close(server_fd);
-        return;
+        return -1;
     }
-    if (listen(server_fd, 10) < 0) {
+    if (listen(server_fd, SOMAXCONN) < 0) {
         perror("[Error] Listen failed");
         close(server_fd);
-        return;
+        return -1;
+    }
+    if (set_nonblocking(server_fd) < 0) {
+        perror("[Error] Failed to make listening socket non-blocking");
+        close(server_fd);
+        return -1;
     }
-    printf("[Server] Listening on port %d...\n", PORT);
-    printf("[Server] Ready to accept connections!\n\n");
+    return server_fd;
+}
+
+static ReactorShard* shard_create(int id, const EventLoopOps *backend) {
+    ReactorShard *shard = (ReactorShard*)calloc(1, sizeof(ReactorShard));
+    if (shard == NULL) return NULL;
+
+    shard->id = id;
+    shard->listen_fd = -1;
+    shard->wake_fd = -1;
+    pthread_mutex_init(&shard->handoff_lock, NULL);
+
+    // libpq connections are not thread-safe: one per shard
+    shard->db = db_connect();
+    if (shard->db == NULL) goto fail;
 
-    struct pollfd fds[MAX_CLIENTS];
-    ClientSession* sessions[MAX_CLIENTS] = {0};
-    int nfds = 1;
-    fds[0].fd = server_fd;
-    fds[0].events = POLLIN;
+    shard->listen_fd = shard_open_listener();
+    if (shard->listen_fd < 0) goto fail;
+
+    shard->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (shard->wake_fd < 0) {
+        perror("[Error] Failed to create shard wakeup descriptor");
+        goto fail;
+    }
+
+    if (event_loop_init(&shard->loop, backend, MAX_CLIENTS) < 0) goto fail;
+    if (event_loop_add_listener(&shard->loop, shard->listen_fd) < 0) goto fail;
+    if (event_loop_add(&shard->loop, shard->wake_fd, LOOP_READ) < 0) goto fail;
+
+    return shard;
+
+fail:
+    LOG_ERROR("[Error] Failed to start reactor shard %d\n", id);
+    event_loop_destroy(&shard->loop);
+    if (shard->wake_fd >= 0) close(shard->wake_fd);
+    if (shard->listen_fd >= 0) close(shard->listen_fd);
+    if (shard->db != NULL) db_disconnect(shard->db);
+    pthread_mutex_destroy(&shard->handoff_lock);
+    free(shard);
+    return NULL;
+}
+
+// Reactor loop of one shard
+static void* shard_run(void *arg) {
+    ReactorShard *shard = (ReactorShard*)arg;
+    LoopEvent events[MAX_EVENTS];
+    current_shard = shard;
 
     time_t last_cleanup = time(NULL);
     time_t last_force_cleanup = time(NULL);
 
     while (1) {
-        time_t now = time(NULL);
-        if (now - last_cleanup >= 30) {
-            game_manager_cleanup_finished_matches(&game_manager);
-            last_cleanup = now;
-        }
-        if (now - last_force_cleanup >= 300) {
-            game_manager_force_cleanup_stale_matches(&game_manager);
-            last_force_cleanup = now;
-        }
-        int poll_count = poll(fds, nfds, 1000); // 1s timeout
-        if (poll_count < 0) {
-            perror("[Error] poll failed");
+        // Shard 0 runs on the thread that called server_start()
+        if (shard->id == 0 && stop_requested) {
             break;
         }
-        // New connection
-        if (fds[0].revents & POLLIN) {
-            struct sockaddr_in client_addr;
-            socklen_t client_len = sizeof(client_addr);
-            int client_fd = accept(server_fd, (struct sockaddr*)&client_addr, &client_len);
-            if (client_fd >= 0 && nfds < MAX_CLIENTS) {
-                fds[nfds].fd = client_fd;
-                fds[nfds].events = POLLIN;
-                sessions[nfds] = client_session_create(client_fd);
-                nfds++;
-                printf("[Server] New connection from %s:%d (fd: %d)\n",
-                       inet_ntoa(client_addr.sin_addr),
-                       ntohs(client_addr.sin_port),
-                       client_fd);
-                // Send welcome message
-                const char *welcome = "WELCOME|Chess Server v1.0\n";
-                send(client_fd, welcome, strlen(welcome), 0);
+        // Match housekeeping is global, so only shard 0 runs it
+        if (shard->id == 0) {
+            time_t now = time(NULL);
+            if (now - last_cleanup >= 30) {
+                game_manager_cleanup_finished_matches(&game_manager);
+                last_cleanup = now;
+            }
+            if (now - last_force_cleanup >= 300) {
+                game_manager_force_cleanup_stale_matches(&game_manager);
+                last_force_cleanup = now;
             }
         }
-        // Handle client IO
-        for (int i = 1; i < nfds; ++i) {
-            if (fds[i].revents & POLLIN) {
-                char buffer[BUFFER_SIZE] = {0};
-                int bytes_read = recv(fds[i].fd, buffer, BUFFER_SIZE - 1, 0);
-                if (bytes_read <= 0) {
-                    // Client disconnected
-                    client_session_handle_disconnect(sessions[i]);
-                    close(fds[i].fd);
-                    client_session_destroy(sessions[i]);
-                    // Remove from poll list
-                    for (int j = i; j < nfds - 1; ++j) {
-                        fds[j] = fds[j+1];
-                        sessions[j] = sessions[j+1];
-                    }
-                    nfds--;
-                    i--;
-                } else {
-                    buffer[strcspn(buffer, "\n")] = 0;
-                    printf("[Server] Received from client %d: %s\n", fds[i].fd, buffer);
-                    protocol_handle_command(sessions[i], buffer, db_conn);
+        shard_rearm_sessions(shard);
+
+        int ready = event_loop_wait(&shard->loop, events, MAX_EVENTS, 1000); // 1s timeout
+        if (ready < 0) {
+            if (errno == EINTR) continue;
+            perror("[Error] Event loop wait failed");
+            break;
+        }
+        // Only the ready descriptors are visited
+        for (int i = 0; i < ready; ++i) {
+            int fd = events[i].fd;
+
+            // Already accepted by the backend (io_uring multishot accept)
+            if (events[i].events & LOOP_ACCEPT) {
+                shard_register_client(shard, fd, NULL);
+                continue;
+            }
+            if (fd == shard->listen_fd) {
+                shard_accept_clients(shard);
+                continue;
+            }
+            if (fd == shard->wake_fd) {
+                uint64_t count;
+                if (read(shard->wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+                    perror("[Error] Failed to read shard wakeup");
                 }
+                shard_adopt_sessions(shard);
+                shard_complete_db_jobs(shard);
+                continue;
+            }
+
+            ClientSession *session = shard->sessions[fd];
+            if (session == NULL) continue;
+
+            int result = (events[i].events & LOOP_HUP) ? -1 : 0;
+            if (result == 0 && (events[i].events & LOOP_WRITE)) {
+                result = client_session_flush_output(session);
+            }
+            if (result == 0 && (events[i].events & LOOP_READ)) {
+                result = shard_read_client(shard, session);
+            }
+            if (result < 0) {
+                shard_close_client(shard, fd);
+            } else if (result == 0) {
+                shard_update_interest(shard, session);
             }
         }
     }
-    close(server_fd);
+    return NULL;
+}
+
+// Number of reactor threads: REACTOR_THREADS if set, otherwise one per core
+static int server_reactor_threads(void) {
+    const char *env = getenv("REACTOR_THREADS");
+    long n = env ? atol(env) : sysconf(_SC_NPROCESSORS_ONLN);
+    if (n < 1) n = 1;
+    if (n > MAX_REACTOR_THREADS) n = MAX_REACTOR_THREADS;
+    return (int)n;
+}
+
+// Positive integer from the environment (DB_WORKERS, ENGINE_WORKERS, *_QUEUE_SIZE, OUTPUT_*_LIMIT)
+static int server_env_int(const char *name, int fallback) {
+    const char *env = getenv(name);
+    int value = env ? atoi(env) : 0;
+    return value > 0 ? value : fallback;
+}
+
+// Start the sharded reactors and block until they exit
+void server_start() {
+    for (int fd = 0; fd < MAX_CLIENTS; fd++) {
+        fd_owner[fd] = -1;
+    }
+
+    client_session_set_output_limits(server_env_int("OUTPUT_SOFT_LIMIT", 64 * 1024),
+                                     server_env_int("OUTPUT_HARD_LIMIT", 1024 * 1024));
+    client_session_set_output_notify(shard_output_queued);
+
+    if (worker_pool_init(&db_pool, "db",
+                         server_env_int("DB_WORKERS", 4),
+                         server_env_int("DB_QUEUE_SIZE", 1024),
+                         db_worker_init, db_worker_exit) != 0) {
+        return;
+    }
+    if (bot_init(server_env_int("ENGINE_WORKERS", (int)sysconf(_SC_NPROCESSORS_ONLN)),
+                 server_env_int("ENGINE_QUEUE_SIZE", 256)) != 0) {
+        return;
+    }
+
+    const EventLoopOps *backend = event_loop_backend();
+    int wanted = server_reactor_threads();
+    shard_count = 0;
+    for (int i = 0; i < wanted; i++) {
+        ReactorShard *shard = shard_create(i, backend);
+        if (shard == NULL) break;
+        shards[shard_count++] = shard;
+    }
+    if (shard_count == 0) {
+        return;
+    }
+
+    LOG_INFO("[Server] Listening on port %d with %d reactor thread(s) (%s)...\n",
+           PORT, shard_count, shards[0]->loop.ops->name);
+    LOG_INFO("[Server] Ready to accept connections!\n\n");
+
+    for (int i = 1; i < shard_count; i++) {
+        if (pthread_create(&shards[i]->thread, NULL, shard_run, shards[i]) != 0) {
+            perror("[Error] Failed to start reactor thread");
+        }
+    }
+    // The calling thread runs shard 0
+    shards[0]->thread = pthread_self();
+    shard_run(shards[0]);
+}
+
+void server_request_stop(void) {
+    stop_requested = 1;
+}
+
+int server_stop_requested(void) {
+    return stop_requested != 0;
 }
 
 // Shutdown server
 void server_shutdown() {
-    printf("\n[Server] Shutting down...\n");
+    LOG_INFO("\n[Server] Shutting down...\n");
     
     if (db_conn != NULL) {
         db_disconnect(db_conn);
-        printf("[Server] Database connection closed\n");
+        LOG_INFO("[Server] Database connection closed\n");
     }
     
-    printf("[Server] Shutdown complete\n");
+    LOG_INFO("[Server] Shutdown complete\n");
 }
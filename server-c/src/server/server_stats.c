@@ -0,0 +1,136 @@
+#include "server_stats.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+static CommandStats command_stats[SERVER_STATS_MAX_COMMANDS];
+static __thread uint64_t thread_db_time_ns = 0;
+static int active_sessions = 0;
+static time_t started_at = 0;
+static const char *stats_token = NULL;
+
+// ==================== HISTOGRAM ====================
+
+static inline int histogram_bucket(uint64_t value) {
+    if (value < HISTOGRAM_SUB_BUCKETS) {
+        return (int)value;
+    }
+    if (value >= (1ULL << HISTOGRAM_MAX_BITS)) {
+        value = (1ULL << HISTOGRAM_MAX_BITS) - 1;
+    }
+    // Keep the top five bits: the leading one selects the power of two and
+    // the four below it the sub-bucket
+    int shift = 63 - __builtin_clzll(value) - 4;
+    return shift * (HISTOGRAM_SUB_BUCKETS / 2) + (int)(value >> shift);
+}
+
+static inline uint64_t histogram_bucket_upper(int bucket) {
+    if (bucket < HISTOGRAM_SUB_BUCKETS) {
+        return (uint64_t)bucket;
+    }
+    int shift = bucket / (HISTOGRAM_SUB_BUCKETS / 2) - 1;
+    uint64_t sub = (uint64_t)(bucket - shift * (HISTOGRAM_SUB_BUCKETS / 2));
+    return ((sub + 1) << shift) - 1;
+}
+
+void latency_histogram_record(LatencyHistogram *hist, uint64_t value_ns) {
+    __atomic_fetch_add(&hist->counts[histogram_bucket(value_ns)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&hist->total_count, 1, __ATOMIC_RELAXED);
+
+    uint64_t max = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+    while (value_ns > max &&
+           !__atomic_compare_exchange_n(&hist->max, &max, value_ns, 1,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+uint64_t latency_histogram_percentile(const LatencyHistogram *hist, double percentile) {
+    uint64_t total = __atomic_load_n(&hist->total_count, __ATOMIC_RELAXED);
+    if (total == 0) return 0;
+
+    uint64_t rank = (uint64_t)(percentile / 100.0 * (double)total + 0.5);
+    if (rank == 0) rank = 1;
+
+    uint64_t seen = 0;
+    for (int i = 0; i < HISTOGRAM_BUCKETS; i++) {
+        seen += __atomic_load_n(&hist->counts[i], __ATOMIC_RELAXED);
+        if (seen >= rank) {
+            uint64_t upper = histogram_bucket_upper(i);
+            uint64_t max = __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+            return upper < max ? upper : max;
+        }
+    }
+    // Buckets are read after the total; a concurrent record can leave them short
+    return __atomic_load_n(&hist->max, __ATOMIC_RELAXED);
+}
+
+// ==================== SERVER COUNTERS ====================
+
+void server_stats_init(void) {
+    started_at = time(NULL);
+    stats_token = getenv("SERVER_STATS_TOKEN");
+    if (stats_token != NULL && stats_token[0] == '\0') {
+        stats_token = NULL;
+    }
+}
+
+uint64_t server_stats_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+long server_stats_uptime(void) {
+    return (long)(time(NULL) - started_at);
+}
+
+void server_stats_record_command(int command_index, uint64_t total_ns, uint64_t db_ns) {
+    if (command_index < 0 || command_index >= SERVER_STATS_MAX_COMMANDS) return;
+
+    CommandStats *stats = &command_stats[command_index];
+    if (db_ns > total_ns) db_ns = total_ns;
+    latency_histogram_record(&stats->total, total_ns);
+    latency_histogram_record(&stats->db, db_ns);
+    latency_histogram_record(&stats->other, total_ns - db_ns);
+}
+
+const CommandStats* server_stats_command(int command_index) {
+    if (command_index < 0 || command_index >= SERVER_STATS_MAX_COMMANDS) return NULL;
+    return &command_stats[command_index];
+}
+
+void server_stats_add_db_time(uint64_t ns) {
+    thread_db_time_ns += ns;
+}
+
+uint64_t server_stats_take_db_time(void) {
+    uint64_t ns = thread_db_time_ns;
+    thread_db_time_ns = 0;
+    return ns;
+}
+
+void server_stats_session_opened(void) {
+    __atomic_fetch_add(&active_sessions, 1, __ATOMIC_RELAXED);
+}
+
+void server_stats_session_closed(void) {
+    __atomic_fetch_sub(&active_sessions, 1, __ATOMIC_RELAXED);
+}
+
+int server_stats_sessions(void) {
+    return __atomic_load_n(&active_sessions, __ATOMIC_RELAXED);
+}
+
+int server_stats_authorized(const char *token) {
+    if (stats_token == NULL || token == NULL) return 0;
+
+    // Compare every byte so the reply time does not leak the matching prefix
+    size_t expected_len = strlen(stats_token);
+    size_t len = strlen(token);
+    unsigned char diff = (unsigned char)(expected_len != len);
+    for (size_t i = 0; i < expected_len; i++) {
+        unsigned char c = (i < len) ? (unsigned char)token[i] : 0;
+        diff |= (unsigned char)(c ^ (unsigned char)stats_token[i]);
+    }
+    return diff == 0;
+}
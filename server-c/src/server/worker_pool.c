@@ -0,0 +1,115 @@
+#include "worker_pool.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    WorkerPool *pool;
+    int index;
+} WorkerStart;
+
+static void* worker_thread_func(void *arg) {
+    WorkerStart start = *(WorkerStart*)arg;
+    free(arg);
+
+    WorkerPool *pool = start.pool;
+    void *ctx = pool->thread_init ? pool->thread_init(start.index) : NULL;
+
+    while (1) {
+        pthread_mutex_lock(&pool->lock);
+        while (pool->head == NULL && !pool->stopping) {
+            pthread_cond_wait(&pool->not_empty, &pool->lock);
+        }
+        if (pool->head == NULL && pool->stopping) {
+            pthread_mutex_unlock(&pool->lock);
+            break;
+        }
+
+        WorkerJob *job = pool->head;
+        pool->head = job->next;
+        if (pool->head == NULL) pool->tail = NULL;
+        pool->queued--;
+        pthread_mutex_unlock(&pool->lock);
+
+        job->fn(job->arg, ctx);
+        free(job);
+    }
+
+    if (pool->thread_exit) pool->thread_exit(ctx);
+    return NULL;
+}
+
+int worker_pool_init(WorkerPool *pool, const char *name, int threads, int capacity,
+                     worker_thread_init_fn thread_init, worker_thread_exit_fn thread_exit) {
+    memset(pool, 0, sizeof(*pool));
+    pool->name = name;
+    pool->capacity = capacity > 0 ? capacity : 1;
+    pool->thread_init = thread_init;
+    pool->thread_exit = thread_exit;
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->not_empty, NULL);
+
+    if (threads < 1) threads = 1;
+    if (threads > MAX_POOL_WORKERS) threads = MAX_POOL_WORKERS;
+
+    for (int i = 0; i < threads; i++) {
+        WorkerStart *start = (WorkerStart*)malloc(sizeof(WorkerStart));
+        if (start == NULL) break;
+        start->pool = pool;
+        start->index = i;
+        if (pthread_create(&pool->threads[i], NULL, worker_thread_func, start) != 0) {
+            free(start);
+            break;
+        }
+        pool->thread_count++;
+    }
+
+    if (pool->thread_count == 0) {
+        LOG_ERROR("[Pool] Failed to start any %s worker\n", name);
+        return -1;
+    }
+    LOG_INFO("[Pool] Started %d %s worker(s), queue capacity %d\n",
+           pool->thread_count, name, pool->capacity);
+    return 0;
+}
+
+int worker_pool_submit(WorkerPool *pool, worker_job_fn fn, void *arg) {
+    WorkerJob *job = (WorkerJob*)malloc(sizeof(WorkerJob));
+    if (job == NULL) return -1;
+    job->fn = fn;
+    job->arg = arg;
+    job->next = NULL;
+
+    pthread_mutex_lock(&pool->lock);
+    if (pool->stopping || pool->thread_count == 0 || pool->queued >= pool->capacity) {
+        pthread_mutex_unlock(&pool->lock);
+        free(job);
+        return -1;
+    }
+    if (pool->tail) {
+        pool->tail->next = job;
+    } else {
+        pool->head = job;
+    }
+    pool->tail = job;
+    pool->queued++;
+    pthread_cond_signal(&pool->not_empty);
+    pthread_mutex_unlock(&pool->lock);
+    return 0;
+}
+
+// Finish the queued jobs, then stop and join every worker
+void worker_pool_shutdown(WorkerPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->stopping = 1;
+    pthread_cond_broadcast(&pool->not_empty);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int i = 0; i < pool->thread_count; i++) {
+        pthread_join(pool->threads[i], NULL);
+    }
+    pool->thread_count = 0;
+    pthread_cond_destroy(&pool->not_empty);
+    pthread_mutex_destroy(&pool->lock);
+}
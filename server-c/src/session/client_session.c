@@ -1,11 +1,37 @@
 #include "client_session.h"
 #include "online_users.h"
 #include "history.h"
+#include "log.h"
 #include <stdlib.h>
 #include <string.h>
 #include <pthread.h>
 #include <stdio.h>
+#include <errno.h>
+#include <sys/socket.h>
 #include "game.h"
+#include "server_core.h"
+
+extern GameManager game_manager;
+
+#define OUTPUT_LOCK_STRIPES 64
+
+// Sessions by fd, so any thread can queue output for a connection. Each slot
+// and the output queue and current match of the session in it are guarded
+// by one of a set of striped locks; unregistering under the same lock keeps
+// senders from touching a session that is being freed.
+static ClientSession *session_registry[MAX_CLIENTS];
+static pthread_mutex_t output_locks[OUTPUT_LOCK_STRIPES] = {
+    [0 ... OUTPUT_LOCK_STRIPES - 1] = PTHREAD_MUTEX_INITIALIZER
+};
+
+// Pause reading past the soft limit; disconnect past the hard limit
+static size_t output_soft_limit = 64 * 1024;
+static size_t output_hard_limit = 1024 * 1024;
+static void (*output_notify)(int socket_fd) = NULL;
+
+static pthread_mutex_t* output_lock_for(int socket_fd) {
+    return &output_locks[socket_fd % OUTPUT_LOCK_STRIPES];
+}
 
 ClientSession* client_session_create(int socket_fd) {
     ClientSession *session = (ClientSession*)malloc(sizeof(ClientSession));
@@ -16,18 +42,290 @@ ClientSession* client_session_create(int socket_fd) {
     session->socket_fd = socket_fd;
     session->user_id = 0;
     memset(session->username, 0, sizeof(session->username));
-    session->current_match = NULL;
+    session->current_match_id = 0;
+    session->input.start = 0;
+    session->input.end = 0;
+    session->input.discarding = 0;
+    memset(&session->output, 0, sizeof(session->output));
+    session->shard_id = 0;
+    session->job_pending = 0;
+    session->closing = 0;
+    session->watch_events = 0;
+    session->handoff_next = NULL;
+
+    if (socket_fd >= 0 && socket_fd < MAX_CLIENTS) {
+        pthread_mutex_t *lock = output_lock_for(socket_fd);
+        pthread_mutex_lock(lock);
+        session_registry[socket_fd] = session;
+        pthread_mutex_unlock(lock);
+    }
 
     return session;
 }
 
 void client_session_destroy(ClientSession *session) {
     if (session != NULL) {
+        int fd = session->socket_fd;
+        if (fd >= 0 && fd < MAX_CLIENTS) {
+            pthread_mutex_t *lock = output_lock_for(fd);
+            pthread_mutex_lock(lock);
+            if (session_registry[fd] == session) {
+                session_registry[fd] = NULL;
+            }
+            pthread_mutex_unlock(lock);
+        }
+        free(session->output.data);
         free(session);
     }
 }
 
-void client_session_handle_disconnect(ClientSession *session) {
+struct GameMatch* client_session_acquire_match(ClientSession *session) {
+    pthread_mutex_t *lock = output_lock_for(session->socket_fd);
+    pthread_mutex_lock(lock);
+    int match_id = session->current_match_id;
+    pthread_mutex_unlock(lock);
+    return match_id > 0 ? game_manager_acquire_match(&game_manager, match_id) : NULL;
+}
+
+void client_session_set_match(ClientSession *session, struct GameMatch *match) {
+    pthread_mutex_t *lock = output_lock_for(session->socket_fd);
+    pthread_mutex_lock(lock);
+    session->current_match_id = match ? match->match_id : 0;
+    pthread_mutex_unlock(lock);
+}
+
+void client_session_set_output_limits(size_t soft_limit, size_t hard_limit) {
+    output_soft_limit = soft_limit;
+    output_hard_limit = hard_limit > soft_limit ? hard_limit : soft_limit;
+}
+
+void client_session_set_output_notify(void (*notify)(int socket_fd)) {
+    output_notify = notify;
+}
+
+// Non-blocking send; returns bytes written, 0 when the socket is full, -1 on error
+static ssize_t output_send(int socket_fd, const char *data, size_t len) {
+    ssize_t n;
+    do {
+        n = send(socket_fd, data, len, MSG_DONTWAIT | MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+
+    if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return 0;
+    }
+    return n;
+}
+
+static int output_append(OutputBuffer *out, const char *data, size_t len) {
+    if (out->capacity - out->end < len && out->start > 0) {
+        memmove(out->data, out->data + out->start, out->end - out->start);
+        out->end -= out->start;
+        out->start = 0;
+    }
+    if (out->capacity - out->end < len) {
+        size_t capacity = out->capacity ? out->capacity * 2 : 4096;
+        while (capacity - out->end < len) {
+            capacity *= 2;
+        }
+        char *data_new = (char*)realloc(out->data, capacity);
+        if (data_new == NULL) {
+            return -1;
+        }
+        out->data = data_new;
+        out->capacity = capacity;
+    }
+    memcpy(out->data + out->end, data, len);
+    out->end += len;
+    return 0;
+}
+
+// Mark the session dead and let its reactor notice the hang-up
+static void output_fail(ClientSession *session, const char *reason) {
+    session->output.failed = 1;
+    LOG_WARN("[Session] Dropping output for client %d: %s\n", session->socket_fd, reason);
+    shutdown(session->socket_fd, SHUT_RDWR);
+}
+
+// Called with the session's output lock held
+static int output_write_locked(ClientSession *session, const char *message, size_t len) {
+    OutputBuffer *out = &session->output;
+    if (out->failed) {
+        return -1;
+    }
+
+    // Keep ordering: only write directly when nothing is queued ahead of us
+    size_t sent = 0;
+    if (out->start == out->end) {
+        ssize_t n = output_send(session->socket_fd, message, len);
+        if (n < 0) {
+            output_fail(session, "send failed");
+            return -1;
+        }
+        sent = (size_t)n;
+    }
+    if (sent == len) {
+        return 0;
+    }
+
+    if (out->end - out->start + (len - sent) > output_hard_limit) {
+        output_fail(session, "output backlog over hard limit");
+        return -1;
+    }
+    int was_empty = out->start == out->end;
+    if (output_append(out, message + sent, len - sent) < 0) {
+        output_fail(session, "out of memory");
+        return -1;
+    }
+    if (was_empty && output_notify != NULL) {
+        output_notify(session->socket_fd);
+    }
+    return 0;
+}
+
+int send_to_client(int socket_fd, const char *message) {
+    if (socket_fd < 0 || socket_fd >= MAX_CLIENTS) {
+        return -1;
+    }
+
+    int result = -1;
+    pthread_mutex_t *lock = output_lock_for(socket_fd);
+    pthread_mutex_lock(lock);
+    ClientSession *session = session_registry[socket_fd];
+    if (session != NULL) {
+        result = output_write_locked(session, message, strlen(message));
+    }
+    pthread_mutex_unlock(lock);
+    return result;
+}
+
+// Write queued output once the socket is writable again (owning reactor only).
+// Returns 0 while the session is healthy, -1 once its output has failed.
+int client_session_flush_output(ClientSession *session) {
+    OutputBuffer *out = &session->output;
+    pthread_mutex_t *lock = output_lock_for(session->socket_fd);
+    pthread_mutex_lock(lock);
+
+    while (!out->failed && out->start < out->end) {
+        ssize_t n = output_send(session->socket_fd, out->data + out->start, out->end - out->start);
+        if (n < 0) {
+            output_fail(session, "send failed");
+        } else if (n == 0) {
+            break;
+        } else {
+            out->start += (size_t)n;
+        }
+    }
+
+    // Drained: give the memory back, idle sessions should not hold a queue
+    if (out->start == out->end && out->data != NULL) {
+        free(out->data);
+        out->data = NULL;
+        out->start = out->end = out->capacity = 0;
+    }
+
+    int result = out->failed ? -1 : 0;
+    pthread_mutex_unlock(lock);
+    return result;
+}
+
+size_t client_session_output_pending(ClientSession *session) {
+    pthread_mutex_t *lock = output_lock_for(session->socket_fd);
+    pthread_mutex_lock(lock);
+    size_t pending = session->output.end - session->output.start;
+    pthread_mutex_unlock(lock);
+    return pending;
+}
+
+// True when the client is not keeping up and its input should be paused
+int client_session_output_backlogged(ClientSession *session) {
+    pthread_mutex_t *lock = output_lock_for(session->socket_fd);
+    pthread_mutex_lock(lock);
+    int backlogged = session->output.end - session->output.start > output_soft_limit;
+    pthread_mutex_unlock(lock);
+    return backlogged;
+}
+
+// Receive whatever the socket has ready into the session's input buffer.
+// Returns the number of bytes read, 0 when the peer closed the connection,
+// or -1 with errno set (EAGAIN/EWOULDBLOCK once the socket is drained).
+ssize_t client_session_fill(ClientSession *session) {
+    InputBuffer *in = &session->input;
+
+    // Make room by sliding the partial line back to the front
+    if (in->end == sizeof(in->data) && in->start > 0) {
+        memmove(in->data, in->data + in->start, in->end - in->start);
+        in->end -= in->start;
+        in->start = 0;
+    }
+
+    // A single line filled the whole buffer: drop it and resync on the next newline
+    if (in->end == sizeof(in->data)) {
+        LOG_INFO("[Session] Client %d sent an over-long line, discarding\n", session->socket_fd);
+        send_to_client(session->socket_fd, "ERROR|Command too long\n");
+        in->start = 0;
+        in->end = 0;
+        in->discarding = 1;
+    }
+
+    ssize_t n;
+    do {
+        n = recv(session->socket_fd, in->data + in->end,
+                 sizeof(in->data) - in->end, MSG_DONTWAIT);
+    } while (n < 0 && errno == EINTR);
+
+    if (n > 0) {
+        in->end += (size_t)n;
+    }
+    return n;
+}
+
+// Return the next complete line (NUL-terminated in place, without "\r\n"),
+// or NULL when only a partial line is buffered. The pointer stays valid
+// until the next call to client_session_fill().
+char* client_session_next_line(ClientSession *session) {
+    InputBuffer *in = &session->input;
+
+    while (in->start < in->end) {
+        char *line = in->data + in->start;
+        char *nl = memchr(line, '\n', in->end - in->start);
+        if (nl == NULL) {
+            if (in->discarding) {
+                in->start = in->end;
+            }
+            break;
+        }
+
+        *nl = '\0';
+        in->start = (size_t)(nl - in->data) + 1;
+        if (nl > line && nl[-1] == '\r') {
+            nl[-1] = '\0';
+        }
+
+        if (in->discarding) {
+            in->discarding = 0;
+            continue;
+        }
+        if (line[0] == '\0') {
+            continue;
+        }
+        return line;
+    }
+
+    // Everything consumed: rewind so the next read starts at the front
+    if (in->start == in->end) {
+        in->start = 0;
+        in->end = 0;
+    }
+    return NULL;
+}
+
+// True when the buffer holds no free space at all (only reachable while
+// complete lines are waiting to be dispatched)
+int client_session_input_full(const ClientSession *session) {
+    return session->input.start == 0 && session->input.end == sizeof(session->input.data);
+}
+
+void client_session_handle_disconnect(ClientSession *session, PGconn *db) {
     if (!session) return;
 
     /* ===== REMOVE USER FROM ONLINE USERS ===== */
@@ -35,14 +333,13 @@ void client_session_handle_disconnect(ClientSession *session) {
         extern OnlineUsers online_users;
         online_users_remove(&online_users, session->user_id);
 
-        printf("[Session] Removed user %d (%s) from online users\n",
+        LOG_INFO("[Session] Removed user %d (%s) from online users\n",
                session->user_id, session->username);
     }
 
     /* ===== HANDLE CURRENT MATCH ===== */
-    if (session->current_match != NULL) {
-        GameMatch *match = session->current_match;
-
+    GameMatch *match = client_session_acquire_match(session);
+    if (match != NULL) {
         pthread_mutex_lock(&match->lock);
 
         int disconnected_player_id = 0;
@@ -67,8 +364,6 @@ void client_session_handle_disconnect(ClientSession *session) {
 
         /* ===== UPDATE MATCH RESULT (REMAINING PLAYER WINS) ===== */
         if (match->status == GAME_PLAYING && disconnected_player_id > 0 && remaining_player_id > 0) {
-            extern PGconn *db_conn;
-            
             // Set winner to the remaining player
             match->winner_id = remaining_player_id;
             match->result = disconnected_is_white ? RESULT_BLACK_WIN : RESULT_WHITE_WIN;
@@ -76,12 +371,12 @@ void client_session_handle_disconnect(ClientSession *session) {
             
             // Update database
             const char *result_str = disconnected_is_white ? "black_win" : "white_win";
-            history_update_match_result(db_conn, match->match_id, result_str, remaining_player_id);
+            history_update_match_result(db, match->match_id, result_str, remaining_player_id);
             
             // Update ELO: remaining player wins, disconnected player loses
-            if (db_conn != NULL) {
-                stats_update_elo(db_conn, remaining_player_id, disconnected_player_id);
-                printf("[Session] ELO updated: %d wins (+30), %d loses (-30) due to disconnect\n",
+            if (db != NULL) {
+                stats_update_elo(db, remaining_player_id, disconnected_player_id);
+                LOG_INFO("[Session] ELO updated: %d wins (+30), %d loses (-30) due to disconnect\n",
                        remaining_player_id, disconnected_player_id);
             }
             
@@ -91,21 +386,24 @@ void client_session_handle_disconnect(ClientSession *session) {
             
             int opponent_fd = disconnected_is_white ? match->black_player.socket_fd : match->white_player.socket_fd;
             if (opponent_fd > 0) {
-                send(opponent_fd, game_end_msg, strlen(game_end_msg), 0);
-                printf("[Session] Sent win notification to remaining player (fd=%d)\n", opponent_fd);
+                send_to_client(opponent_fd, game_end_msg);
+                LOG_INFO("[Session] Sent win notification to remaining player (fd=%d)\n", opponent_fd);
             }
             
-            printf("[Session] Match %d ended due to player disconnect: winner=%d, loser=%d\n",
+            LOG_INFO("[Session] Match %d ended due to player disconnect: winner=%d, loser=%d\n",
                    match->match_id, remaining_player_id, disconnected_player_id);
         } else {
             /* Abort game if not in PLAYING state or invalid players */
             match->status = GAME_ABORTED;
         }
+        // Nobody is left to receive a bot reply
+        game_match_cancel_bot_search(match);
 
         pthread_mutex_unlock(&match->lock);
+        game_match_release(match);
     }
 
-    printf("[Session] Client %d disconnected (user: %s)\n",
+    LOG_INFO("[Session] Client %d disconnected (user: %s)\n",
            session->socket_fd,
            session->user_id > 0 ? session->username : "anonymous");
 }
@@ -1,4 +1,5 @@
 #include "timer.h"
+#include "log.h"
 #include <stdlib.h>
 #include <stdio.h>
 #include <unistd.h>
@@ -91,7 +92,7 @@ GameTimer* timer_manager_create_timer(TimerManager *manager, int match_id,
 
     pthread_mutex_unlock(&manager->lock);
 
-    printf("[Timer] Created timer for match %d (%d minutes)\n", match_id, duration_minutes);
+    LOG_INFO("[Timer] Created timer for match %d (%d minutes)\n", match_id, duration_minutes);
     return timer;
 }
 
@@ -118,7 +119,7 @@ int timer_manager_stop_timer(TimerManager *manager, int match_id) {
             manager->timer_count--;
 
             pthread_mutex_unlock(&manager->lock);
-            printf("[Timer] Stopped timer for match %d\n", match_id);
+            LOG_INFO("[Timer] Stopped timer for match %d\n", match_id);
             return 1;
         }
     }
@@ -137,7 +138,7 @@ int timer_manager_pause_timer(TimerManager *manager, int match_id) {
             pthread_mutex_unlock(&manager->timers[i]->lock);
 
             pthread_mutex_unlock(&manager->lock);
-            printf("[Timer] Paused timer for match %d\n", match_id);
+            LOG_INFO("[Timer] Paused timer for match %d\n", match_id);
             return 1;
         }
     }
@@ -156,7 +157,7 @@ int timer_manager_resume_timer(TimerManager *manager, int match_id) {
             pthread_mutex_unlock(&manager->timers[i]->lock);
 
             pthread_mutex_unlock(&manager->lock);
-            printf("[Timer] Resumed timer for match %d\n", match_id);
+            LOG_INFO("[Timer] Resumed timer for match %d\n", match_id);
             return 1;
         }
     }
@@ -202,17 +203,17 @@ void timer_manager_cleanup(TimerManager *manager) {
 }
 
 void handle_start_timer(ClientSession *session, char *param1, PGconn *db) {
-    printf("handle_start_timer called (stub)\n");
+    LOG_DEBUG("handle_start_timer called (stub)\n");
 }
 void handle_stop_timer(ClientSession *session, char *param1, PGconn *db) {
-    printf("handle_stop_timer called (stub)\n");
+    LOG_DEBUG("handle_stop_timer called (stub)\n");
 }
 void handle_pause_timer(ClientSession *session, char *param1, PGconn *db) {
-    printf("handle_pause_timer called (stub)\n");
+    LOG_DEBUG("handle_pause_timer called (stub)\n");
 }
 void handle_resume_timer(ClientSession *session, char *param1, PGconn *db) {
-    printf("handle_resume_timer called (stub)\n");
+    LOG_DEBUG("handle_resume_timer called (stub)\n");
 }
 void handle_get_time(ClientSession *session, char *param1, PGconn *db) {
-    printf("handle_get_time called (stub)\n");
+    LOG_DEBUG("handle_get_time called (stub)\n");
 }
@@ -0,0 +1,233 @@
+// test_disconnect.c - Client disconnects under AddressSanitizer
+//
+// Runs the server's reactors in this process and drops clients in every way
+// a session can go away: right after the greeting, mid-line, with a
+// database job in flight, with replies still queued, with a reset, and in
+// the middle of a bot search. ASan aborts the run on any touch of a freed
+// session; afterwards the server must still greet new clients.
+//
+// No database is needed: db_connect() is wrapped to hand back a connection
+// that never reached a server, so database commands fail the way they do
+// when PostgreSQL is down.
+//
+//   make test
+#include "test_util.h"
+#include "server_core.h"
+#include "server_stats.h"
+#include "protocol_handler.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+
+PGconn* __wrap_db_connect(void) {
+    return PQconnectdb("host=/nonexistent dbname=chess_db connect_timeout=1");
+}
+
+static int next_match_id = 1000;
+
+int __wrap_db_create_bot_match(PGconn *conn, int user_id, const char *type) {
+    (void)conn; (void)user_id; (void)type;
+    return __atomic_fetch_add(&next_match_id, 1, __ATOMIC_RELAXED);
+}
+
+static void* server_thread(void *arg) {
+    (void)arg;
+    server_start();
+    return NULL;
+}
+
+static void sleep_ms(int ms) {
+    struct timespec ts = { ms / 1000, (long)(ms % 1000) * 1000000L };
+    nanosleep(&ts, NULL);
+}
+
+static int client_connect(void) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(PORT);
+    inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+
+    // The reactors may still be starting
+    for (int attempt = 0; attempt < 100; attempt++) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+            struct timeval tv = { 5, 0 };
+            setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+            return fd;
+        }
+        close(fd);
+        sleep_ms(20);
+    }
+    return -1;
+}
+
+static int read_line(int fd, char *buf, size_t size) {
+    size_t used = 0;
+    while (used + 1 < size) {
+        ssize_t n = recv(fd, buf + used, 1, 0);
+        if (n <= 0) return -1;
+        if (buf[used] == '\n') break;
+        used++;
+    }
+    buf[used] = '\0';
+    return (int)used;
+}
+
+// Read lines until one starts with prefix
+static int expect_line(int fd, const char *prefix, char *buf, size_t size) {
+    for (int i = 0; i < 32; i++) {
+        if (read_line(fd, buf, size) < 0) return -1;
+        if (strncmp(buf, prefix, strlen(prefix)) == 0) return 0;
+    }
+    return -1;
+}
+
+static void send_text(int fd, const char *text) {
+    send(fd, text, strlen(text), MSG_NOSIGNAL);
+}
+
+// Connect and consume the greeting; -1 if the server did not greet
+static int client_open(void) {
+    char line[256];
+    int fd = client_connect();
+    if (fd < 0) return -1;
+    if (expect_line(fd, "WELCOME", line, sizeof(line)) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Close with a reset instead of a FIN
+static void client_reset(int fd) {
+    struct linger lg = { 1, 0 };
+    setsockopt(fd, SOL_SOCKET, SO_LINGER, &lg, sizeof(lg));
+    close(fd);
+}
+
+static void test_close_after_greeting(void) {
+    for (int i = 0; i < 200; i++) {
+        int fd = client_open();
+        CHECK(fd >= 0, "no greeting on connection %d", i);
+        if (fd < 0) return;
+        close(fd);
+    }
+}
+
+static void test_close_mid_line(void) {
+    for (int i = 0; i < 50; i++) {
+        int fd = client_open();
+        CHECK(fd >= 0, "no greeting");
+        if (fd < 0) return;
+        send_text(fd, "MOVE|1|e2");
+        close(fd);
+    }
+}
+
+// The session is closed while a database worker still holds it, which
+// takes the deferred close path
+static void test_close_with_db_job(void) {
+    for (int i = 0; i < 50; i++) {
+        int fd = client_open();
+        CHECK(fd >= 0, "no greeting");
+        if (fd < 0) return;
+        send_text(fd, "LOGIN|someone|secret\n");
+        if (i % 2) client_reset(fd); else close(fd);
+    }
+}
+
+static void test_close_with_queued_output(void) {
+    char burst[64 * 16];
+    burst[0] = '\0';
+    for (int i = 0; i < 64; i++) strcat(burst, "SERVER_STATS\n");
+
+    for (int i = 0; i < 20; i++) {
+        int fd = client_open();
+        CHECK(fd >= 0, "no greeting");
+        if (fd < 0) return;
+        send_text(fd, burst);
+        client_reset(fd);
+    }
+}
+
+static void test_close_many_at_once(void) {
+    int fds[64];
+    int open_count = 0;
+    for (int i = 0; i < 64; i++) {
+        fds[i] = client_open();
+        if (fds[i] >= 0) open_count++;
+    }
+    CHECK(open_count == 64, "only %d of 64 clients greeted", open_count);
+    for (int i = 0; i < 64; i++) {
+        if (fds[i] >= 0) close(fds[i]);
+    }
+}
+
+// Disconnect while the engine pool searches the bot's reply
+static void test_close_during_bot_search(void) {
+    char line[512];
+    for (int i = 0; i < 10; i++) {
+        int fd = client_open();
+        CHECK(fd >= 0, "no greeting");
+        if (fd < 0) return;
+
+        send_text(fd, "MODE_BOT|1|hard\n");
+        CHECK(expect_line(fd, "BOT_MATCH_CREATED", line, sizeof(line)) == 0,
+              "no bot match: %s", line);
+        int match_id = atoi(line + strlen("BOT_MATCH_CREATED|"));
+
+        char move[64];
+        snprintf(move, sizeof(move), "BOT_MOVE|%d|e2e4|hard\n", match_id);
+        send_text(fd, move);
+        CHECK(expect_line(fd, "BOT_MOVE_ACCEPTED", line, sizeof(line)) == 0,
+              "bot move not accepted: %s", line);
+        close(fd);
+    }
+}
+
+int main(void) {
+    log_init();
+    log_runtime_level = LOG_LEVEL_ERROR;
+    game_manager_init(&game_manager);
+    protocol_init();
+    server_stats_init();
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, server_thread, NULL) != 0) {
+        fprintf(stderr, "cannot start the server thread\n");
+        return 1;
+    }
+    pthread_detach(thread);
+
+    int fd = client_open();
+    if (fd < 0) {
+        fprintf(stderr, "server did not come up on port %d\n", PORT);
+        return 1;
+    }
+    close(fd);
+
+    test_close_after_greeting();
+    test_close_mid_line();
+    test_close_with_db_job();
+    test_close_with_queued_output();
+    test_close_many_at_once();
+    test_close_during_bot_search();
+
+    // Let the reactors and workers finish the closes before the last check
+    sleep_ms(500);
+    fd = client_open();
+    CHECK(fd >= 0, "server stopped greeting clients");
+    if (fd >= 0) close(fd);
+
+    return test_report("test_disconnect");
+}
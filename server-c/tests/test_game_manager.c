@@ -0,0 +1,148 @@
+// test_game_manager.c - Match lifetime under AddressSanitizer
+//
+// A handler that has acquired a match must be able to keep using it after
+// the cleanup on shard 0 drops it from the manager; the memory goes only
+// with the last release, and sessions that were in it are in no match.
+// ASan aborts the run on any touch of a freed match.
+//
+//   make test
+#include "test_util.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+PGconn* __wrap_db_connect(void) {
+    return NULL;
+}
+
+static int next_match_id = 2000;
+
+int __wrap_db_create_bot_match(PGconn *conn, int user_id, const char *type) {
+    (void)conn; (void)user_id; (void)type;
+    return next_match_id++;
+}
+
+static GameMatch* create_match(void) {
+    Player white = {7, -1, COLOR_WHITE, 1, "someone"};
+    Player black = {0, -1, COLOR_BLACK, 1, "bot"};
+    return game_manager_create_bot_match(&game_manager, white, black, NULL, "easy");
+}
+
+static void finish(GameMatch *match, time_t ago) {
+    pthread_mutex_lock(&match->lock);
+    match->status = GAME_FINISHED;
+    match->end_time = time(NULL) - ago;
+    pthread_mutex_unlock(&match->lock);
+}
+
+static void test_acquire_unknown(void) {
+    CHECK(game_manager_acquire_match(&game_manager, 999999) == NULL,
+          "acquired a match that does not exist");
+}
+
+// The manager drops a finished match while a handler still holds it
+static void test_cleanup_keeps_pinned_match(void) {
+    GameMatch *created = create_match();
+    CHECK(created != NULL, "no match created");
+    if (created == NULL) return;
+    int match_id = created->match_id;
+
+    GameMatch *match = game_manager_acquire_match(&game_manager, match_id);
+    CHECK(match == created, "acquire returned another match");
+    if (match == NULL) return;
+
+    finish(match, 120);
+    game_manager_cleanup_finished_matches(&game_manager);
+    CHECK(game_manager_acquire_match(&game_manager, match_id) == NULL,
+          "match %d still listed after cleanup", match_id);
+
+    // Still ours: lock it and read it as a handler would
+    pthread_mutex_lock(&match->lock);
+    CHECK(match->match_id == match_id && match->status == GAME_FINISHED,
+          "pinned match changed under us");
+    pthread_mutex_unlock(&match->lock);
+    game_match_release(match);
+}
+
+static void test_cleanup_frees_unpinned_match(void) {
+    GameMatch *match = create_match();
+    CHECK(match != NULL, "no match created");
+    if (match == NULL) return;
+    int match_id = match->match_id;
+
+    // Finished too recently: kept
+    finish(match, 10);
+    game_manager_cleanup_finished_matches(&game_manager);
+    GameMatch *again = game_manager_acquire_match(&game_manager, match_id);
+    CHECK(again == match, "match %d removed before its grace period", match_id);
+    if (again == NULL) return;
+
+    finish(again, 120);
+    game_match_release(again);
+    game_manager_cleanup_finished_matches(&game_manager);
+    CHECK(game_manager_acquire_match(&game_manager, match_id) == NULL,
+          "match %d still listed after cleanup", match_id);
+}
+
+static void test_remove_with_several_pins(void) {
+    GameMatch *match = create_match();
+    CHECK(match != NULL, "no match created");
+    if (match == NULL) return;
+    int match_id = match->match_id;
+
+    GameMatch *first = game_manager_acquire_match(&game_manager, match_id);
+    GameMatch *second = game_manager_acquire_match(&game_manager, match_id);
+    game_manager_remove_match(&game_manager, match_id);
+
+    game_match_release(first);
+    CHECK(second->match_id == match_id, "match freed with a pin left");
+    game_match_release(second);
+}
+
+// A session in a finished match is out of it once cleanup drops the match
+static void test_session_outlives_match(void) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        CHECK(0, "socketpair failed");
+        return;
+    }
+    ClientSession *session = client_session_create(fds[0]);
+
+    GameMatch *match = create_match();
+    CHECK(match != NULL, "no match created");
+    if (match != NULL) {
+        client_session_set_match(session, match);
+        GameMatch *current = client_session_acquire_match(session);
+        CHECK(current == match, "session does not resolve its match");
+        game_match_release(current);
+
+        finish(match, 120);
+        game_manager_cleanup_finished_matches(&game_manager);
+        CHECK(client_session_acquire_match(session) == NULL,
+              "session still resolves a removed match");
+    }
+
+    client_session_destroy(session);
+    close(fds[0]);
+    close(fds[1]);
+}
+
+int main(void) {
+    log_init();
+    log_runtime_level = LOG_LEVEL_ERROR;
+    game_manager_init(&game_manager);
+
+    test_acquire_unknown();
+    test_cleanup_keeps_pinned_match();
+    test_cleanup_frees_unpinned_match();
+    test_remove_with_several_pins();
+    test_session_outlives_match();
+
+    CHECK(game_manager.match_count == 0, "%d matches left", game_manager.match_count);
+
+    return test_report("test_game_manager");
+}
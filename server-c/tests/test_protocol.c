@@ -0,0 +1,118 @@
+// test_protocol.c - Command line tokenizing and dispatch
+//
+// The tokenizer has to count fields the way the old sscanf parser did: an
+// empty field ends the line, so "MOVE|1||e2" has two fields, not four.
+// Commands are also run through the dispatcher on a socketpair to check
+// that a line cut short by an empty field fails the minimum field count.
+//
+//   make test
+#include "test_util.h"
+#include "protocol_handler.h"
+#include "server_stats.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+// Nothing here reaches the database
+PGconn* __wrap_db_connect(void) {
+    return NULL;
+}
+
+int __wrap_db_create_bot_match(PGconn *conn, int user_id, const char *type) {
+    (void)conn; (void)user_id; (void)type;
+    return -1;
+}
+
+// Tokenize text and compare against the expected fields (NULL-terminated)
+static void check_tokens(const char *text, const char **expected) {
+    char line[512];
+    snprintf(line, sizeof(line), "%s", text);
+
+    ProtocolArgs args;
+    int argc = protocol_tokenize(line, &args);
+
+    int want = 0;
+    while (expected[want] != NULL) want++;
+
+    CHECK(argc == want && args.argc == want, "'%s': %d fields, expected %d", text, argc, want);
+    for (int i = 0; i < want && i < argc; i++) {
+        CHECK(strcmp(args.argv[i], expected[i]) == 0 && args.len[i] == strlen(expected[i]),
+              "'%s': field %d is '%s', expected '%s'", text, i, args.argv[i], expected[i]);
+    }
+    for (int i = argc; i < PROTOCOL_MAX_ARGS; i++) {
+        CHECK(args.argv[i][0] == '\0' && args.len[i] == 0,
+              "'%s': field %d past the end is '%s'", text, i, args.argv[i]);
+    }
+}
+
+static void test_tokenize(void) {
+    check_tokens("MOVE|1|7|e2|e4", (const char*[]){ "MOVE", "1", "7", "e2", "e4", NULL });
+    check_tokens("SURRENDER", (const char*[]){ "SURRENDER", NULL });
+    check_tokens("MOVE|1||e2", (const char*[]){ "MOVE", "1", NULL });
+    check_tokens("MOVE||1|e2", (const char*[]){ "MOVE", NULL });
+    check_tokens("MOVE|e2|e4|", (const char*[]){ "MOVE", "e2", "e4", NULL });
+    check_tokens("MOVE|e2|e4||", (const char*[]){ "MOVE", "e2", "e4", NULL });
+    check_tokens("|MOVE|e2", (const char*[]){ NULL });
+    check_tokens("", (const char*[]){ NULL });
+
+    // The last slot keeps the rest of the line, separators included
+    check_tokens("A|1|2|3|4|5|6|7|8|9|10|11|12|13|14|x|y",
+                 (const char*[]){ "A", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+                                  "10", "11", "12", "13", "14", "x|y", NULL });
+}
+
+// Run one line through the dispatcher and return the first reply line
+static void dispatch(const char *text, char *reply, size_t size) {
+    int fds[2];
+    reply[0] = '\0';
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+        CHECK(0, "socketpair failed");
+        return;
+    }
+
+    ClientSession *session = client_session_create(fds[0]);
+    char line[512];
+    snprintf(line, sizeof(line), "%s", text);
+    protocol_handle_command(session, line, NULL);
+    client_session_destroy(session);
+    close(fds[0]);
+
+    ssize_t n = read(fds[1], reply, size - 1);
+    reply[n > 0 ? n : 0] = '\0';
+    char *nl = strchr(reply, '\n');
+    if (nl) *nl = '\0';
+    close(fds[1]);
+}
+
+static void test_dispatch(void) {
+    char reply[256];
+
+    // Cut short by the empty field, so below the two fields it needs
+    dispatch("JOIN_MATCHMAKING||7", reply, sizeof(reply));
+    CHECK(strcmp(reply, "ERROR|Unknown command: JOIN_MATCHMAKING") == 0,
+          "JOIN_MATCHMAKING||7 replied '%s'", reply);
+
+    dispatch("MOVE|1||e2", reply, sizeof(reply));
+    CHECK(strcmp(reply, "ERROR|Invalid MOVE command format") == 0,
+          "MOVE|1||e2 replied '%s'", reply);
+
+    dispatch("NO_SUCH_COMMAND|1", reply, sizeof(reply));
+    CHECK(strcmp(reply, "ERROR|Unknown command: NO_SUCH_COMMAND") == 0,
+          "NO_SUCH_COMMAND replied '%s'", reply);
+}
+
+int main(void) {
+    log_init();
+    log_runtime_level = LOG_LEVEL_ERROR;
+    game_manager_init(&game_manager);
+    protocol_init();
+    server_stats_init();
+
+    test_tokenize();
+    test_dispatch();
+
+    return test_report("test_protocol");
+}
@@ -0,0 +1,38 @@
+// test_util.h - Shared harness for the tests in this directory
+//
+// Each test is one translation unit linked against every server source
+// except main.c, so this header also defines the globals main.c would.
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include "game.h"
+#include <stdio.h>
+#include <libpq-fe.h>
+
+GameManager game_manager;
+PGconn *db_conn = NULL;
+
+static int failures = 0;
+
+// Record a failure and keep going, so one run reports every broken case
+#define CHECK(cond, ...) do {                               \
+    if (!(cond)) {                                          \
+        failures++;                                         \
+        fprintf(stderr, "FAIL %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__);                       \
+        fprintf(stderr, "\n");                              \
+    }                                                       \
+} while (0)
+
+// Tests are linked with -Wl,--wrap for these (TEST_WRAPS in the Makefile),
+// so every test defines them, with whatever a database would answer there
+PGconn* __wrap_db_connect(void);
+int __wrap_db_create_bot_match(PGconn *conn, int user_id, const char *type);
+
+// Print the summary line; returns the exit status for main()
+static inline int test_report(const char *name) {
+    printf("%s: %s\n", name, failures ? "FAILED" : "ok");
+    return failures ? 1 : 0;
+}
+
+#endif // TEST_UTIL_H
@@ -0,0 +1,612 @@
+// chess_loadgen.c - Load generator speaking the server's text protocol
+//
+// Opens two connections per game, optionally logs both players in, then
+// loops START_MATCH / JOIN_MATCH / random legal MOVEs until the server ends
+// the game, and starts the next one on the same connections. Legal moves are
+// picked with the server's own validator, so the local board stays in step
+// with the FEN the server sends back.
+//
+//   make loadgen
+//   ./bin/chess_loadgen -g 50 -d 30 -r 5
+#include "game.h"
+#include "server_stats.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <getopt.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#define LG_INPUT_SIZE 8192
+#define LG_OUTPUT_SIZE 2048
+#define LG_MAX_EVENTS 256
+#define LG_RETRY_NS 1000000000ULL   // Back-off after the server refuses a match
+
+typedef enum {
+    LG_CONNECTING,      // Waiting for WELCOME / LOGIN_SUCCESS on both sides
+    LG_IDLE,            // Ready to START_MATCH at next_at
+    LG_CREATING,        // START_MATCH sent by white
+    LG_JOINING,         // JOIN_MATCH sent by black
+    LG_PLAYING,
+    LG_ENDING,          // SURRENDER sent, waiting for GAME_END
+    LG_DEAD             // Connection lost or login refused
+} LoadgenState;
+
+struct LoadgenGame;
+
+typedef struct {
+    int fd;
+    int side;                       // COLOR_WHITE / COLOR_BLACK
+    int ready;
+    int user_id;
+    char username[64];
+    struct LoadgenGame *game;
+    char in[LG_INPUT_SIZE];
+    size_t in_len;
+    char out[LG_OUTPUT_SIZE];
+    size_t out_len;
+} LoadgenConn;
+
+typedef struct LoadgenGame {
+    LoadgenConn conn[2];
+    LoadgenState state;
+    ChessBoard board;
+    int match_id;
+    int plies;
+    int move_pending;               // Side to move has a MOVE scheduled at next_at
+    int ack_pending;                // Last MOVE not yet answered with MOVE_SUCCESS
+    uint64_t next_at;
+    uint64_t move_sent_at;
+    uint64_t rng;
+} LoadgenGame;
+
+typedef struct {
+    const char *host;
+    const char *port;
+    int games;
+    int duration;
+    double rate;                    // Plies per second per game, 0 = no delay
+    int max_plies;
+    const char *user_prefix;        // Log in as <prefix><n> when set
+    const char *password;
+    int user_base;                  // Synthetic user ids without login
+    unsigned seed;
+} LoadgenConfig;
+
+typedef struct {
+    uint64_t games_started;
+    uint64_t games_finished;
+    uint64_t moves;
+    uint64_t create_refused;
+    uint64_t errors;
+    uint64_t desyncs;
+    uint64_t disconnects;
+    LatencyHistogram move_e2e;      // MOVE sent until the opponent sees OPPONENT_MOVE
+    LatencyHistogram move_ack;      // MOVE sent until MOVE_SUCCESS
+} LoadgenStats;
+
+static LoadgenConfig config = {
+    .host = "127.0.0.1",
+    .port = "8888",
+    .games = 50,
+    .duration = 30,
+    .rate = 2.0,
+    .max_plies = 200,
+    .user_prefix = NULL,
+    .password = "loadgen",
+    .user_base = 900000,
+    .seed = 0,
+};
+
+static LoadgenStats stats;
+static int epoll_fd = -1;
+static uint64_t move_interval_ns = 0;
+static volatile sig_atomic_t stop_requested = 0;
+
+static void handle_sigint(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+// ==================== RANDOM LEGAL MOVES ====================
+
+static uint64_t lg_random(LoadgenGame *game) {
+    uint64_t x = game->rng;
+    x ^= x << 13;
+    x ^= x >> 7;
+    x ^= x << 17;
+    game->rng = x;
+    return x;
+}
+
+// Pick a uniformly random legal move for the side to move; returns 0 when
+// it has none. The protocol has no promotion field and the server always
+// promotes to a queen, so under-promotions are left out.
+static int pick_random_move(LoadgenGame *game, Move *chosen) {
+    MoveList list;
+    generate_legal_moves(&game->board, game->board.current_turn, &list);
+
+    int count = 0;
+    for (int i = 0; i < list.count; i++) {
+        if (list.moves[i].is_promotion && toupper(list.moves[i].promotion_piece) != 'Q') continue;
+        list.moves[count++] = list.moves[i];
+    }
+    if (count == 0) return 0;
+
+    *chosen = list.moves[lg_random(game) % (uint64_t)count];
+    return 1;
+}
+
+// Apply a move the way game_match_make_move() does on the server
+static void apply_move(ChessBoard *board, const char *from, const char *to) {
+    Move move;
+    notation_to_coords(from, &move.from_row, &move.from_col);
+    notation_to_coords(to, &move.to_row, &move.to_col);
+    move.piece = board->board[move.from_row][move.from_col];
+    move.captured_piece = board->board[move.to_row][move.to_col];
+    move.is_castling = 0;
+    move.is_en_passant = 0;
+    move.is_promotion = 0;
+    move.promotion_piece = 0;
+
+    if (validate_move(board, &move, board->current_turn)) {
+        execute_move(board, &move);
+    }
+}
+
+// ==================== CONNECTIONS ====================
+
+static int conn_flush(LoadgenConn *conn) {
+    size_t sent = 0;
+    while (sent < conn->out_len) {
+        ssize_t n = send(conn->fd, conn->out + sent, conn->out_len - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += (size_t)n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return -1;
+        }
+    }
+    memmove(conn->out, conn->out + sent, conn->out_len - sent);
+    conn->out_len -= sent;
+
+    struct epoll_event ev = {
+        .events = EPOLLIN | (conn->out_len > 0 ? EPOLLOUT : 0),
+        .data.ptr = conn,
+    };
+    epoll_ctl(epoll_fd, EPOLL_CTL_MOD, conn->fd, &ev);
+    return 0;
+}
+
+static void game_fail(LoadgenGame *game);
+
+static void conn_send(LoadgenConn *conn, const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+
+static void conn_send(LoadgenConn *conn, const char *fmt, ...) {
+    if (conn->game->state == LG_DEAD) return;
+
+    va_list ap;
+    va_start(ap, fmt);
+    int len = vsnprintf(conn->out + conn->out_len, LG_OUTPUT_SIZE - conn->out_len, fmt, ap);
+    va_end(ap);
+
+    if (len < 0 || (size_t)len >= LG_OUTPUT_SIZE - conn->out_len) {
+        // The server stopped reading; treat it like a dead connection
+        game_fail(conn->game);
+        return;
+    }
+    conn->out_len += (size_t)len;
+    if (conn_flush(conn) < 0) {
+        game_fail(conn->game);
+    }
+}
+
+static int conn_open(LoadgenConn *conn, const struct addrinfo *addr) {
+    int fd = socket(addr->ai_family, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, addr->ai_addr, addr->ai_addrlen) < 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+    conn->fd = fd;
+    struct epoll_event ev = { .events = EPOLLIN, .data.ptr = conn };
+    if (epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        close(fd);
+        conn->fd = -1;
+        return -1;
+    }
+    return 0;
+}
+
+// ==================== GAME FLOW ====================
+
+static void game_fail(LoadgenGame *game) {
+    if (game->state == LG_DEAD) return;
+    game->state = LG_DEAD;
+    stats.disconnects++;
+    for (int i = 0; i < 2; i++) {
+        if (game->conn[i].fd >= 0) {
+            epoll_ctl(epoll_fd, EPOLL_CTL_DEL, game->conn[i].fd, NULL);
+            close(game->conn[i].fd);
+            game->conn[i].fd = -1;
+        }
+    }
+}
+
+static void game_schedule_move(LoadgenGame *game, uint64_t now) {
+    game->move_pending = 1;
+    game->next_at = now + move_interval_ns;
+}
+
+static void game_surrender(LoadgenGame *game) {
+    LoadgenConn *mover = &game->conn[game->board.current_turn];
+    game->state = LG_ENDING;
+    game->move_pending = 0;
+    conn_send(mover, "SURRENDER|%d|%d\n", game->match_id, mover->user_id);
+}
+
+static void game_play_move(LoadgenGame *game, uint64_t now) {
+    game->move_pending = 0;
+    if (game->plies >= config.max_plies) {
+        game_surrender(game);
+        return;
+    }
+
+    Move move;
+    if (!pick_random_move(game, &move)) {
+        // Mate or stalemate: the server ends the game on its own
+        return;
+    }
+
+    char from[3], to[3];
+    coords_to_notation(move.from_row, move.from_col, from);
+    coords_to_notation(move.to_row, move.to_col, to);
+
+    LoadgenConn *mover = &game->conn[game->board.current_turn];
+    apply_move(&game->board, from, to);
+    game->plies++;
+    game->move_sent_at = now;
+    game->ack_pending = 1;
+    conn_send(mover, "MOVE|%d|%d|%s|%s\n", game->match_id, mover->user_id, from, to);
+}
+
+static void game_start_match(LoadgenGame *game) {
+    LoadgenConn *white = &game->conn[COLOR_WHITE];
+    LoadgenConn *black = &game->conn[COLOR_BLACK];
+    game->state = LG_CREATING;
+    conn_send(white, "START_MATCH|%d|%s|%d|%s\n",
+              white->user_id, white->username, black->user_id, black->username);
+}
+
+static void game_finished(LoadgenGame *game, uint64_t now) {
+    stats.games_finished++;
+    game->state = LG_IDLE;
+    game->move_pending = 0;
+    game->next_at = now;
+}
+
+static void conn_handle_line(LoadgenConn *conn, char *line, uint64_t now) {
+    LoadgenGame *game = conn->game;
+    LoadgenConn *other = &game->conn[!conn->side];
+
+    if (strncmp(line, "WELCOME|", 8) == 0) {
+        if (config.user_prefix != NULL) {
+            conn_send(conn, "LOGIN|%s|%s\n", conn->username, config.password);
+        } else {
+            conn->ready = 1;
+        }
+    } else if (strncmp(line, "LOGIN_SUCCESS|", 14) == 0) {
+        conn->user_id = atoi(line + 14);
+        conn->ready = 1;
+    } else if (strncmp(line, "MATCH_CREATED|", 14) == 0 && game->state == LG_CREATING) {
+        game->match_id = atoi(line + 14);
+        game->state = LG_JOINING;
+        conn_send(other, "JOIN_MATCH|%d|%d|%s\n", game->match_id, other->user_id, other->username);
+    } else if (strncmp(line, "MATCH_JOINED|", 13) == 0 && game->state == LG_JOINING) {
+        stats.games_started++;
+        chess_board_init(&game->board);
+        game->plies = 0;
+        game->ack_pending = 0;
+        game->state = LG_PLAYING;
+        game_schedule_move(game, now);
+    } else if (strncmp(line, "MOVE_SUCCESS|", 13) == 0 && game->state == LG_PLAYING) {
+        latency_histogram_record(&stats.move_ack, now - game->move_sent_at);
+        game->ack_pending = 0;
+        char *fen = strchr(line + 13, '|');
+        if (fen != NULL && strcmp(fen + 1, chess_board_get_fen(&game->board)) != 0) {
+            stats.desyncs++;
+            game_surrender(game);
+        }
+    } else if (strncmp(line, "OPPONENT_MOVE|", 14) == 0 && game->state == LG_PLAYING) {
+        latency_histogram_record(&stats.move_e2e, now - game->move_sent_at);
+        stats.moves++;
+        game_schedule_move(game, now);
+    } else if (strncmp(line, "GAME_END|", 9) == 0) {
+        if (game->state == LG_PLAYING || game->state == LG_ENDING) {
+            game_finished(game, now);
+        }
+    } else if (strncmp(line, "ERROR|", 6) == 0) {
+        switch (game->state) {
+            case LG_CONNECTING:
+                fprintf(stderr, "[Loadgen] %s refused: %s\n", conn->username, line);
+                game_fail(game);
+                break;
+            case LG_CREATING:
+            case LG_JOINING:
+            case LG_ENDING:
+                // Match table full, the join raced a cleanup, or the match
+                // is already gone; start a fresh one later
+                if (game->state == LG_ENDING) stats.errors++;
+                else stats.create_refused++;
+                game->state = LG_IDLE;
+                game->next_at = now + LG_RETRY_NS;
+                break;
+            case LG_PLAYING:
+                stats.errors++;
+                game_surrender(game);
+                break;
+            default:
+                stats.errors++;
+                break;
+        }
+    }
+    // Anything else (OPPONENT_JOINED, SURRENDER_SUCCESS, timers, chat) is ignored
+
+    if (game->state == LG_CONNECTING && conn->ready && other->ready) {
+        game->state = LG_IDLE;
+        game->next_at = now;
+    }
+}
+
+static void conn_read(LoadgenConn *conn) {
+    LoadgenGame *game = conn->game;
+    while (game->state != LG_DEAD) {
+        ssize_t n = recv(conn->fd, conn->in + conn->in_len, LG_INPUT_SIZE - 1 - conn->in_len, 0);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return;
+        if (n <= 0) {
+            game_fail(game);
+            return;
+        }
+        // Stamp each read on its own so latencies do not include the time
+        // spent handling earlier events of the same batch
+        uint64_t now = server_stats_now_ns();
+        conn->in_len += (size_t)n;
+        conn->in[conn->in_len] = '\0';
+
+        char *start = conn->in;
+        char *nl;
+        while (game->state != LG_DEAD && (nl = strchr(start, '\n')) != NULL) {
+            *nl = '\0';
+            if (nl > start && nl[-1] == '\r') nl[-1] = '\0';
+            conn_handle_line(conn, start, now);
+            start = nl + 1;
+        }
+        if (game->state == LG_DEAD) return;
+
+        conn->in_len -= (size_t)(start - conn->in);
+        memmove(conn->in, start, conn->in_len);
+        if (conn->in_len == LG_INPUT_SIZE - 1) {
+            conn->in_len = 0;       // Over-long line; drop it
+        }
+    }
+}
+
+// ==================== REPORTING ====================
+
+#define NS_TO_MS(ns) ((double)(ns) / 1000000.0)
+
+static void print_progress(double elapsed, uint64_t moves_delta, double interval, int active) {
+    printf("[%6.1fs] active=%d finished=%llu moves/s=%.0f e2e p50=%.2fms p99=%.2fms errors=%llu\n",
+           elapsed, active, (unsigned long long)stats.games_finished,
+           interval > 0 ? (double)moves_delta / interval : 0.0,
+           NS_TO_MS(latency_histogram_percentile(&stats.move_e2e, 50.0)),
+           NS_TO_MS(latency_histogram_percentile(&stats.move_e2e, 99.0)),
+           (unsigned long long)(stats.errors + stats.desyncs));
+    fflush(stdout);
+}
+
+static void print_histogram(const char *label, const LatencyHistogram *hist) {
+    printf("  %-10s n=%llu p50=%.2fms p90=%.2fms p99=%.2fms p999=%.2fms max=%.2fms\n",
+           label, (unsigned long long)hist->total_count,
+           NS_TO_MS(latency_histogram_percentile(hist, 50.0)),
+           NS_TO_MS(latency_histogram_percentile(hist, 90.0)),
+           NS_TO_MS(latency_histogram_percentile(hist, 99.0)),
+           NS_TO_MS(latency_histogram_percentile(hist, 99.9)),
+           NS_TO_MS(hist->max));
+}
+
+static void print_summary(double elapsed) {
+    printf("\n===== chess_loadgen: %d games, %.1fs =====\n", config.games, elapsed);
+    printf("  games      started=%llu finished=%llu (%.1f/s)\n",
+           (unsigned long long)stats.games_started, (unsigned long long)stats.games_finished,
+           (double)stats.games_finished / elapsed);
+    printf("  moves      %llu (%.0f/s)\n",
+           (unsigned long long)stats.moves, (double)stats.moves / elapsed);
+    print_histogram("move e2e", &stats.move_e2e);
+    print_histogram("move ack", &stats.move_ack);
+    printf("  refused    %llu match create/join\n", (unsigned long long)stats.create_refused);
+    printf("  errors     %llu (desync %llu, disconnects %llu)\n",
+           (unsigned long long)stats.errors, (unsigned long long)stats.desyncs,
+           (unsigned long long)stats.disconnects);
+}
+
+// ==================== MAIN ====================
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+            "Usage: %s [options]\n"
+            "  -H host      server host (default 127.0.0.1)\n"
+            "  -p port      server port (default 8888)\n"
+            "  -g games     concurrent games, two connections each (default 50)\n"
+            "  -d seconds   run time (default 30)\n"
+            "  -r rate      plies per second per game, 0 = as fast as possible (default 2)\n"
+            "  -m plies     surrender after this many plies (default 200)\n"
+            "  -u prefix    log in as <prefix>1..<prefix>2N (accounts must exist)\n"
+            "  -P password  password for -u (default loadgen)\n"
+            "  -b base      first synthetic user id without -u (default 900000)\n"
+            "  -s seed      random seed (default: time)\n",
+            prog);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "H:p:g:d:r:m:u:P:b:s:h")) != -1) {
+        switch (opt) {
+            case 'H': config.host = optarg; break;
+            case 'p': config.port = optarg; break;
+            case 'g': config.games = atoi(optarg); break;
+            case 'd': config.duration = atoi(optarg); break;
+            case 'r': config.rate = atof(optarg); break;
+            case 'm': config.max_plies = atoi(optarg); break;
+            case 'u': config.user_prefix = optarg; break;
+            case 'P': config.password = optarg; break;
+            case 'b': config.user_base = atoi(optarg); break;
+            case 's': config.seed = (unsigned)strtoul(optarg, NULL, 10); break;
+            default: usage(argv[0]); return opt == 'h' ? 0 : 1;
+        }
+    }
+    if (config.games <= 0 || config.duration <= 0 || config.rate < 0) {
+        usage(argv[0]);
+        return 1;
+    }
+    if (config.seed == 0) config.seed = (unsigned)time(NULL);
+    move_interval_ns = config.rate > 0 ? (uint64_t)(1e9 / config.rate) : 0;
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, handle_sigint);
+
+    struct addrinfo hints = { .ai_family = AF_UNSPEC, .ai_socktype = SOCK_STREAM };
+    struct addrinfo *addr;
+    int rc = getaddrinfo(config.host, config.port, &hints, &addr);
+    if (rc != 0) {
+        fprintf(stderr, "[Loadgen] %s:%s: %s\n", config.host, config.port, gai_strerror(rc));
+        return 1;
+    }
+
+    epoll_fd = epoll_create1(0);
+    LoadgenGame *games = calloc((size_t)config.games, sizeof(LoadgenGame));
+    if (epoll_fd < 0 || games == NULL) {
+        perror("[Loadgen] setup");
+        return 1;
+    }
+
+    int opened = 0;
+    for (int g = 0; g < config.games; g++) {
+        LoadgenGame *game = &games[g];
+        game->state = LG_CONNECTING;
+        game->rng = ((uint64_t)config.seed << 32) ^ (uint64_t)(g + 1) * 0x9E3779B97F4A7C15ULL;
+        for (int side = 0; side < 2; side++) {
+            LoadgenConn *conn = &game->conn[side];
+            int n = 2 * g + side + 1;
+            conn->fd = -1;
+            conn->side = side;
+            conn->game = game;
+            conn->user_id = config.user_base + n;
+            if (config.user_prefix != NULL) {
+                snprintf(conn->username, sizeof(conn->username), "%s%d", config.user_prefix, n);
+            } else {
+                snprintf(conn->username, sizeof(conn->username), "lg%d", conn->user_id);
+            }
+            if (conn_open(conn, addr) < 0) {
+                fprintf(stderr, "[Loadgen] connect %d failed: %s\n", n, strerror(errno));
+                game_fail(game);
+                break;
+            }
+        }
+        if (game->state != LG_DEAD) opened++;
+    }
+    freeaddrinfo(addr);
+    printf("[Loadgen] %d/%d games connected to %s:%s, %.1f plies/s each\n",
+           opened, config.games, config.host, config.port, config.rate);
+
+    uint64_t started = server_stats_now_ns();
+    uint64_t deadline = started + (uint64_t)config.duration * 1000000000ULL;
+    uint64_t next_report = started + 1000000000ULL;
+    uint64_t last_report = started, last_moves = 0;
+    struct epoll_event events[LG_MAX_EVENTS];
+
+    while (!stop_requested) {
+        uint64_t now = server_stats_now_ns();
+        if (now >= deadline) break;
+
+        // Run everything that is due and find the next wake-up
+        uint64_t wake = next_report < deadline ? next_report : deadline;
+        int active = 0;
+        for (int g = 0; g < config.games; g++) {
+            LoadgenGame *game = &games[g];
+            if (game->state == LG_PLAYING || game->state == LG_ENDING) active++;
+            // The reply to our own MOVE must be in before the next one goes
+            // out, otherwise its FEN would be compared against a later board
+            int due = (game->state == LG_IDLE) ||
+                      (game->state == LG_PLAYING && game->move_pending && !game->ack_pending);
+            if (!due) continue;
+            if (game->next_at <= now) {
+                if (game->state == LG_IDLE) {
+                    game_start_match(game);
+                } else {
+                    game_play_move(game, now);
+                }
+            } else if (game->next_at < wake) {
+                wake = game->next_at;
+            }
+        }
+
+        if (now >= next_report) {
+            double interval = (double)(now - last_report) / 1e9;
+            print_progress((double)(now - started) / 1e9, stats.moves - last_moves, interval, active);
+            last_report = now;
+            last_moves = stats.moves;
+            next_report += 1000000000ULL;
+        }
+
+        int timeout_ms = wake > now ? (int)((wake - now + 999999) / 1000000) : 0;
+        int n = epoll_wait(epoll_fd, events, LG_MAX_EVENTS, timeout_ms);
+        if (n < 0 && errno != EINTR) {
+            perror("[Loadgen] epoll_wait");
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            LoadgenConn *conn = (LoadgenConn*)events[i].data.ptr;
+            if (conn->game->state == LG_DEAD || conn->fd < 0) continue;
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                game_fail(conn->game);
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && conn_flush(conn) < 0) {
+                game_fail(conn->game);
+                continue;
+            }
+            if (events[i].events & EPOLLIN) {
+                conn_read(conn);
+            }
+        }
+    }
+
+    print_summary((double)(server_stats_now_ns() - started) / 1e9);
+
+    for (int g = 0; g < config.games; g++) {
+        for (int side = 0; side < 2; side++) {
+            if (games[g].conn[side].fd >= 0) close(games[g].conn[side].fd);
+        }
+    }
+    free(games);
+    close(epoll_fd);
+    return 0;
+}
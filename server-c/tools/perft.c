@@ -0,0 +1,281 @@
+// perft.c - Move generator correctness and speed benchmark
+//
+// Counts the leaf nodes of the legal move tree of standard test positions
+// to a fixed depth and compares them with the published values, so any
+// change to move generation, make/unmake or validation that breaks a rule
+// shows up as a wrong count. Reports nodes per second per position.
+//
+//   make perft                       # suite, single thread
+//   make perft PERFT_ARGS="-t 4"     # split root moves over 4 threads
+//   ./bin/perft -c -d -2             # cross-check the validator, shallower
+//   ./bin/perft -f "<fen>" -D 5      # one position, print the count per root move
+#include "game.h"
+#include "log.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <getopt.h>
+#include <pthread.h>
+
+#define PERFT_MAX_THREADS 64
+#define PERFT_MAX_DEPTH 6
+
+typedef struct {
+    const char *name;
+    const char *fen;
+    int depth;                                  // Default depth for the suite
+    unsigned long long nodes[PERFT_MAX_DEPTH];  // Reference count per depth 1..6
+} PerftPosition;
+
+// Reference counts from the Chess Programming Wiki "Perft Results" page
+static const PerftPosition suite[] = {
+    { "startpos", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5,
+      { 20ULL, 400ULL, 8902ULL, 197281ULL, 4865609ULL, 119060324ULL } },
+    { "kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4,
+      { 48ULL, 2039ULL, 97862ULL, 4085603ULL, 193690690ULL, 8031647685ULL } },
+    { "position3", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6,
+      { 14ULL, 191ULL, 2812ULL, 43238ULL, 674624ULL, 11030083ULL } },
+    { "position4", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5,
+      { 6ULL, 264ULL, 9467ULL, 422333ULL, 15833292ULL, 706045033ULL } },
+    { "position5", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4,
+      { 44ULL, 1486ULL, 62379ULL, 2103487ULL, 89941194ULL, 3048196529ULL } },
+    { "position6", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4,
+      { 46ULL, 2079ULL, 89890ULL, 3894594ULL, 164075551ULL, 6923051137ULL } },
+};
+
+static struct {
+    int threads;
+    int depth_delta;
+    int cross_check;
+    const char *fen;
+    int fen_depth;
+} config = { 1, 0, 0, NULL, 4 };
+
+static unsigned long long cross_check_errors = 0;
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// Replay the generator's answer through the code the server uses for
+// client moves: validate_move() must accept exactly the generated
+// from/to pairs, and the end-state checks must agree with the move count
+static void cross_check(ChessBoard *board, const MoveList *list) {
+    PlayerColor us = board->current_turn;
+    Bitboard generated[64] = { 0 };
+    for (int i = 0; i < list->count; i++) {
+        const Move *m = &list->moves[i];
+        generated[SQUARE(m->from_row, m->from_col)] |= SQUARE_BB(SQUARE(m->to_row, m->to_col));
+    }
+
+    Bitboard own = board->occupied_by[us];
+    while (own) {
+        int from = bb_pop_lsb(&own);
+        for (int to = 0; to < 64; to++) {
+            Move move;
+            memset(&move, 0, sizeof(move));
+            move.from_row = SQUARE_ROW(from);
+            move.from_col = SQUARE_COL(from);
+            move.to_row = SQUARE_ROW(to);
+            move.to_col = SQUARE_COL(to);
+            move.piece = board->board[move.from_row][move.from_col];
+            move.captured_piece = board->board[move.to_row][move.to_col];
+
+            int accepted = validate_move(board, &move, us);
+            int expected = (generated[from] & SQUARE_BB(to)) != 0;
+            if (accepted != expected) cross_check_errors++;
+        }
+    }
+
+    int in_check = is_king_in_check(board, us);
+    int mate = is_checkmate(board, us);
+    int stalemate = is_stalemate(board, us);
+    if (mate != (list->count == 0 && in_check) || stalemate != (list->count == 0 && !in_check)) {
+        cross_check_errors++;
+    }
+}
+
+static unsigned long long perft(ChessBoard *board, int depth) {
+    MoveList list;
+    generate_legal_moves(board, board->current_turn, &list);
+    if (config.cross_check) cross_check(board, &list);
+
+    // Bulk counting: the last ply only needs the number of legal moves
+    if (depth == 1) return list.count;
+
+    unsigned long long nodes = 0;
+    for (int i = 0; i < list.count; i++) {
+        MoveUndo undo;
+        make_move(board, &list.moves[i], &undo);
+        nodes += perft(board, depth - 1);
+        unmake_move(board, &list.moves[i], &undo);
+    }
+    return nodes;
+}
+
+// Root split: threads take root moves off a shared counter
+typedef struct {
+    const ChessBoard *root;
+    const MoveList *moves;
+    int depth;
+    int next;
+    unsigned long long *counts;
+    pthread_mutex_t lock;
+} RootSplit;
+
+static void* root_worker(void *arg) {
+    RootSplit *split = arg;
+    ChessBoard board = *split->root;
+
+    for (;;) {
+        pthread_mutex_lock(&split->lock);
+        int i = split->next++;
+        pthread_mutex_unlock(&split->lock);
+        if (i >= split->moves->count) break;
+
+        MoveUndo undo;
+        make_move(&board, &split->moves->moves[i], &undo);
+        split->counts[i] = (split->depth > 1) ? perft(&board, split->depth - 1) : 1;
+        unmake_move(&board, &split->moves->moves[i], &undo);
+    }
+    return NULL;
+}
+
+// Count to depth with the root moves spread over config.threads threads;
+// counts[i] receives the subtree size of root move i
+static unsigned long long perft_root(ChessBoard *board, int depth, MoveList *moves,
+                                     unsigned long long *counts) {
+    generate_legal_moves(board, board->current_turn, moves);
+    if (config.cross_check) cross_check(board, moves);
+
+    RootSplit split = { board, moves, depth, 0, counts, PTHREAD_MUTEX_INITIALIZER };
+    pthread_t threads[PERFT_MAX_THREADS];
+    int started = 0;
+    for (int t = 1; t < config.threads; t++) {
+        if (pthread_create(&threads[started], NULL, root_worker, &split) == 0) started++;
+    }
+    root_worker(&split);
+    for (int t = 0; t < started; t++) pthread_join(threads[t], NULL);
+
+    unsigned long long total = 0;
+    for (int i = 0; i < moves->count; i++) total += counts[i];
+    return total;
+}
+
+static void move_to_uci(const Move *move, char *out) {
+    coords_to_notation(move->from_row, move->from_col, out);
+    coords_to_notation(move->to_row, move->to_col, out + 2);
+    if (move->is_promotion) {
+        out[4] = (char)(move->promotion_piece | 0x20);
+        out[5] = '\0';
+    }
+}
+
+static int run_fen(void) {
+    ChessBoard board;
+    if (chess_board_from_fen(&board, config.fen) != 0) {
+        fprintf(stderr, "perft: invalid FEN: %s\n", config.fen);
+        return 1;
+    }
+
+    MoveList moves;
+    unsigned long long counts[MAX_MOVES];
+    double start = now_seconds();
+    unsigned long long nodes = perft_root(&board, config.fen_depth, &moves, counts);
+    double elapsed = now_seconds() - start;
+
+    for (int i = 0; i < moves.count; i++) {
+        char uci[8];
+        move_to_uci(&moves.moves[i], uci);
+        printf("%-6s %llu\n", uci, counts[i]);
+    }
+    printf("\nnodes %llu  depth %d  %.3fs  %.2f Mnps\n",
+           nodes, config.fen_depth, elapsed, elapsed > 0 ? nodes / elapsed / 1e6 : 0.0);
+    return 0;
+}
+
+static int run_suite(void) {
+    int failures = 0;
+    unsigned long long total_nodes = 0;
+    double total_time = 0;
+
+    printf("%-10s %5s %12s %9s %9s  %s\n", "position", "depth", "nodes", "time", "Mnps", "result");
+    for (size_t p = 0; p < sizeof(suite) / sizeof(suite[0]); p++) {
+        int depth = suite[p].depth + config.depth_delta;
+        if (depth < 1) depth = 1;
+        if (depth > PERFT_MAX_DEPTH) depth = PERFT_MAX_DEPTH;
+        unsigned long long expected = suite[p].nodes[depth - 1];
+
+        ChessBoard board;
+        if (chess_board_from_fen(&board, suite[p].fen) != 0) {
+            printf("%-10s invalid FEN\n", suite[p].name);
+            failures++;
+            continue;
+        }
+
+        MoveList moves;
+        unsigned long long counts[MAX_MOVES];
+        double start = now_seconds();
+        unsigned long long nodes = perft_root(&board, depth, &moves, counts);
+        double elapsed = now_seconds() - start;
+
+        int ok = (nodes == expected);
+        if (!ok) failures++;
+        total_nodes += nodes;
+        total_time += elapsed;
+        printf("%-10s %5d %12llu %8.3fs %9.2f  %s", suite[p].name, depth, nodes, elapsed,
+               elapsed > 0 ? nodes / elapsed / 1e6 : 0.0, ok ? "ok" : "FAIL");
+        if (!ok) printf(" (expected %llu)", expected);
+        printf("\n");
+    }
+
+    printf("\ntotal %llu nodes in %.3fs, %.2f Mnps, %d thread%s, sliders: %s\n",
+           total_nodes, total_time, total_time > 0 ? total_nodes / total_time / 1e6 : 0.0,
+           config.threads, config.threads == 1 ? "" : "s", bitboard_slider_backend());
+    if (config.cross_check) {
+        printf("cross-check: %llu disagreement%s\n", cross_check_errors,
+               cross_check_errors == 1 ? "" : "s");
+        if (cross_check_errors > 0) failures++;
+    }
+    return failures > 0;
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr,
+        "Usage: %s [options]\n"
+        "  -t N      threads for the root split (default 1)\n"
+        "  -d N      add N to every suite depth, e.g. -d -2 for a quick run\n"
+        "  -c        also check validate_move() and the checkmate/stalemate\n"
+        "            tests against the generator at every node (slow)\n"
+        "  -f FEN    count one position instead of the suite, per root move\n"
+        "  -D N      depth for -f (default 4)\n",
+        prog);
+}
+
+int main(int argc, char *argv[]) {
+    int opt;
+    while ((opt = getopt(argc, argv, "t:d:cf:D:h")) != -1) {
+        switch (opt) {
+            case 't': config.threads = atoi(optarg); break;
+            case 'd': config.depth_delta = atoi(optarg); break;
+            case 'c': config.cross_check = 1; break;
+            case 'f': config.fen = optarg; break;
+            case 'D': config.fen_depth = atoi(optarg); break;
+            default: usage(argv[0]); return 2;
+        }
+    }
+    if (config.threads < 1) config.threads = 1;
+    if (config.threads > PERFT_MAX_THREADS) config.threads = PERFT_MAX_THREADS;
+    if (config.fen_depth < 1) config.fen_depth = 1;
+    // The cross-check counter is not shared safely between threads
+    if (config.cross_check) config.threads = 1;
+
+    bitboard_init();
+    zobrist_init();
+    log_runtime_level = LOG_LEVEL_WARN;
+
+    return config.fen ? run_fen() : run_suite();
+}